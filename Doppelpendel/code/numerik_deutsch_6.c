@@ -1,5 +1,9 @@
 /* Christopher Deutsch */
-/* gcc -o numerik_6 -O2 numerik_deutsch_ode_solver.c numerik_deutsch_fft.c numerik_deutsch_6.c -lm */
+/* gcc -o numerik_6 -O2 numerik_deutsch_ode_solver.c numerik_deutsch_fft.c numerik_deutsch_trajectory.c numerik_deutsch_spectrogram.c numerik_deutsch_pendulum.c numerik_deutsch_6.c -lm */
+/* Ensemble-Integration parallel und vektorisiert (optional, -fno-builtin
+ * verhindert das Zusammenfassen von sin/cos zu sincos, das nicht vektorisiert
+ * werden kann):
+ * gcc -o numerik_6 -O3 -march=native -ffast-math -fno-builtin -fopenmp numerik_deutsch_ode_solver.c numerik_deutsch_fft.c numerik_deutsch_trajectory.c numerik_deutsch_spectrogram.c numerik_deutsch_pendulum.c numerik_deutsch_6.c -lm */
 
 /* Verwendung: Ausfuehrliche Erklaerung, wenn das Programm ohne Argumente aufgerufen wird */
 
@@ -7,37 +11,297 @@
 #include <stdlib.h>
 #include <math.h>
 #include <complex.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
 #include "numerik_deutsch_ode_solver.h"
 #include "numerik_deutsch_fft.h"
+#include "numerik_deutsch_trajectory.h"
+#include "numerik_deutsch_spectrogram.h"
+#include "numerik_deutsch_pendulum.h"
 
-/* Funktionsargumente:
- * theta_1 = y[0], omega_1 = y[1]
- * theta_2 = y[2], omega_2 = y[3]
- * Parameter:
- * g = params[0], mu = params[1], L_1 = params[2], L_2 = params[3] */
-double d_theta_1(double t, double *y, double *params);
-double d_omega_1(double t, double *y, double *params);
-double d_theta_2(double t, double *y, double *params);
-double d_omega_2(double t, double *y, double *params);
-
-/* Speichert die Loesung in der Datei "filename" und berechnet die verallgemei-
- * nerten Impulse der Koordinaten sowie die kartesischen Koordinaten fuer die
- * Punktmassen */
-void save_ode_solution(ODE_SOLUTION *solution, double m1, double m2,
-                       double L1, double L2, char *filename);
+/* Hamiltonsche Formulierung des Doppelpendels fuer die symplektischen
+ * Verfahren: q = (theta_1, theta_2), p = (p_1, p_2) (verallgemeinerte Impulse)
+ * Parameter (double-Array):
+ * g = params[0], m_1 = params[1], m_2 = params[2], L_1 = params[3],
+ * L_2 = params[4] */
+void double_pendulum_dH_dq(const double *q, const double *p, double *dHdq,
+                           void *params);
+void double_pendulum_dH_dp(const double *q, const double *p, double *dHdp,
+                           void *params);
+
+/* Bildet den Zustand (theta_1, theta_2, p_1, p_2) auf die Argumente der
+ * rechten Seite (theta_1, omega_1, theta_2, omega_2) ab, damit die Beobachter
+ * unabhaengig vom Verfahren dieselben Werte erhalten */
+void double_pendulum_output(const double *y, double *out, void *params);
+
+/* Verallgemeinerte Impulse p_1, p_2 zum Zustand y = (theta_1, omega_1,
+ * theta_2, omega_2) */
+void double_pendulum_momenta(const double *y, double m1, double m2,
+                             double L1, double L2, double *p1, double *p2);
+
+/* Ueberwacht Energie und Gesamtdrehimpuls p_1 + p_2 (erhalten nur fuer g = 0)
+ * waehrend der Integration (Beobachter des Loesers) und speichert die
+ * groessten Abweichungen von den Anfangswerten */
+typedef struct {
+  double g, m1, m2, L1, L2;
+  
+  long count;
+  double energy_0, momentum_0;
+  double energy_drift, momentum_drift;
+} ENERGY_MONITOR;
+
+int energy_monitor_observe(double t, const double *y, int dimension,
+                           void *data);
+
+/* Ereignisfunktionen (vgl. ODE_EVENT, ohne Parameter):
+ * poincare_event: sin(theta_1), steigende Nulldurchgaenge liegen bei
+ *                 theta_1 = 0 (mod 2 pi) mit omega_1 > 0 und bei
+ *                 theta_1 = pi (mod 2 pi) mit omega_1 < 0
+ * flip_event: pi - max(|theta_1|, |theta_2|), faellt beim ersten Ueberschlag
+ *             eines der beiden Pendel durch Null */
+double poincare_event(double t, const double *y, void *params);
+double flip_event(double t, const double *y, void *params);
+
+/* Schreibt die Punkte des Poincare-Schnitts theta_1 = 0 mit omega_1 > 0 mit
+ * "solution_writer_observe" in die Datei ("data" ist der SOLUTION_WRITER) */
+int poincare_observe(double t, const double *y, int dimension, void *data);
+
+/* Speichert den Zeitpunkt des Ueberschlags ("data" ist ein double) */
+int flip_observe(double t, const double *y, int dimension, void *data);
+
+/* Liest die Anfangsbedingungen (je Zeile theta1 omega1 theta2 omega2) aus der
+ * Datei "infile", entwickelt alle Pendel gemeinsam ueber die Zeit "t" in
+ * Schritten von "h" und speichert Anfangs- und Endzustaende in "outfile".
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Fehler (Datei oder Speicher) */
+int solve_ensemble(ODE_SYSTEM *system, double t, double h,
+                   char *infile, char *outfile);
+
+/* Anzahl der Loesungspunkte, die der SOLUTION_WRITER sammelt, bevor die
+ * abgeleiteten Groessen berechnet und die Zeilen geschrieben werden */
+#define SOLUTION_BLOCK 256
+
+/* Ausgabe der Loesung waehrend der Integration (Beobachter des Loesers). Zu
+ * jedem Loesungspunkt werden die verallgemeinerten Impulse der Koordinaten
+ * sowie die kartesischen Koordinaten fuer die Punktmassen berechnet und als
+ * Zeile in die Datei geschrieben. Die Punkte werden blockweise gesammelt
+ * (rows: Zeilen t, theta_1, omega_1, theta_2, omega_2 im "structure of
+ * arrays"-Layout), damit "double_pendulum_derived" fuer den ganzen Block
+ * vektorisiert gerechnet werden kann. Die Datei erhaelt einen grossen Puffer,
+ * damit nicht fuer jede Zeile geschrieben werden muss. */
+typedef struct {
+  FILE *file;
+  char *buffer;
+  double params[4];
+  
+  int count;
+  double rows[5 * SOLUTION_BLOCK];
+  double derived[6 * SOLUTION_BLOCK];
+} SOLUTION_WRITER;
+
+/* Oeffnet die Datei "filename" und schreibt den Tabellenkopf. Ist "offset"
+ * nicht negativ, wird stattdessen die bestehende Datei auf "offset" Bytes
+ * gekuerzt und fortgesetzt (Fortsetzen nach einem Checkpoint).
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Datei konnte nicht erstellt werden */
+int solution_writer_open(SOLUTION_WRITER *writer, char *filename,
+                         double m1, double m2, double L1, double L2,
+                         long offset);
+
+/* Nimmt den Loesungspunkt (t, y) in den Block auf ("data" ist der Writer);
+ * ist der Block voll, werden seine Zeilen geschrieben */
+int solution_writer_observe(double t, const double *y, int dimension,
+                            void *data);
+
+/* Berechnet die abgeleiteten Groessen der gesammelten Punkte und schreibt sie
+ * als Zeilen in die Datei (vor Checkpoints und beim Schliessen) */
+void solution_writer_flush(SOLUTION_WRITER *writer);
+
+/* Schreibt die restlichen Zeilen und den Puffer und schliesst die Datei */
+void solution_writer_close(SOLUTION_WRITER *writer);
+
+/* Sammelt die ersten n Werte von theta1 und theta2 als f[j] = theta1 + I theta2
+ * fuer die gemeinsame FFT beider reeller Signale (Beobachter des Loesers) */
+typedef struct {
+  int n;
+  int index;
+  double complex *f;
+} FFT_SAMPLES;
+
+int fft_samples_observe(double t, const double *y, int dimension, void *data);
 
 /* Berechnet das Leistungsspektrum der DFT (Betraege der Fourierkoeffizienten)
- * und die zu jedem Koeffizienten korrespondierende Kreisfrequenz */
-void save_power_spectrum(int n, double delta,
-                         double complex *f1, double complex *f2,
+ * und die zu jedem Koeffizienten korrespondierende Kreisfrequenz. "f" ist das
+ * Ergebnis von "fft_real_pair_execute" fuer theta1 und theta2, gespeichert
+ * werden die nicht redundanten Koeffizienten k = 0, ..., n/2. */
+void save_power_spectrum(int n, double delta, double complex *f,
                          char *filename);
 
+/* Wie "save_power_spectrum", aber im Binaerformat (TRAJ_SPECTRUM) */
+void save_power_spectrum_binary(int n, double delta, double complex *f,
+                                char *filename);
+
+/* Speichert die gemittelten Periodogramme der Welch-Analyse "spec" von theta1
+ * und theta2 (k = 0, ..., window/2) mit den zugehoerigen Kreisfrequenzen.
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Fehler (Datei oder Speicher) */
+int save_welch_spectrum(SPECTROGRAM *spec, char *filename);
+
+/* Checkpoints (Option -x) in der Datei CHECKPOINT_FILE: Dateikopf
+ * CHECKPOINT_HEADER, danach der Zustand des Loesers (y und bei Dormand-Prince
+ * f(t, y), vgl. ODE_STATE) und der Zustand der Spektralanalyse. Die Datei
+ * wird unter einem temporaeren Namen geschrieben und erst danach umbenannt,
+ * sodass bei einem Abbruch waehrend des Schreibens der vorige Checkpoint
+ * erhalten bleibt.
+ * Die Werte fuer die FFT der gesamten Trajektorie werden nur einmal an
+ * CHECKPOINT_SAMPLES_FILE angehaengt (wie die Ausgabedateien); beim
+ * Fortsetzen wird diese Datei auf die im Kopf gespeicherte Anzahl gekuerzt. */
+#define CHECKPOINT_FILE "numerik_deutsch_checkpoint.bin"
+#define CHECKPOINT_SAMPLES_FILE "numerik_deutsch_checkpoint_samples.bin"
+#define CHECKPOINT_MAGIC "NUMCKPT2"
+
+/* Einstellungen, die beim Fortsetzen mit denen der unterbrochenen Rechnung
+ * uebereinstimmen muessen (nur t darf sich aendern). Die Felder enthalten
+ * keine Fuellbytes und werden mit memcmp verglichen. */
+typedef struct {
+  double h, tol;
+  double y0[4];
+  double g, m1, m2, L1, L2;
+  int32_t method, every;
+  int32_t window, mode;
+  int32_t binary, poincare;
+  int32_t flip, reserved;
+} CHECKPOINT_SETTINGS;
+
+/* Dateikopf: Einstellungen, Zustand des Loesers und der Beobachter
+ * output, poincare_output: Laenge der Textdateien bzw. Anzahl der Zeilen der
+ *                          Binaerdatei
+ * samples: Anzahl der Werte fuer die FFT (in CHECKPOINT_SAMPLES_FILE) */
+typedef struct {
+  char magic[8];
+  CHECKPOINT_SETTINGS settings;
+  
+  int32_t dimension, reserved;
+  int64_t step;
+  double t, h;
+  int64_t stats[3];
+  
+  int64_t output, poincare_output, samples;
+  double flip_time;
+  ENERGY_MONITOR monitor;
+} CHECKPOINT_HEADER;
+
+/* Daten fuer "checkpoint_save": Kopf (mit den Einstellungen) und die
+ * Beobachter, deren Zustand gespeichert wird (nicht verwendete NULL)
+ * samples_file: CHECKPOINT_SAMPLES_FILE, die ersten "samples_written" Werte
+ *               sind bereits geschrieben */
+typedef struct {
+  CHECKPOINT_HEADER header;
+  
+  SOLUTION_WRITER *writer;
+  TRAJECTORY *traj;
+  FFT_SAMPLES *samples;
+  FILE *samples_file;
+  long samples_written;
+  SPECTROGRAM *spec;
+  ENERGY_MONITOR *monitor;
+  SOLUTION_WRITER *poincare_writer;
+  double *flip_time;
+} CHECKPOINT;
+
+/* Schreibt einen Checkpoint (vgl. ODE_CHECKPOINT, "data" ist der CHECKPOINT) */
+int checkpoint_save(const ODE_STATE *state, void *data);
+
+/* Liest Kopf und Zustand des Loesers aus CHECKPOINT_FILE und vergleicht die
+ * Einstellungen mit "header->settings". "state->y" und "state->dydt" muessen
+ * Platz fuer 4 Werte bieten. Zurueckgegeben wird die geoeffnete Datei (danach
+ * folgt der Zustand der Spektralanalyse), bei Fehlern NULL. */
+FILE *checkpoint_load(CHECKPOINT_HEADER *header, ODE_STATE *state);
+
+/* Oeffnet CHECKPOINT_SAMPLES_FILE: neu (count < 0) oder zum Fortsetzen, dann
+ * werden die ersten "count" Werte nach "f" gelesen und die Datei dahinter
+ * gekuerzt. Bei Fehlern wird NULL zurueckgegeben. */
+FILE *checkpoint_samples_open(double complex *f, long count);
+
+/* Wandelt eine Binaerdatei (TRAJ_PENDULUM oder TRAJ_SPECTRUM) in die Text-
+ * tabelle um, die ohne Option -b geschrieben worden waere. Die Endung ".bin"
+ * wird dabei durch ".txt" ersetzt. Karten (TRAJ_MAP, numerik_deutsch_map.c)
+ * werden zeilenweise mit Leerzeilen dazwischen ausgegeben (gnuplot "splot").
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Fehler */
+int convert_binary(char *filename);
+
 int main(int argc, char **argv) {
   int i;
   
   /* Zaehlt die eingelesenen Argumente */
   int input_cnt;
   
+  /* Programmname und Index des ersten Arguments nach den Optionen */
+  char *prog = argv[0];
+  int opt;
+  
+  /* Toleranz des adaptiven Verfahrens (0: RK4 mit fester Schrittweite) */
+  double tol = 0;
+  RKDP45_STATS stats;
+  
+  /* Symplektisches Verfahren (-1: RK4 bzw. Dormand-Prince) */
+  int method = -1;
+  HAMILTONIAN_SYSTEM hamiltonian;
+  double hamiltonian_params[5];
+  double hamiltonian_y0[4];
+  SYMPLECTIC_STATS symplectic_stats;
+  ENERGY_MONITOR monitor;
+  
+  /* Datei mit Anfangsbedingungen eines Ensembles (NULL: einzelnes Pendel) und
+   * Anzahl der Anfangswerte unter den Programmargumenten */
+  char *ensemble = NULL;
+  int y0_cnt;
+  
+  /* Nur jeder "every"-te Loesungspunkt wird in die Datei geschrieben */
+  int every = 1;
+  
+  /* Fensterlaenge der Welch- bzw. Kurzzeit-FFT-Analyse waehrend der
+   * Integration (0: FFT der gesamten Trajektorie) */
+  int window = 0;
+  SPECTROGRAM_MODE mode = SPECTROGRAM_WELCH;
+  SPECTROGRAM *spec = NULL;
+  
+  /* Ereignisse: Poincare-Schnitt theta1 = 0 und Abbruch beim Ueberschlag */
+  int poincare = 0, flip = 0;
+  ODE_EVENT events[2];
+  SOLUTION_WRITER poincare_writer;
+  double flip_time = -1;
+  
+  /* Checkpoints alle "checkpoint_every" Schritte (0: keine) bzw. Fortsetzen
+   * einer unterbrochenen Rechnung */
+  long checkpoint_every = 0;
+  int resume = 0;
+  CHECKPOINT checkpoint;
+  ODE_CHECKPOINT solver_checkpoint;
+  ODE_STATE state;
+  double state_y[4], state_dydt[4];
+  FILE *checkpoint_file = NULL;
+  
+  /* Binaere Ausgabe bzw. umzuwandelnde Binaerdatei */
+  int binary = 0;
+  char *convert = NULL;
+  
+  /* Ausgabe waehrend der Integration */
+  SOLUTION_WRITER writer;
+  TRAJECTORY *traj = NULL;
+  double traj_params[6];
+  FFT_SAMPLES samples;
+  ODE_OBSERVER observers[3];
+  int ret;
+  
   /* physikalische Parameter (Default-Werte) */
   double g = 9.81;
   double m1 = 1.0;
@@ -50,37 +314,148 @@ int main(int argc, char **argv) {
   double h;
   
   /* FFT-Variablen */
-  int n, r;
-  double complex *f1, *f2;
+  int n;
+  double complex *f;
+  FFT_PLAN *plan;
   
   /* Anfangswert des DGL-Sys. */
   double y0[4];
   
   /* DGL-Sys. definieren: */
-  ODE_SOLUTION *solution;
   ODE_SYSTEM system;
-  ODE eqns[4];
   double params[4];
   
-  eqns[0].dydt = d_theta_1;
-  eqns[1].dydt = d_omega_1;
-  eqns[2].dydt = d_theta_2;
-  eqns[3].dydt = d_omega_2;
-  
-  system.eqns = eqns;
+  system.eqns = NULL;
   system.dimension = 4;
+  system.rhs = double_pendulum;
+  system.rhs_batch = double_pendulum_batch;
+  system.params = params;
+  system.events = events;
+  system.event_count = 0;
   
-  /* Parameter in den DGLn setzen */
-  for (i = 0; i < 4; i++) {
-    eqns[i].params = params;
+  /* Optionen einlesen, diese stehen vor den Programmargumenten (negative
+   * Zahlen als Anfangswerte werden nicht als Option interpretiert) */
+  opt = 1;
+  while (opt < argc && argv[opt][0] == '-' &&
+         (isalpha((unsigned char)argv[opt][1]) ||
+          strcmp(argv[opt], "--resume") == 0)) {
+    if (strcmp(argv[opt], "-a") == 0 && opt + 1 < argc &&
+        sscanf(argv[opt+1], "%lf", &tol) == 1 && tol > 0) {
+      opt += 2;
+    } else if (strcmp(argv[opt], "-m") == 0 && opt + 1 < argc) {
+      if (strcmp(argv[opt+1], "verlet") == 0) {
+        method = SYMPLECTIC_VERLET;
+      } else if (strcmp(argv[opt+1], "yoshida4") == 0) {
+        method = SYMPLECTIC_YOSHIDA4;
+      } else if (strcmp(argv[opt+1], "yoshida6") == 0) {
+        method = SYMPLECTIC_YOSHIDA6;
+      } else if (strcmp(argv[opt+1], "midpoint") == 0) {
+        method = SYMPLECTIC_MIDPOINT;
+      } else {
+        printf("Unbekanntes Verfahren %s\n", argv[opt+1]);
+        return -1;
+      }
+      opt += 2;
+    } else if (strcmp(argv[opt], "-k") == 0 && opt + 1 < argc &&
+               sscanf(argv[opt+1], "%i", &every) == 1 && every > 0) {
+      opt += 2;
+    } else if ((strcmp(argv[opt], "-w") == 0 || strcmp(argv[opt], "-s") == 0)
+               && opt + 1 < argc &&
+               sscanf(argv[opt+1], "%i", &window) == 1 && window >= 2) {
+      mode = (argv[opt][1] == 'w') ? SPECTROGRAM_WELCH : SPECTROGRAM_STFT;
+      opt += 2;
+    } else if (strcmp(argv[opt], "-p") == 0) {
+      poincare = 1;
+      opt += 1;
+    } else if (strcmp(argv[opt], "-f") == 0) {
+      flip = 1;
+      opt += 1;
+    } else if (strcmp(argv[opt], "-x") == 0 && opt + 1 < argc &&
+               sscanf(argv[opt+1], "%li", &checkpoint_every) == 1 &&
+               checkpoint_every > 0) {
+      opt += 2;
+    } else if (strcmp(argv[opt], "--resume") == 0) {
+      resume = 1;
+      opt += 1;
+    } else if (strcmp(argv[opt], "-b") == 0) {
+      binary = 1;
+      opt += 1;
+    } else if (strcmp(argv[opt], "-c") == 0 && opt + 1 < argc) {
+      convert = argv[opt+1];
+      opt += 2;
+    } else if (strcmp(argv[opt], "-e") == 0 && opt + 1 < argc) {
+      ensemble = argv[opt+1];
+      opt += 2;
+    } else {
+      printf("Unbekannte oder unvollstaendige Option %s\n", argv[opt]);
+      return -1;
+    }
+  }
+  if (tol > 0 && method >= 0) {
+    printf("Die Optionen -a und -m schliessen sich aus\n");
+    return -1;
+  }
+  if (method >= 0 && (poincare || flip)) {
+    printf("Ereignisse (-p, -f) werden nur mit RK4 und -a unterstuetzt\n");
+    return -1;
+  }
+  if (ensemble != NULL && (checkpoint_every > 0 || resume)) {
+    printf("Checkpoints (-x, --resume) werden fuer Ensembles nicht "
+           "unterstuetzt\n");
+    return -1;
   }
   
+  /* Die Programmargumente werden danach wie ohne Optionen ab argv[1] gelesen */
+  argc -= opt - 1;
+  argv += opt - 1;
+  
+  /* Umwandeln einer Binaerdatei benoetigt keine weiteren Argumente */
+  if (convert != NULL) {
+    if (argc != 1) {
+      printf("Die Option -c erwartet keine weiteren Argumente\n");
+      return -1;
+    }
+    return convert_binary(convert);
+  }
+  
+  /* Im Ensemble-Modus stehen die Anfangswerte in der Datei */
+  y0_cnt = (ensemble == NULL) ? 4 : 0;
+  
   /* Programmargumente einlesen und verarbeiten */
   input_cnt = 0;
-  if ((argc != 7) && (argc != 12)) {
+  if ((argc != 3 + y0_cnt) && (argc != 8 + y0_cnt)) {
     printf("Benutzung:\n"
-           "%s t h theta1 omega1 theta2 omega2 (g m1 m2 L1 L2)\n\n"
-           "Die Klammer enthaelt optionale Argumente\n"
+           "%s [-a tol | -m verfahren] [-k every] [-w n | -s n] [-p] [-f] [-x n] [--resume] [-b] t h theta1 omega1 theta2 omega2 (g m1 m2 L1 L2)\n"
+           "%s -e datei t h (g m1 m2 L1 L2)\n"
+           "%s -c datei\n\n"
+           "Die Klammern enthalten optionale Argumente\n"
+           "-a tol: adaptives Dormand-Prince-Verfahren mit der (absoluten und\n"
+           "        relativen) Toleranz tol statt RK4, h ist dann der Abstand\n"
+           "        der ausgegebenen Punkte\n"
+           "-m verfahren: symplektisches Verfahren mit fester Schrittweite h statt\n"
+           "              RK4 (verlet, yoshida4, yoshida6 oder midpoint)\n"
+           "-k every: nur jeden every-ten Loesungspunkt in die Datei schreiben\n"
+           "-w n: statt der FFT der gesamten Trajektorie waehrend der Integration\n"
+           "      gemitteltes Spektrum nach Welch (Hann-Fenster der Laenge n,\n"
+           "      50%% Ueberlappung) in \"numerik_deutsch_welch.txt\" speichern\n"
+           "-s n: wie -w, aber das Spektrum jedes Fensters (Zeit-Frequenz-Matrix)\n"
+           "      in \"numerik_deutsch_spectrogram.txt\" speichern\n"
+           "-p: Poincare-Schnitt theta1 = 0 mit omega1 > 0 (zwischen den Zeit-\n"
+           "    schritten interpoliert) in \"numerik_deutsch_poincare.txt\"\n"
+           "    speichern\n"
+           "-f: Integration beim ersten Ueberschlag eines Pendels beenden\n"
+           "-x n: alle n Schritte (mit -a: Ausgabepunkte) und am Ende einen\n"
+           "      Checkpoint in \"numerik_deutsch_checkpoint.bin\" speichern (die\n"
+           "      Werte fuer die FFT in \"numerik_deutsch_checkpoint_samples.bin\")\n"
+           "--resume: Rechnung ab dem Checkpoint bitgenau fortsetzen (alle\n"
+           "          Argumente wie zuvor, t darf groesser sein)\n"
+           "-b: Loesung und Spektrum binaer in \"numerik_deutsch_ode_solution.bin\"\n"
+           "    und \"numerik_deutsch_power_spectrum.bin\" speichern\n"
+           "-c datei: Binaerdatei in eine Texttabelle (.txt) umwandeln\n"
+           "-e datei: Ensemble aus den Anfangsbedingungen in \"datei\" (je Zeile\n"
+           "          theta1 omega1 theta2 omega2) gemeinsam entwickeln, die\n"
+           "          Endzustaende werden in \"numerik_deutsch_ensemble.txt\"\n"
+           "          gespeichert\n"
            "t: Laenge der Zeitentwicklung\n"
            "h: Zeitschritt\n"
            "theta/omega: Anfangsbedingung des Pendels (Bezeichnung PDF)\n"
@@ -90,35 +465,50 @@ int main(int argc, char **argv) {
            "Beispielaufruf:\n"
            "%s 10 0.001 3.14 0 3.14 0\nEntwicklung ueber 10 s in Schritten von 0.001 s mit den beiden\n"
            "Winkeln gleich Pi und ohne anfaengliche Winkelgeschwindigkeit)\n\n",
-           argv[0], argv[0]);
+           prog, prog, prog, prog);
     return -1;
   }
   input_cnt += sscanf(argv[1], "%lf", &t);
   input_cnt += sscanf(argv[2], "%lf", &h);
-  input_cnt += sscanf(argv[3], "%lf", y0);
-  input_cnt += sscanf(argv[4], "%lf", y0+1);
-  input_cnt += sscanf(argv[5], "%lf", y0+2);
-  input_cnt += sscanf(argv[6], "%lf", y0+3);
+  for (i = 0; i < y0_cnt; i++) {
+    input_cnt += sscanf(argv[3+i], "%lf", y0+i);
+  }
   
-  if (input_cnt != 6) {
+  if (input_cnt != 2 + y0_cnt) {
     printf("Es konnten nicht alle Argumente eingelesen werden\n");
     return -1;
   }
   
   /* Optionale Argumente einlesen */
-  if (argc == 12) {
-    input_cnt += sscanf(argv[7], "%lf", &g);
-    input_cnt += sscanf(argv[8], "%lf", &m1);
-    input_cnt += sscanf(argv[9], "%lf", &m2);
-    input_cnt += sscanf(argv[10], "%lf", &L1);
-    input_cnt += sscanf(argv[11], "%lf", &L2);
+  if (argc == 8 + y0_cnt) {
+    input_cnt += sscanf(argv[3+y0_cnt], "%lf", &g);
+    input_cnt += sscanf(argv[4+y0_cnt], "%lf", &m1);
+    input_cnt += sscanf(argv[5+y0_cnt], "%lf", &m2);
+    input_cnt += sscanf(argv[6+y0_cnt], "%lf", &L1);
+    input_cnt += sscanf(argv[7+y0_cnt], "%lf", &L2);
     
-    if (input_cnt != 11) {
+    if (input_cnt != 7 + y0_cnt) {
       printf("Es konnten nicht alle Argumente eingelesen werden\n");
       return -1;
     }
   }
   
+  /* Ensemble: Die Parameter werden direkt uebernommen, es folgt keine FFT */
+  if (ensemble != NULL) {
+    params[0] = g;
+    params[1] = m2 / (m1 + m2);
+    params[2] = L1;
+    params[3] = L2;
+    
+    printf("Entwicklung des Ensembles aus \"%s\"...\n", ensemble);
+    if (solve_ensemble(&system, t, h, ensemble,
+                       "numerik_deutsch_ensemble.txt") != 0) {
+      return -1;
+    }
+    printf("Endzustaende gespeichert in \"numerik_deutsch_ensemble.txt\"\n");
+    return 0;
+  }
+  
   /* Ausgabe welche Parameter zum Berechnen verwendet werden */
   printf("Verwendeter Parametersatz:\n"
          "Laenge der Zeitentwicklung und Zeitschritt:\n"
@@ -138,175 +528,576 @@ int main(int argc, char **argv) {
   params[2] = L1;
   params[3] = L2;
   
-  /* Loesen des DGL-Sys. */
-  printf("Loesen des Differentialgleichungssystems...\n");
-  solution = rk4_solve(&system, y0, 0, t, h);
+  /* Es werden alle (int)(t / h) + 1 Punkte der Loesung transformiert (die
+   * FFT ist fuer beliebige Laengen definiert) */
+  n = (int)(t / h) + 1;
   
-  /* Berechnete Loesung speichern (hier werden noch einige Berechnungen durch-
-   * gefuehrt, wie der verallgemeinerte Impuls, Trajektorie in kartesischen
-   * koordinaten etc.) */
-  printf("Speichern der Loesung in \"numerik_deutsch_ode_solution.txt\"...\n");
-  save_ode_solution(solution, m1, m2, L1, L2, "numerik_deutsch_ode_solution.txt");
+  /* Einstellungen der Rechnung fuer die Checkpoints */
+  memset(&checkpoint, 0, sizeof(CHECKPOINT));
+  memcpy(checkpoint.header.magic, CHECKPOINT_MAGIC, 8);
+  checkpoint.header.settings.h = h;
+  checkpoint.header.settings.tol = tol;
+  for (i = 0; i < 4; i++) {
+    checkpoint.header.settings.y0[i] = y0[i];
+  }
+  checkpoint.header.settings.g = g;
+  checkpoint.header.settings.m1 = m1;
+  checkpoint.header.settings.m2 = m2;
+  checkpoint.header.settings.L1 = L1;
+  checkpoint.header.settings.L2 = L2;
+  checkpoint.header.settings.method = method;
+  checkpoint.header.settings.every = every;
+  checkpoint.header.settings.window = window;
+  checkpoint.header.settings.mode = mode;
+  checkpoint.header.settings.binary = binary;
+  checkpoint.header.settings.poincare = poincare;
+  checkpoint.header.settings.flip = flip;
   
+  /* Fortsetzen: Zustand des Loesers lesen, die Zustaende der Beobachter werden
+   * unten beim Erstellen uebernommen */
+  if (resume) {
+    state.y = state_y;
+    state.dydt = state_dydt;
+    checkpoint_file = checkpoint_load(&checkpoint.header, &state);
+    if (checkpoint_file == NULL) return -1;
+    if (state.t > t) {
+      printf("Der Checkpoint (t = %f s) liegt hinter dem Ende der "
+             "Zeitentwicklung\n", state.t);
+      return -1;
+    }
+    printf("Fortsetzen ab dem Checkpoint bei t = %f s\n\n", state.t);
+  }
   
-  /* #### FFT #### */
+  /* Array komplexer Zahlen fuer die Fourierkoeffizienten beider Winkel (bei
+   * der Analyse in Fenstern wird nur Speicher fuer ein Fenster benoetigt) */
+  f = NULL;
+  if (window > 0) {
+    if (resume) {
+      spec = spectrogram_resume(mode, window, window / 2, 0, 2, h,
+                                "numerik_deutsch_spectrogram.txt",
+                                checkpoint_file);
+    } else {
+      spec = spectrogram_alloc(mode, window, window / 2, 0, 2, h,
+                               "numerik_deutsch_spectrogram.txt");
+    }
+    if (spec == NULL) {
+      printf("Die Spektralanalyse konnte nicht vorbereitet werden\n");
+      return -1;
+    }
+  } else {
+    f = malloc(n * sizeof(double complex));
+    if (f == NULL) {
+      printf("Speicher fuer die Fourierkoeffizienten konnte nicht allokiert werden\n");
+      return -1;
+    }
+    
+    /* Werte fuer die FFT werden nur an die Datei angehaengt */
+    if (checkpoint_every > 0 || resume) {
+      checkpoint.samples_file =
+        checkpoint_samples_open(f, resume ? checkpoint.header.samples : -1);
+      if (checkpoint.samples_file == NULL) return -1;
+      checkpoint.samples_written = resume ? checkpoint.header.samples : 0;
+    }
+  }
   
-  /* Berechnet die maximale Anzahl n = 2^r an Datenpunkten fuer eine
-   * Radix-2-FFT */
-  r = 0, n = 1;
-  while ((n <<= 1) <= solution->t_count) r++;
-  n = 1 << r;
-  
-  /* Arrays komplexer Zahlen fuer die Fourierkoeffizienten */
-  f1 = malloc(n * sizeof(double complex));
-  f2 = malloc(n * sizeof(double complex));
-  if (f1 == NULL || f2 == NULL) {
-    printf("Speicher fuer die Fourierkoeffizienten konnte nicht allokiert werden\n");
+  /* Die Loesung wird waehrend der Integration in die Datei geschrieben (hier
+   * werden noch einige Berechnungen durchgefuehrt, wie der verallgemeinerte
+   * Impuls, Trajektorie in kartesischen koordinaten etc.) und die Werte fuer
+   * theta1 und theta2 in f gesammelt */
+  if (binary) {
+    traj_params[0] = g;
+    traj_params[1] = m1;
+    traj_params[2] = m2;
+    traj_params[3] = L1;
+    traj_params[4] = L2;
+    traj_params[5] = h * every;
+    
+    if (resume) {
+      traj = traj_resume("numerik_deutsch_ode_solution.bin", TRAJ_PENDULUM, 5,
+                         (int)(t / h) / every + 1, checkpoint.header.output);
+    } else {
+      traj = traj_create("numerik_deutsch_ode_solution.bin", TRAJ_PENDULUM, 5,
+                         (int)(t / h) / every + 1, traj_params, 6);
+    }
+    if (traj == NULL) {
+      printf("Konnte die Datei numerik_deutsch_ode_solution.bin nicht "
+             "erstellen\n");
+      return -1;
+    }
+    observers[0].observe = traj_observe;
+    observers[0].data = traj;
+  } else {
+    if (solution_writer_open(&writer, "numerik_deutsch_ode_solution.txt",
+                             m1, m2, L1, L2,
+                             resume ? checkpoint.header.output : -1) != 0) {
+      return -1;
+    }
+    observers[0].observe = solution_writer_observe;
+    observers[0].data = &writer;
+  }
+  observers[0].every = every;
+  
+  if (spec != NULL) {
+    observers[1].observe = spectrogram_observe;
+    observers[1].data = spec;
+  } else {
+    samples.n = n;
+    samples.index = resume ? checkpoint.header.samples : 0;
+    samples.f = f;
+    observers[1].observe = fft_samples_observe;
+    observers[1].data = &samples;
+  }
+  observers[1].every = 1;
+  
+  /* Ereignisse */
+  if (poincare) {
+    if (solution_writer_open(&poincare_writer, "numerik_deutsch_poincare.txt",
+                             m1, m2, L1, L2,
+                             resume ? checkpoint.header.poincare_output : -1)
+        != 0) {
+      return -1;
+    }
+    events[system.event_count].g = poincare_event;
+    events[system.event_count].params = NULL;
+    events[system.event_count].direction = 1;
+    events[system.event_count].terminal = 0;
+    events[system.event_count].observe = poincare_observe;
+    events[system.event_count].data = &poincare_writer;
+    system.event_count++;
+  }
+  if (flip) {
+    events[system.event_count].g = flip_event;
+    events[system.event_count].params = NULL;
+    events[system.event_count].direction = -1;
+    events[system.event_count].terminal = 1;
+    events[system.event_count].observe = flip_observe;
+    events[system.event_count].data = &flip_time;
+    system.event_count++;
+  }
+  
+  /* Energie und Drehimpuls werden bei jedem Verfahren ueberwacht */
+  monitor.g = g;
+  monitor.m1 = m1;
+  monitor.m2 = m2;
+  monitor.L1 = L1;
+  monitor.L2 = L2;
+  monitor.count = 0;
+  if (resume) {
+    monitor = checkpoint.header.monitor;
+    flip_time = checkpoint.header.flip_time;
+  }
+  observers[2].observe = energy_monitor_observe;
+  observers[2].data = &monitor;
+  observers[2].every = 1;
+  
+  /* Checkpoints */
+  checkpoint.writer = binary ? NULL : &writer;
+  checkpoint.traj = traj;
+  checkpoint.samples = (spec == NULL) ? &samples : NULL;
+  checkpoint.spec = spec;
+  checkpoint.monitor = &monitor;
+  checkpoint.poincare_writer = poincare ? &poincare_writer : NULL;
+  checkpoint.flip_time = &flip_time;
+  solver_checkpoint.every = checkpoint_every;
+  solver_checkpoint.save = checkpoint_save;
+  solver_checkpoint.data = &checkpoint;
+  solver_checkpoint.resume = resume ? &state : NULL;
+  
+  /* Loesen des DGL-Sys. */
+  printf("Loesen des Differentialgleichungssystems und Speichern der Loesung "
+         "in \"numerik_deutsch_ode_solution.%s\"...\n", binary ? "bin" : "txt");
+  if (tol > 0) {
+    ret = rkdp45_solve_observed(&system, y0, 0, t, h, tol, tol, &stats,
+                                observers, 3, &solver_checkpoint);
+    if (ret == 0 || ret == 2) {
+      printf("Dormand-Prince (tol = %g): %li Schritte, %li verworfen, "
+             "%li Auswertungen\n", tol, stats.accepted, stats.rejected,
+             stats.evaluations);
+    }
+  } else if (method >= 0) {
+    hamiltonian_params[0] = g;
+    hamiltonian_params[1] = m1;
+    hamiltonian_params[2] = m2;
+    hamiltonian_params[3] = L1;
+    hamiltonian_params[4] = L2;
+    
+    hamiltonian.dimension = 2;
+    hamiltonian.dH_dq = double_pendulum_dH_dq;
+    hamiltonian.dH_dp = double_pendulum_dH_dp;
+    hamiltonian.separable = 0;
+    hamiltonian.output = double_pendulum_output;
+    hamiltonian.output_dimension = 4;
+    hamiltonian.params = hamiltonian_params;
+    
+    /* Anfangswerte in kanonischen Koordinaten */
+    hamiltonian_y0[0] = y0[0];
+    hamiltonian_y0[1] = y0[2];
+    double_pendulum_momenta(y0, m1, m2, L1, L2,
+                            hamiltonian_y0 + 2, hamiltonian_y0 + 3);
+    
+    ret = symplectic_solve_observed(&hamiltonian, method, hamiltonian_y0,
+                                    0, t, h, &symplectic_stats, observers, 3,
+                                    &solver_checkpoint);
+    if (ret == 0) {
+      printf("Symplektisches Verfahren: %li Schritte, %li Iterationen, "
+             "%li Auswertungen\n", symplectic_stats.steps,
+             symplectic_stats.iterations, symplectic_stats.evaluations);
+    }
+  } else {
+    ret = rk4_solve_observed(&system, y0, 0, t, h, observers, 3,
+                             &solver_checkpoint);
+  }
+  if (checkpoint_file != NULL) fclose(checkpoint_file);
+  if (checkpoint.samples_file != NULL) fclose(checkpoint.samples_file);
+  if (binary) {
+    traj_close(traj);
+  } else {
+    solution_writer_close(&writer);
+  }
+  if (poincare) {
+    solution_writer_close(&poincare_writer);
+  }
+  if (ret != 0 && ret != 2) {
+    printf("Das Differentialgleichungssystem konnte nicht geloest werden\n");
     return -1;
   }
+  if (flip) {
+    if (flip_time >= 0) {
+      printf("Ueberschlag bei t = %f s, Integration beendet\n", flip_time);
+    } else {
+      printf("Kein Ueberschlag bis t = %.3f s\n", t);
+    }
+  }
+  
+  printf("Energie: E(0) = %f J, maximale Abweichung %e J (relativ %e)\n"
+         "Drehimpuls p1 + p2: maximale Abweichung %e kg m^2 s^-1 "
+         "(erhalten fuer g = 0)\n",
+         monitor.energy_0, monitor.energy_drift,
+         monitor.energy_drift / fabs(monitor.energy_0),
+         monitor.momentum_drift);
   
-  /* Schreibe die Loesung fuer theta1 und theta2 in f1 / f2 */
-  for (i = 0; i < n; i++) {
-    f1[i] = solution->y[0][i];
-    f2[i] = solution->y[2][i];
+  /* Die Spektren der Fenster wurden bereits waehrend der Integration
+   * berechnet */
+  if (spec != NULL) {
+    if (mode == SPECTROGRAM_WELCH) {
+      printf("Speichern des Welch-Spektrums (%li Fenster) in "
+             "\"numerik_deutsch_welch.txt\"...\n", spec->segments);
+      ret = save_welch_spectrum(spec, "numerik_deutsch_welch.txt");
+    } else {
+      printf("Spektrogramm (%li Fenster) gespeichert in "
+             "\"numerik_deutsch_spectrogram.txt\"\n", spec->segments);
+    }
+    spectrogram_free(spec);
+    return ret;
   }
   
-  /* Berechnet die DFT der ersten 2^r Datenpunkte fuer theta1 und theta2 */
+  
+  /* #### FFT #### */
+  
+  /* Berechnet die DFT aller Datenpunkte fuer theta1 und theta2 mit einer
+   * komplexen FFT */
   printf("Berechnen der FFT...\n");
-  if (fft(r, f1) == FFT_ALLOC_ERROR ||
-      fft(r, f2) == FFT_ALLOC_ERROR) {
+  n = samples.index;
+  plan = fft_plan_alloc(n);
+  if (plan == NULL) {
     printf("Speicher zur FFT konnte nicht allokiert werden\n");
     return -1;
   }
+  fft_real_pair_execute(plan, f);
+  fft_plan_free(plan);
   
   /* Speichert das Leistungsspektrum der DFT */
-  printf("Speichern der DFT in \"numerik_deutsch_power_spectrum.txt\"...\n");
-  save_power_spectrum(n, h, f1, f2, "numerik_deutsch_power_spectrum.txt");
+  if (binary) {
+    printf("Speichern der DFT in \"numerik_deutsch_power_spectrum.bin\"...\n");
+    save_power_spectrum_binary(n, h, f, "numerik_deutsch_power_spectrum.bin");
+  } else {
+    printf("Speichern der DFT in \"numerik_deutsch_power_spectrum.txt\"...\n");
+    save_power_spectrum(n, h, f, "numerik_deutsch_power_spectrum.txt");
+  }
   
   /* Speicher wieder freigeben */
-  ode_solution_free(solution);
-  free(f1);
-  free(f2); 
+  free(f);
   
   return 0;
 }
 
-double d_theta_1(double t, double *y, double *params) {
-  double omega_1 = y[1];
-  return omega_1;
+int solve_ensemble(ODE_SYSTEM *system, double t, double h,
+                   char *infile, char *outfile) {
+  int i, k;
+  int count = 0, size = 1024;
+  double *y0, *y1, *temp;
+  FILE *file;
+  
+  file = fopen(infile, "r");
+  if (file == NULL) {
+    printf("Konnte die Datei %s nicht oeffnen\n", infile);
+    return -1;
+  }
+  
+  /* Anfangsbedingungen einlesen, das Array wird bei Bedarf vergroessert */
+  y0 = malloc(4 * size * sizeof(double));
+  while (y0 != NULL &&
+         fscanf(file, "%lf %lf %lf %lf", y0 + 4 * count, y0 + 4 * count + 1,
+                y0 + 4 * count + 2, y0 + 4 * count + 3) == 4) {
+    count++;
+    if (count == size) {
+      size *= 2;
+      temp = realloc(y0, 4 * size * sizeof(double));
+      if (temp == NULL) free(y0);
+      y0 = temp;
+    }
+  }
+  fclose(file);
+  
+  y1 = (y0 != NULL) ? malloc(4 * size * sizeof(double)) : NULL;
+  if (y1 == NULL) {
+    printf("Speicher fuer das Ensemble konnte nicht allokiert werden\n");
+    free(y0);
+    return -1;
+  }
+  
+  printf("%i Anfangsbedingungen eingelesen\n", count);
+  if (rk4_solve_batch(system, count, y0, 0, t, h, y1) != 0) {
+    printf("Speicher fuer die Ensemble-Integration konnte nicht allokiert "
+           "werden\n");
+    free(y0);
+    free(y1);
+    return -1;
+  }
+  
+  file = fopen(outfile, "w");
+  if (file == NULL) {
+    printf("Konnte die Datei %s nicht erstellen\n", outfile);
+    free(y0);
+    free(y1);
+    return -1;
+  }
+  
+  /* Tabellenkopf */
+  fprintf(file, "theta1_0[rad]\tomega1_0[rad/s]\ttheta2_0[rad]\tomega2_0[rad/s]\t"
+                "theta1[rad]\tomega1[rad/s]\ttheta2[rad]\tomega2[rad/s]\n");
+  
+  for (k = 0; k < count; k++) {
+    for (i = 0; i < 4; i++) {
+      fprintf(file, "%.10f\t", y0[4 * k + i]);
+    }
+    fprintf(file, "%.10f\t%.10f\t%.10f\t%.10f\n", y1[4 * k], y1[4 * k + 1],
+            y1[4 * k + 2], y1[4 * k + 3]);
+  }
+  
+  fclose(file);
+  free(y0);
+  free(y1);
+  return 0;
 }
 
-double d_omega_1(double t, double *y, double *params) {
-  double theta_1 = y[0];
-  double omega_1 = y[1];
-  double theta_2 = y[2];
-  double omega_2 = y[3];
-  
-  double g = params[0];
-  double mu = params[1];
-  double L_1 = params[2];
-  double L_2 = params[3];
+int solution_writer_open(SOLUTION_WRITER *writer, char *filename,
+                         double m1, double m2, double L1, double L2,
+                         long offset) {
+  /* Groesse des Ausgabepuffers */
+  const size_t buffer_size = 1 << 20;
   
-  double numerator, denominator;
+  writer->params[0] = m1;
+  writer->params[1] = m2;
+  writer->params[2] = L1;
+  writer->params[3] = L2;
+  writer->count = 0;
   
-  double cosdiff = cos(theta_1 - theta_2);
+  if (offset >= 0) {
+    /* Fortsetzen: Zeilen nach dem Checkpoint verwerfen */
+    writer->file = fopen(filename, "r+");
+    if (writer->file == NULL ||
+        ftruncate(fileno(writer->file), offset) != 0 ||
+        fseek(writer->file, offset, SEEK_SET) != 0) {
+      printf("Konnte die Datei %s nicht fortsetzen\n", filename);
+      if (writer->file != NULL) fclose(writer->file);
+      return -1;
+    }
+  } else {
+    writer->file = fopen(filename, "w");
+    if (writer->file == NULL) {
+      printf("Konnte die Datei %s nicht erstellen\n", filename);
+      return -1;
+    }
+  }
   
+  /* Ohne eigenen Puffer wird der Standardpuffer verwendet */
+  writer->buffer = malloc(buffer_size);
+  if (writer->buffer != NULL) {
+    setvbuf(writer->file, writer->buffer, _IOFBF, buffer_size);
+  }
   
-  numerator = (0.5 * mu - 1) * g * sin(theta_1)
-              - 0.5 * mu * g * sin(theta_1 - 2 * theta_2)
-              - mu * sin(theta_1 - theta_2) * (L_1 * omega_1 * omega_1 * cosdiff
-                                               + L_2 * omega_2 * omega_2);
+  if (offset >= 0) return 0;
   
-  denominator = L_1 * (1 - mu * cosdiff * cosdiff);
+  /* Tabellenkopf */
+  fprintf(writer->file, "t\ttheta1[rad]\tomega1[rad/s]\ttheta2[rad]\tomega2[rad/s]\tp1[kg m^2 s^-1]\tp2[kg m^2 s^-1]\tx1[m]\ty1[m]\tx2[m]\ty2[m]\n");
   
-  return numerator / denominator;
+  return 0;
 }
 
-double d_theta_2(double t, double *y, double *params) {
-  double omega_2 = y[3];
-  return omega_2;
+int solution_writer_observe(double t, const double *y, int dimension,
+                            void *data) {
+  SOLUTION_WRITER *writer = data;
+  int i;
+  
+  writer->rows[writer->count] = t;
+  for (i = 0; i < 4; i++) {
+    writer->rows[(i + 1) * SOLUTION_BLOCK + writer->count] = y[i];
+  }
+  writer->count++;
+  
+  if (writer->count == SOLUTION_BLOCK) solution_writer_flush(writer);
+  
+  return 0;
 }
 
-double d_omega_2(double t, double *y, double *params) {
-  double theta_1 = y[0];
-  double omega_1 = y[1];
-  double theta_2 = y[2];
-  double omega_2 = y[3];
+void solution_writer_flush(SOLUTION_WRITER *writer) {
+  int k;
+  const double *t = writer->rows;
+  const double *y = writer->rows + SOLUTION_BLOCK;
   
-  double g = params[0];
-  double mu = params[1];
-  double L_1 = params[2];
-  double L_2 = params[3];
+  /* Berechne die verallgemeinerten Impulse und die Koordinaten im
+   * kartesischen KS fuer den ganzen Block */
+  double_pendulum_derived(y, writer->derived, writer->count, SOLUTION_BLOCK,
+                          writer->params);
   
-  double numerator, denominator;
+  /* Schreiben in die Datei */
+  for (k = 0; k < writer->count; k++) {
+    const double *d = writer->derived + k;
+    fprintf(writer->file, "%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\n",
+            t[k], y[k], y[SOLUTION_BLOCK + k], y[2 * SOLUTION_BLOCK + k],
+            y[3 * SOLUTION_BLOCK + k], d[0], d[SOLUTION_BLOCK],
+            d[2 * SOLUTION_BLOCK], d[3 * SOLUTION_BLOCK],
+            d[4 * SOLUTION_BLOCK], d[5 * SOLUTION_BLOCK]);
+  }
   
-  double cosdiff = cos(theta_1 - theta_2);
+  writer->count = 0;
+}
+
+void double_pendulum_dH_dq(const double *q, const double *p, double *dHdq,
+                           void *params) {
+  double *par = params;
+  double g = par[0], m1 = par[1], m2 = par[2], L1 = par[3], L2 = par[4];
   
-  numerator = sin(theta_1 - theta_2) * (g * cos(theta_1)
-                                        + L_1 * omega_1 * omega_1
-                                        + mu * L_2 * omega_2 * omega_2 * cosdiff);
+  double sindiff = sin(q[0] - q[1]);
+  double cosdiff = cos(q[0] - q[1]);
+  double denominator = m1 + m2 * sindiff * sindiff;
   
-  denominator = L_2 * (1 - mu * cosdiff * cosdiff);
+  /* Ableitungen der kinetischen Energie nach der Winkeldifferenz */
+  double a = p[0] * p[1] * sindiff / (L1 * L2 * denominator);
+  double b = (m2 * L2 * L2 * p[0] * p[0] + (m1 + m2) * L1 * L1 * p[1] * p[1]
+              - 2 * m2 * L1 * L2 * p[0] * p[1] * cosdiff)
+             * sindiff * cosdiff
+             / (L1 * L1 * L2 * L2 * denominator * denominator);
   
-  return numerator / denominator;
+  dHdq[0] = (m1 + m2) * g * L1 * sin(q[0]) + a - b;
+  dHdq[1] = m2 * g * L2 * sin(q[1]) - a + b;
 }
 
-void save_ode_solution(ODE_SOLUTION *solution, double m1, double m2,
-                       double L1, double L2, char *filename) {
-  int i;
+void double_pendulum_dH_dp(const double *q, const double *p, double *dHdp,
+                           void *params) {
+  double *par = params;
+  double m1 = par[1], m2 = par[2], L1 = par[3], L2 = par[4];
   
-  /* Anzahl der Datenpunkte */
-  int t_count = solution->t_count;
+  double sindiff = sin(q[0] - q[1]);
+  double cosdiff = cos(q[0] - q[1]);
+  double denominator = m1 + m2 * sindiff * sindiff;
   
-  double *t = solution->t;
-  double **y = solution->y;
+  /* Winkelgeschwindigkeiten omega = M^-1 p mit der Massenmatrix M */
+  dHdp[0] = (L2 * p[0] - L1 * p[1] * cosdiff)
+            / (L1 * L1 * L2 * denominator);
+  dHdp[1] = ((m1 + m2) * L1 * p[1] - m2 * L2 * p[0] * cosdiff)
+            / (m2 * L1 * L2 * L2 * denominator);
+}
+
+void double_pendulum_output(const double *y, double *out, void *params) {
+  double omega[2];
   
-  /* verallgemeinerte Impulse */
-  double p1, p2;
-  double cosdiff;
+  double_pendulum_dH_dp(y, y + 2, omega, params);
+  out[0] = y[0];
+  out[1] = omega[0];
+  out[2] = y[1];
+  out[3] = omega[1];
+}
+
+void double_pendulum_momenta(const double *y, double m1, double m2,
+                             double L1, double L2, double *p1, double *p2) {
+  double cosdiff = cos(y[0] - y[2]);
   
-  /* kartesische Koordinaten */
-  double x1, x2, y1, y2;
-  /* Sinus/Cosinus der Winkel */
-  double s1, c1, s2, c2;
+  *p1 = (m1 + m2) * L1 * L1 * y[1] + m2 * L1 * L2 * y[3] * cosdiff;
+  *p2 = m2 * L1 * L2 * y[1] * cosdiff + m2 * L2 * L2 * y[3];
+}
+
+int energy_monitor_observe(double t, const double *y, int dimension,
+                           void *data) {
+  ENERGY_MONITOR *monitor = data;
+  double p1, p2, energy, momentum;
   
-  FILE *file = fopen(filename, "w");
-  if (file == NULL) {
-    printf("Konnte die Datei %s nicht erstellen\n", filename);
-    return;
+  /* Mit p = M omega ist die kinetische Energie T = omega * p / 2 */
+  double_pendulum_momenta(y, monitor->m1, monitor->m2, monitor->L1,
+                          monitor->L2, &p1, &p2);
+  energy = 0.5 * (y[1] * p1 + y[3] * p2)
+           - (monitor->m1 + monitor->m2) * monitor->g * monitor->L1 * cos(y[0])
+           - monitor->m2 * monitor->g * monitor->L2 * cos(y[2]);
+  momentum = p1 + p2;
+  
+  if (monitor->count == 0) {
+    monitor->energy_0 = energy;
+    monitor->momentum_0 = momentum;
+    monitor->energy_drift = 0;
+    monitor->momentum_drift = 0;
   }
+  monitor->count++;
   
-  /* Tabellenkopf */
-  fprintf(file, "t\ttheta1[rad]\tomega1[rad/s]\ttheta2[rad]\tomega2[rad/s]\tp1[kg m^2 s^-1]\tp2[kg m^2 s^-1]\tx1[m]\ty1[m]\tx2[m]\ty2[m]\n");
-  
-  /* Loesung */
-  for (i = 0; i < t_count; i++) {
-    /* Berechne die verallgemeinerten Impulse */
-    cosdiff = cos(y[0][i] - y[2][i]);
-    p1 = (m1 + m2) * L1 * L1 * y[1][i] + m2 * L1 * L2 * y[3][i] * cosdiff;
-    p2 = m2 * L1 * L2 * y[1][i] * cosdiff + m2 * L2 * L2 * y[3][i];
-    
-    /* Berechne die Koordinaten im kartesischen KS */
-    s1 = sin(y[0][i]), c1 = cos(y[0][i]);
-    s2 = sin(y[2][i]), c2 = cos(y[2][i]);
-    
-    x1 = L1 * s1;
-    y1 = -L1 * c1;
-    x2 = L1 * s1 + L2 * s2;
-    y2 = -L1 * c1 - L2 * c2;
-    
-    /* Schreiben in die Datei */
-    fprintf(file, "%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\t%f\n",
-            t[i], y[0][i], y[1][i], y[2][i], y[3][i], p1, p2, x1, y1, x2, y2);
+  if (fabs(energy - monitor->energy_0) > monitor->energy_drift) {
+    monitor->energy_drift = fabs(energy - monitor->energy_0);
+  }
+  if (fabs(momentum - monitor->momentum_0) > monitor->momentum_drift) {
+    monitor->momentum_drift = fabs(momentum - monitor->momentum_0);
   }
   
-  fclose(file);
+  return 0;
+}
+
+double poincare_event(double t, const double *y, void *params) {
+  return sin(y[0]);
+}
+
+double flip_event(double t, const double *y, void *params) {
+  return fft_pi - fmax(fabs(y[0]), fabs(y[2]));
+}
+
+int poincare_observe(double t, const double *y, int dimension, void *data) {
+  if (y[1] <= 0) return 0;
+  return solution_writer_observe(t, y, dimension, data);
+}
+
+int flip_observe(double t, const double *y, int dimension, void *data) {
+  *(double *)data = t;
+  return 0;
+}
+
+void solution_writer_close(SOLUTION_WRITER *writer) {
+  solution_writer_flush(writer);
+  fclose(writer->file);
+  free(writer->buffer);
 }
 
-void save_power_spectrum(int n, double delta,
-                         double complex *f1, double complex *f2,
+int fft_samples_observe(double t, const double *y, int dimension, void *data) {
+  FFT_SAMPLES *samples = data;
+  
+  if (samples->index < samples->n) {
+    samples->f[samples->index] = y[0] + I * y[2];
+    samples->index++;
+  }
+  
+  return 0;
+}
+
+void save_power_spectrum(int n, double delta, double complex *f,
                          char *filename) {
   int i;
+  double complex g1, g2;
   FILE *file;
   
   file = fopen(filename, "w");
@@ -318,10 +1109,337 @@ void save_power_spectrum(int n, double delta,
   /* Tabellenkopf */
   fprintf(file, "k\tomega[rad/s]\t|g_k(theta_1)|[rad]\t|g_k(theta_2)|[rad]\n");
   
-  for (i = 0; i < n; i++) {
+  for (i = 0; i <= n / 2; i++) {
+    fft_real_pair_get(n, f, i, &g1, &g2);
     fprintf(file, "%i\t%f\t%f\t%f\n",
-            i, 2 * fft_pi * i/(n * delta), cabs(f1[i]), cabs(f2[i]));
+            i, 2 * fft_pi * i/(n * delta), cabs(g1), cabs(g2));
+  }
+  
+  fclose(file);
+}
+
+void save_power_spectrum_binary(int n, double delta, double complex *f,
+                                char *filename) {
+  int i;
+  double *omega, *g1, *g2;
+  double complex c1, c2;
+  TRAJECTORY *traj;
+  
+  traj = traj_create(filename, TRAJ_SPECTRUM, 3, n / 2 + 1, &delta, 1);
+  if (traj == NULL) {
+    printf("Konnte die Datei %s nicht erstellen\n", filename);
+    return;
+  }
+  
+  omega = traj_column(traj, 0);
+  g1 = traj_column(traj, 1);
+  g2 = traj_column(traj, 2);
+  
+  for (i = 0; i <= n / 2; i++) {
+    fft_real_pair_get(n, f, i, &c1, &c2);
+    omega[i] = 2 * fft_pi * i/(n * delta);
+    g1[i] = cabs(c1);
+    g2[i] = cabs(c2);
+  }
+  traj->header->valid = n / 2 + 1;
+  
+  traj_close(traj);
+}
+
+int save_welch_spectrum(SPECTROGRAM *spec, char *filename) {
+  int k;
+  int n = spec->window;
+  double *p;
+  FILE *file;
+  
+  p = malloc(2 * (n / 2 + 1) * sizeof(double));
+  if (p == NULL) {
+    printf("Speicher fuer das Welch-Spektrum konnte nicht allokiert werden\n");
+    return -1;
+  }
+  spectrogram_welch(spec, p, p + n / 2 + 1);
+  
+  file = fopen(filename, "w");
+  if (file == NULL) {
+    printf("Konnte die Datei %s nicht erstellen\n", filename);
+    free(p);
+    return -1;
+  }
+  
+  fprintf(file, "k\tomega[rad/s]\tP(theta_1)[rad^2]\tP(theta_2)[rad^2]\n");
+  for (k = 0; k <= n / 2; k++) {
+    fprintf(file, "%i\t%f\t%e\t%e\n",
+            k, 2 * fft_pi * k / (n * spec->delta), p[k], p[n/2+1+k]);
   }
   
   fclose(file);
-}
\ No newline at end of file
+  free(p);
+  
+  return 0;
+}
+
+int checkpoint_save(const ODE_STATE *state, void *data) {
+  int ok;
+  CHECKPOINT *checkpoint = data;
+  CHECKPOINT_HEADER *header = &checkpoint->header;
+  FILE *file;
+  
+  header->dimension = state->dimension;
+  header->step = state->step;
+  header->t = state->t;
+  header->h = state->h;
+  header->stats[0] = state->stats[0];
+  header->stats[1] = state->stats[1];
+  header->stats[2] = state->stats[2];
+  
+  /* Stand der Ausgabedateien: Der Puffer wird geschrieben, damit die Datei
+   * bis zur gespeicherten Laenge vollstaendig ist. Die abgebildete Binaerdatei
+   * schreibt das Betriebssystem auch nach einem Abbruch des Prozesses. */
+  if (checkpoint->traj != NULL) {
+    header->output = checkpoint->traj->index;
+  } else {
+    solution_writer_flush(checkpoint->writer);
+    if (fflush(checkpoint->writer->file) != 0) return 1;
+    header->output = ftell(checkpoint->writer->file);
+  }
+  header->poincare_output = 0;
+  if (checkpoint->poincare_writer != NULL) {
+    solution_writer_flush(checkpoint->poincare_writer);
+    if (fflush(checkpoint->poincare_writer->file) != 0) return 1;
+    header->poincare_output = ftell(checkpoint->poincare_writer->file);
+  }
+  header->samples = 0;
+  if (checkpoint->samples != NULL) {
+    /* Nur die seit dem letzten Checkpoint gesammelten Werte anhaengen */
+    header->samples = checkpoint->samples->index;
+    if (fwrite(checkpoint->samples->f + checkpoint->samples_written,
+               sizeof(double complex),
+               header->samples - checkpoint->samples_written,
+               checkpoint->samples_file)
+        != (size_t)(header->samples - checkpoint->samples_written) ||
+        fflush(checkpoint->samples_file) != 0) {
+      printf("Konnte die Datei %s nicht schreiben\n",
+             CHECKPOINT_SAMPLES_FILE);
+      return 1;
+    }
+    checkpoint->samples_written = header->samples;
+  }
+  header->flip_time = *checkpoint->flip_time;
+  header->monitor = *checkpoint->monitor;
+  
+  file = fopen(CHECKPOINT_FILE ".tmp", "wb");
+  if (file == NULL) {
+    printf("Konnte die Datei %s nicht erstellen\n", CHECKPOINT_FILE ".tmp");
+    return 1;
+  }
+  ok = (fwrite(header, sizeof(CHECKPOINT_HEADER), 1, file) == 1 &&
+        fwrite(state->y, sizeof(double), state->dimension, file)
+        == (size_t)state->dimension &&
+        (state->dydt == NULL ||
+         fwrite(state->dydt, sizeof(double), state->dimension, file)
+         == (size_t)state->dimension));
+  if (ok && checkpoint->spec != NULL) {
+    ok = (spectrogram_write_state(checkpoint->spec, file) == 0);
+  }
+  if (fclose(file) != 0) ok = 0;
+  
+  if (!ok || rename(CHECKPOINT_FILE ".tmp", CHECKPOINT_FILE) != 0) {
+    printf("Konnte den Checkpoint nicht speichern\n");
+    return 1;
+  }
+  
+  return 0;
+}
+
+FILE *checkpoint_load(CHECKPOINT_HEADER *header, ODE_STATE *state) {
+  CHECKPOINT_SETTINGS settings = header->settings;
+  FILE *file;
+  
+  file = fopen(CHECKPOINT_FILE, "rb");
+  if (file == NULL) {
+    printf("Konnte den Checkpoint %s nicht oeffnen\n", CHECKPOINT_FILE);
+    return NULL;
+  }
+  
+  if (fread(header, sizeof(CHECKPOINT_HEADER), 1, file) != 1 ||
+      memcmp(header->magic, CHECKPOINT_MAGIC, 8) != 0 ||
+      header->dimension != 4) {
+    printf("Ungueltiger Checkpoint %s\n", CHECKPOINT_FILE);
+    fclose(file);
+    return NULL;
+  }
+  if (memcmp(&settings, &header->settings, sizeof(CHECKPOINT_SETTINGS)) != 0) {
+    printf("Der Checkpoint gehoert zu einer Rechnung mit anderen Optionen "
+           "oder Argumenten\n");
+    fclose(file);
+    return NULL;
+  }
+  
+  state->dimension = header->dimension;
+  state->step = header->step;
+  state->t = header->t;
+  state->h = header->h;
+  state->stats[0] = header->stats[0];
+  state->stats[1] = header->stats[1];
+  state->stats[2] = header->stats[2];
+  
+  /* f(t, y) nur bei Dormand-Prince */
+  if (settings.tol <= 0) state->dydt = NULL;
+  if (fread(state->y, sizeof(double), 4, file) != 4 ||
+      (state->dydt != NULL &&
+       fread(state->dydt, sizeof(double), 4, file) != 4)) {
+    printf("Der Checkpoint ist unvollstaendig\n");
+    fclose(file);
+    return NULL;
+  }
+  
+  return file;
+}
+
+FILE *checkpoint_samples_open(double complex *f, long count) {
+  FILE *file;
+  
+  if (count < 0) {
+    file = fopen(CHECKPOINT_SAMPLES_FILE, "wb");
+    if (file == NULL) {
+      printf("Konnte die Datei %s nicht erstellen\n", CHECKPOINT_SAMPLES_FILE);
+    }
+    return file;
+  }
+  
+  /* Fortsetzen: Werte nach dem Checkpoint verwerfen */
+  file = fopen(CHECKPOINT_SAMPLES_FILE, "r+b");
+  if (file == NULL ||
+      fread(f, sizeof(double complex), count, file) != (size_t)count ||
+      ftruncate(fileno(file), count * sizeof(double complex)) != 0 ||
+      fseek(file, count * sizeof(double complex), SEEK_SET) != 0) {
+    printf("Konnte die Datei %s nicht fortsetzen\n", CHECKPOINT_SAMPLES_FILE);
+    if (file != NULL) fclose(file);
+    return NULL;
+  }
+  
+  return file;
+}
+
+int convert_binary(char *filename) {
+  int i, j;
+  long pixel;
+  int width, height;
+  double theta_max;
+  size_t len = strlen(filename);
+  char *outfile;
+  double y[4];
+  double *column[5];
+  double *params;
+  TRAJECTORY *traj;
+  SOLUTION_WRITER writer;
+  FILE *file;
+  
+  traj = traj_open(filename);
+  if (traj == NULL) {
+    printf("Konnte die Binaerdatei %s nicht oeffnen\n", filename);
+    return -1;
+  }
+  params = traj->params;
+  
+  /* Name der Ausgabedatei: ".bin" durch ".txt" ersetzen bzw. anhaengen */
+  outfile = malloc(len + 5);
+  if (outfile == NULL) {
+    traj_close(traj);
+    return -1;
+  }
+  strcpy(outfile, filename);
+  if (len > 4 && strcmp(filename + len - 4, ".bin") == 0) {
+    outfile[len - 4] = '\0';
+  }
+  strcat(outfile, ".txt");
+  
+  if (traj->header->kind == TRAJ_PENDULUM && traj->header->columns == 5 &&
+      traj->header->param_count == 6) {
+    if (solution_writer_open(&writer, outfile, params[1], params[2],
+                             params[3], params[4], -1) != 0) {
+      free(outfile);
+      traj_close(traj);
+      return -1;
+    }
+    for (j = 0; j < 5; j++) {
+      column[j] = traj_column(traj, j);
+    }
+    for (i = 0; i < traj->header->valid; i++) {
+      for (j = 0; j < 4; j++) {
+        y[j] = column[j + 1][i];
+      }
+      solution_writer_observe(column[0][i], y, 4, &writer);
+    }
+    solution_writer_close(&writer);
+  } else if (traj->header->kind == TRAJ_SPECTRUM &&
+             traj->header->columns == 3) {
+    file = fopen(outfile, "w");
+    if (file == NULL) {
+      printf("Konnte die Datei %s nicht erstellen\n", outfile);
+      free(outfile);
+      traj_close(traj);
+      return -1;
+    }
+    for (j = 0; j < 3; j++) {
+      column[j] = traj_column(traj, j);
+    }
+    
+    /* Tabellenkopf */
+    fprintf(file, "k\tomega[rad/s]\t|g_k(theta_1)|[rad]\t|g_k(theta_2)|[rad]\n");
+    
+    for (i = 0; i < traj->header->valid; i++) {
+      fprintf(file, "%i\t%f\t%f\t%f\n",
+              i, column[0][i], column[1][i], column[2][i]);
+    }
+    fclose(file);
+  } else if (traj->header->kind == TRAJ_MAP &&
+             traj->header->param_count == 10 &&
+             (traj->header->columns == 1 || traj->header->columns == 2) &&
+             /* Breite und Hoehe muessen zur Anzahl der Pixel passen */
+             params[0] >= 1 && params[0] <= INT_MAX &&
+             params[1] >= 1 && params[1] <= INT_MAX &&
+             (long)params[0] * (long)params[1] == traj->header->count) {
+    file = fopen(outfile, "w");
+    if (file == NULL) {
+      printf("Konnte die Datei %s nicht erstellen\n", outfile);
+      free(outfile);
+      traj_close(traj);
+      return -1;
+    }
+    width = params[0];
+    height = params[1];
+    theta_max = params[2];
+    column[0] = traj_column(traj, 0);
+    column[1] = (traj->header->columns == 2) ? traj_column(traj, 1) : NULL;
+    
+    fprintf(file, "theta1[rad]\ttheta2[rad]\tT_flip[s]%s\n",
+            (column[1] != NULL) ? "\tlambda[1/s]" : "");
+    
+    for (i = 0; i < height; i++) {
+      for (j = 0; j < width; j++) {
+        pixel = (long)i * width + j;
+        fprintf(file, "%f\t%f\t%f",
+                theta_max * (2.0 * (j + 0.5) / width - 1),
+                theta_max * (2.0 * (i + 0.5) / height - 1),
+                column[0][pixel]);
+        if (column[1] != NULL) {
+          fprintf(file, "\t%f", column[1][pixel]);
+        }
+        fprintf(file, "\n");
+      }
+      fprintf(file, "\n");
+    }
+    fclose(file);
+  } else {
+    printf("Unbekannter Inhalt der Binaerdatei %s\n", filename);
+    free(outfile);
+    traj_close(traj);
+    return -1;
+  }
+  
+  printf("Umgewandelt in \"%s\"\n", outfile);
+  free(outfile);
+  traj_close(traj);
+  return 0;
+}
@@ -1,84 +1,629 @@
 #include "numerik_deutsch_fft.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 const double fft_pi = 3.1415926535897932384626433832795;
 
-FFT_ERR fft(int r, double complex *f) {
-  int i, j, k;
-  int m, K, n;
-  int a, b;
-  double complex *w;
+/* Zerlegt n in Faktoren 4, 2, 3 und 5 (Paare (p, n/(p_1 ... p)) wie in
+ * FFT_PLAN). Rueckgabewert ist der nicht zerlegbare Rest von n. */
+static int fft_factorize(int n, int *factors) {
+  int p, i = 0;
   
-  /* Berechne n = 2^r durch r-maligen Bitshift */
-  n = 1 << r;
+  while (n > 1 && i < FFT_MAX_FACTORS) {
+    if (n % 4 == 0) p = 4;
+    else if (n % 2 == 0) p = 2;
+    else if (n % 3 == 0) p = 3;
+    else if (n % 5 == 0) p = 5;
+    else break;
+    
+    n /= p;
+    factors[2*i] = p;
+    factors[2*i+1] = n;
+    i++;
+  }
   
-  /* Lookup-Table fuer die mehrfach auftretenden Exponentialfaktoren */
-  w = malloc(n * sizeof(double complex));
-  if (w == NULL) {
-    return FFT_ALLOC_ERROR;
+  return n;
+}
+
+/* Radix-2-Plan (n = 2^r) */
+static int fft_plan_radix2(FFT_PLAN *plan) {
+  int i;
+  int n = plan->n;
+  
+  /* Die Radix-4-Schritte benoetigen die Exponentialfaktoren w^k mit
+   * k < 3n/4 */
+  plan->w_re = malloc(2 * n * sizeof(double));
+  plan->split = malloc(2 * n * sizeof(double));
+  if (plan->w_re == NULL || plan->split == NULL) return -1;
+  plan->w_im = plan->w_re + n;
+  
+  /* Exponentialfaktoren werden einzeln berechnet (statt durch fortgesetzte
+   * Multiplikation), damit sich keine Rundungsfehler aufsummieren */
+  for (i = 0; i < n; i++) {
+    plan->w_re[i] = cos(2. * fft_pi * i / n);
+    plan->w_im[i] = -sin(2. * fft_pi * i / n);
+  }
+  
+  return 0;
+}
+
+/* Mixed-Radix-Plan (n = 2^a 3^b 5^c) */
+static int fft_plan_mixed(FFT_PLAN *plan) {
+  int i;
+  int n = plan->n;
+  
+  plan->w = malloc(n * sizeof(double complex));
+  plan->work = malloc(n * sizeof(double complex));
+  if (plan->w == NULL || plan->work == NULL) return -1;
+  
+  for (i = 0; i < n; i++) {
+    plan->w[i] = cos(2. * fft_pi * i / n) - I * sin(2. * fft_pi * i / n);
+  }
+  
+  return 0;
+}
+
+/* Bluestein-Plan: Mit 2jk = j^2 + k^2 - (k-j)^2 wird die Transformation zu
+ *   g_k = c_k * Sum[(f_j c_j) * Konjugierte von c_(k-j), {j, 0, n-1}]
+ * mit c_k = Exp[-I * pi/n * k^2], also einer Faltung, die mit einer FFT der
+ * Laenge m = 2^s >= 2n - 1 berechnet wird */
+static int fft_plan_bluestein(FFT_PLAN *plan) {
+  int j, m;
+  int n = plan->n;
+  long long q;
+  
+  m = 1;
+  while (m < 2 * n - 1) m *= 2;
+  
+  plan->inner = fft_plan_alloc(m);
+  plan->chirp = malloc(n * sizeof(double complex));
+  plan->chirp_fft = malloc(m * sizeof(double complex));
+  plan->work = malloc(m * sizeof(double complex));
+  if (plan->inner == NULL || plan->chirp == NULL || plan->chirp_fft == NULL
+      || plan->work == NULL) {
+    return -1;
+  }
+  
+  /* k^2 mod 2n, damit das Argument klein bleibt (Exp[-I pi/n k^2] ist
+   * 2n-periodisch in k^2) */
+  for (j = 0; j < n; j++) {
+    q = ((long long)j * j) % (2 * n);
+    plan->chirp[j] = cos(fft_pi * q / n) - I * sin(fft_pi * q / n);
+  }
+  
+  /* Faltungsfolge b_j = Konjugierte von c_|j| (zyklisch fortgesetzt) */
+  for (j = 0; j < m; j++) {
+    plan->chirp_fft[j] = 0;
+  }
+  for (j = 0; j < n; j++) {
+    plan->chirp_fft[j] = conj(plan->chirp[j]);
+    if (j > 0) plan->chirp_fft[m-j] = conj(plan->chirp[j]);
+  }
+  fft_execute(plan->inner, plan->chirp_fft);
+  
+  /* Die Normierungen beider FFTs der Laenge m und die gewuenschte Normierung
+   * 1/Sqrt[n] werden in die Transformierte eingerechnet */
+  for (j = 0; j < m; j++) {
+    plan->chirp_fft[j] *= sqrt(m) / sqrt(n);
   }
   
-  /* Exponentialfaktoren */
-  w[0] = 1;
-  w[1] = cexp(-2. * fft_pi / n * I);
-  for (i = 2; i < n; i++) {
-    w[i] = w[i-1] * w[1];
+  return 0;
+}
+
+FFT_PLAN *fft_plan_alloc(int n) {
+  int r, ok;
+  FFT_PLAN *ret;
+  
+  if (n < 1) return NULL;
+  
+  ret = malloc(sizeof(FFT_PLAN));
+  if (ret == NULL) return NULL;
+  
+  ret->n = n;
+  ret->scale = 1 / sqrt(n);
+  ret->w = NULL;
+  ret->w_re = NULL;
+  ret->w_im = NULL;
+  ret->split = NULL;
+  ret->work = NULL;
+  ret->inner = NULL;
+  ret->chirp = NULL;
+  ret->chirp_fft = NULL;
+  
+  r = 0;
+  while ((1 << r) < n) r++;
+  ret->r = r;
+  
+  if ((1 << r) == n) {
+    ret->type = FFT_RADIX2;
+    ok = fft_plan_radix2(ret);
+  } else if (fft_factorize(n, ret->factors) == 1) {
+    ret->type = FFT_MIXED_RADIX;
+    ok = fft_plan_mixed(ret);
+  } else {
+    ret->type = FFT_BLUESTEIN;
+    ok = fft_plan_bluestein(ret);
   }
   
-  /* Berechnung der Fourierkoeffizienten */
-  m = n / 2;
-  K = 1;
+  if (ok != 0) {
+    fft_plan_free(ret);
+    return NULL;
+  }
   
-  for (i = 0; i < r; i++) {
-    for (k = 0; k < K; k++) {
-      for (j = 0; j < m; j++) {
-        a = 2 * k * m + j;
-        b = a + m;
-        
-        f[a] = f[a] + f[b];
-        f[b] = w[K*j] * (f[a] - 2. * f[b]);
+  return ret;
+}
+
+void fft_plan_free(FFT_PLAN *plan) {
+  if (plan->inner != NULL) fft_plan_free(plan->inner);
+  free(plan->w);
+  free(plan->w_re);
+  free(plan->split);
+  free(plan->work);
+  free(plan->chirp);
+  free(plan->chirp_fft);
+  free(plan);
+}
+
+#ifdef __AVX2__
+/* (ar + I ai) * (wr + I wi) fuer je vier Werte */
+static inline __m256d fft_mul_re(__m256d ar, __m256d ai, __m256d wr,
+                                 __m256d wi) {
+#ifdef __FMA__
+  return _mm256_fmsub_pd(ar, wr, _mm256_mul_pd(ai, wi));
+#else
+  return _mm256_sub_pd(_mm256_mul_pd(ar, wr), _mm256_mul_pd(ai, wi));
+#endif
+}
+
+static inline __m256d fft_mul_im(__m256d ar, __m256d ai, __m256d wr,
+                                 __m256d wi) {
+#ifdef __FMA__
+  return _mm256_fmadd_pd(ar, wi, _mm256_mul_pd(ai, wr));
+#else
+  return _mm256_add_pd(_mm256_mul_pd(ar, wi), _mm256_mul_pd(ai, wr));
+#endif
+}
+#endif
+
+/* Radix-2-Butterflies k = k0, ..., k1 - 1 eines Stockham-Schritts mit dem
+ * gemeinsamen Exponentialfaktor w = wr + I wi:
+ *   y_k = x_k + x_(k+half),  y_(k+m) = w * (x_k - x_(k+half)) */
+static void fft_butterflies_2(const double *restrict x_re,
+                              const double *restrict x_im, int half,
+                              double *restrict y_re, double *restrict y_im,
+                              int m, double wr, double wi, int k0, int k1) {
+  int k = k0;
+  double t_re, t_im;
+  
+#ifdef __AVX2__
+  /* Je vier Butterflies gleichzeitig */
+  __m256d vwr = _mm256_set1_pd(wr);
+  __m256d vwi = _mm256_set1_pd(wi);
+  __m256d ar, ai, br, bi;
+  
+  for (; k + 4 <= k1; k += 4) {
+    ar = _mm256_loadu_pd(x_re + k);
+    ai = _mm256_loadu_pd(x_im + k);
+    br = _mm256_loadu_pd(x_re + k + half);
+    bi = _mm256_loadu_pd(x_im + k + half);
+    
+    _mm256_storeu_pd(y_re + k, _mm256_add_pd(ar, br));
+    _mm256_storeu_pd(y_im + k, _mm256_add_pd(ai, bi));
+    
+    ar = _mm256_sub_pd(ar, br);
+    ai = _mm256_sub_pd(ai, bi);
+    _mm256_storeu_pd(y_re + k + m, fft_mul_re(ar, ai, vwr, vwi));
+    _mm256_storeu_pd(y_im + k + m, fft_mul_im(ar, ai, vwr, vwi));
+  }
+#endif
+  
+  for (; k < k1; k++) {
+    y_re[k] = x_re[k] + x_re[k+half];
+    y_im[k] = x_im[k] + x_im[k+half];
+    
+    t_re = x_re[k] - x_re[k+half];
+    t_im = x_im[k] - x_im[k+half];
+    y_re[k+m] = t_re * wr - t_im * wi;
+    y_im[k+m] = t_re * wi + t_im * wr;
+  }
+}
+
+/* Radix-4-Butterflies k = k0, ..., k1 - 1 eines Stockham-Schritts mit den
+ * Exponentialfaktoren w^p, w^(2p), w^(3p) (w[0], w[1], w[2]): Mit
+ * a, b, c, d = x_k, x_(k+quarter), x_(k+2 quarter), x_(k+3 quarter) wird
+ *   y_k       = (a + c) + (b + d)
+ *   y_(k+m)   = w^p      * ((a - c) - I (b - d))
+ *   y_(k+2m)  = w^(2p)   * ((a + c) - (b + d))
+ *   y_(k+3m)  = w^(3p)   * ((a - c) + I (b - d))
+ * berechnet */
+static void fft_butterflies_4(const double *restrict x_re,
+                              const double *restrict x_im, int quarter,
+                              double *restrict y_re, double *restrict y_im,
+                              int m, const double *wr, const double *wi,
+                              int k0, int k1) {
+  int k = k0;
+  double apc_re, apc_im, amc_re, amc_im, bpd_re, bpd_im, bmd_re, bmd_im;
+  double t_re, t_im;
+  
+#ifdef __AVX2__
+  __m256d w1r = _mm256_set1_pd(wr[0]), w1i = _mm256_set1_pd(wi[0]);
+  __m256d w2r = _mm256_set1_pd(wr[1]), w2i = _mm256_set1_pd(wi[1]);
+  __m256d w3r = _mm256_set1_pd(wr[2]), w3i = _mm256_set1_pd(wi[2]);
+  __m256d ar, ai, br, bi, cr, ci, dr, di, tr, ti;
+  
+  for (; k + 4 <= k1; k += 4) {
+    ar = _mm256_loadu_pd(x_re + k);
+    ai = _mm256_loadu_pd(x_im + k);
+    br = _mm256_loadu_pd(x_re + k + quarter);
+    bi = _mm256_loadu_pd(x_im + k + quarter);
+    cr = _mm256_loadu_pd(x_re + k + 2 * quarter);
+    ci = _mm256_loadu_pd(x_im + k + 2 * quarter);
+    dr = _mm256_loadu_pd(x_re + k + 3 * quarter);
+    di = _mm256_loadu_pd(x_im + k + 3 * quarter);
+    
+    /* a + c, a - c, b + d, b - d */
+    tr = _mm256_add_pd(ar, cr), ar = _mm256_sub_pd(ar, cr), cr = tr;
+    ti = _mm256_add_pd(ai, ci), ai = _mm256_sub_pd(ai, ci), ci = ti;
+    tr = _mm256_add_pd(br, dr), br = _mm256_sub_pd(br, dr), dr = tr;
+    ti = _mm256_add_pd(bi, di), bi = _mm256_sub_pd(bi, di), di = ti;
+    
+    _mm256_storeu_pd(y_re + k, _mm256_add_pd(cr, dr));
+    _mm256_storeu_pd(y_im + k, _mm256_add_pd(ci, di));
+    
+    tr = _mm256_sub_pd(cr, dr);
+    ti = _mm256_sub_pd(ci, di);
+    _mm256_storeu_pd(y_re + k + 2 * m, fft_mul_re(tr, ti, w2r, w2i));
+    _mm256_storeu_pd(y_im + k + 2 * m, fft_mul_im(tr, ti, w2r, w2i));
+    
+    tr = _mm256_add_pd(ar, bi);
+    ti = _mm256_sub_pd(ai, br);
+    _mm256_storeu_pd(y_re + k + m, fft_mul_re(tr, ti, w1r, w1i));
+    _mm256_storeu_pd(y_im + k + m, fft_mul_im(tr, ti, w1r, w1i));
+    
+    tr = _mm256_sub_pd(ar, bi);
+    ti = _mm256_add_pd(ai, br);
+    _mm256_storeu_pd(y_re + k + 3 * m, fft_mul_re(tr, ti, w3r, w3i));
+    _mm256_storeu_pd(y_im + k + 3 * m, fft_mul_im(tr, ti, w3r, w3i));
+  }
+#endif
+  
+  for (; k < k1; k++) {
+    apc_re = x_re[k] + x_re[k+2*quarter];
+    apc_im = x_im[k] + x_im[k+2*quarter];
+    amc_re = x_re[k] - x_re[k+2*quarter];
+    amc_im = x_im[k] - x_im[k+2*quarter];
+    bpd_re = x_re[k+quarter] + x_re[k+3*quarter];
+    bpd_im = x_im[k+quarter] + x_im[k+3*quarter];
+    bmd_re = x_re[k+quarter] - x_re[k+3*quarter];
+    bmd_im = x_im[k+quarter] - x_im[k+3*quarter];
+    
+    y_re[k] = apc_re + bpd_re;
+    y_im[k] = apc_im + bpd_im;
+    
+    t_re = apc_re - bpd_re;
+    t_im = apc_im - bpd_im;
+    y_re[k+2*m] = t_re * wr[1] - t_im * wi[1];
+    y_im[k+2*m] = t_re * wi[1] + t_im * wr[1];
+    
+    t_re = amc_re + bmd_im;
+    t_im = amc_im - bmd_re;
+    y_re[k+m] = t_re * wr[0] - t_im * wi[0];
+    y_im[k+m] = t_re * wi[0] + t_im * wr[0];
+    
+    t_re = amc_re - bmd_im;
+    t_im = amc_im + bmd_re;
+    y_re[k+3*m] = t_re * wr[2] - t_im * wi[2];
+    y_im[k+3*m] = t_re * wi[2] + t_im * wr[2];
+  }
+}
+
+/* Stockham-FFT (Zerlegung im Frequenzbereich): Ein Schritt mit Radix p
+ * (4 oder 2) zerlegt die l*p Teiltransformationen der Laenge n_s = n/m in
+ * Teiltransformationen der Laenge n_s/p; mit l = n_s/p werden fuer j < l,
+ * k < m die Butterflies q = j*m + k
+ *   x[jm + k + i n/p] (i = 0, ..., p-1)  ->  y[pjm + im + k]
+ * mit den Exponentialfaktoren w^(ijm) berechnet. Die Ergebnisse stehen am Ende
+ * in natuerlicher Reihenfolge (keine Bitumkehr), die inneren Schleifen ueber k
+ * laufen ueber zusammenhaengenden Speicher. Es werden so viele Radix-4-
+ * Schritte wie moeglich verwendet (halb so viele Durchlaeufe durch den
+ * Speicher), bei ungeradem r folgt ein Radix-2-Schritt. "x" und "y" werden
+ * nach jedem Schritt vertauscht; zurueckgegeben wird 0, wenn das Ergebnis in
+ * x steht, sonst 1. */
+static int fft_stockham(FFT_PLAN *plan, double *x_re, double *x_im,
+                        double *y_re, double *y_im) {
+  int n = plan->n;
+  int steps = plan->r / 2 + plan->r % 2;
+  
+  #pragma omp parallel if (n >= FFT_PARALLEL_MIN)
+  {
+    int i, j, k0, k1, l, m, p, q, count;
+    double wr[3], wi[3];
+    double *xr = x_re, *xi = x_im, *yr = y_re, *yi = y_im, *t;
+    
+    m = 1;
+    for (i = 0; i < plan->r; i += (p == 4) ? 2 : 1) {
+      p = (i + 1 < plan->r) ? 4 : 2;
+      l = n / (p * m);
+      count = n / p;
+      
+      /* Die Butterflies werden in Bloecken von FFT_BLOCK aufgeteilt; am Ende
+       * jedes Schritts synchronisiert "omp for" alle Threads */
+      #pragma omp for schedule(static)
+      for (q = 0; q < count; q += FFT_BLOCK) {
+        for (j = q / m; j * m < q + FFT_BLOCK && j < l; j++) {
+          k0 = (q > j * m) ? q - j * m : 0;
+          k1 = (q + FFT_BLOCK < (j + 1) * m) ? q + FFT_BLOCK - j * m : m;
+          
+          if (p == 4) {
+            wr[0] = plan->w_re[j * m], wi[0] = plan->w_im[j * m];
+            wr[1] = plan->w_re[2 * j * m], wi[1] = plan->w_im[2 * j * m];
+            wr[2] = plan->w_re[3 * j * m], wi[2] = plan->w_im[3 * j * m];
+            fft_butterflies_4(xr + j * m, xi + j * m, count,
+                              yr + 4 * j * m, yi + 4 * j * m, m,
+                              wr, wi, k0, k1);
+          } else {
+            fft_butterflies_2(xr + j * m, xi + j * m, count,
+                              yr + 2 * j * m, yi + 2 * j * m, m,
+                              plan->w_re[j * m], plan->w_im[j * m], k0, k1);
+          }
+        }
       }
+      
+      t = xr, xr = yr, yr = t;
+      t = xi, xi = yi, yi = t;
+      m = p * m;
     }
-    m = m / 2;
-    K = 2 * K;
+  }
+  
+  return steps % 2;
+}
+
+void fft_execute_split(FFT_PLAN *plan, double *re, double *im) {
+  int i;
+  int n = plan->n;
+  double *s_re = plan->split;
+  double *s_im = plan->split + n;
+  
+  if (fft_stockham(plan, re, im, s_re, s_im)) {
+    memcpy(re, s_re, n * sizeof(double));
+    memcpy(im, s_im, n * sizeof(double));
   }
   
   /* Normierung */
   for (i = 0; i < n; i++) {
-    f[i] = f[i] / sqrt(n);
+    re[i] *= plan->scale;
+    im[i] *= plan->scale;
   }
+}
+
+static void fft_radix2(FFT_PLAN *plan, double complex *f) {
+  int i;
+  int n = plan->n;
+  /* Der Speicher von "f" wird als Paar getrennter Arrays weiterverwendet */
+  double *f_re = (double *)f;
+  double *f_im = (double *)f + n;
+  double *s_re = plan->split;
+  double *s_im = plan->split + n;
   
-  free(w);
-  /* Reihenfolge wiederherstellen */
-  return fft_rearrange(r, f);
+  /* Trennung in Real- und Imaginaerteile */
+  for (i = 0; i < n; i++) {
+    s_re[i] = creal(f[i]);
+    s_im[i] = cimag(f[i]);
+  }
+  
+  /* Bei ungerader Anzahl an Schritten steht das Ergebnis in "f" */
+  if (fft_stockham(plan, s_re, s_im, f_re, f_im)) {
+    memcpy(s_re, f_re, n * sizeof(double));
+    memcpy(s_im, f_im, n * sizeof(double));
+  }
+  
+  /* Zusammensetzen und Normierung */
+  for (i = 0; i < n; i++) {
+    f[i] = plan->scale * s_re[i] + I * (plan->scale * s_im[i]);
+  }
 }
 
-FFT_ERR fft_rearrange(int r, double complex *f) {
+/* Butterflies der Mixed-Radix-FFT: Fasst p Teiltransformationen der Laenge m
+ * (hintereinander in "out") zu einer Transformation der Laenge p*m zusammen.
+ * Die Exponentialfaktoren der Laenge p*m sind w[k * fstride]. */
+static void fft_butterfly_2(double complex *out, const double complex *w,
+                            int fstride, int m) {
+  int k;
+  double complex t;
+  
+  for (k = 0; k < m; k++) {
+    t = out[k+m] * w[k*fstride];
+    out[k+m] = out[k] - t;
+    out[k] += t;
+  }
+}
+
+static void fft_butterfly_3(double complex *out, const double complex *w,
+                            int fstride, int m) {
+  int k;
+  double complex s1, s2, u, v;
+  /* Imaginaerteil von Exp[-I * 2*pi/3] */
+  const double y = cimag(w[fstride*m]);
+  
+  for (k = 0; k < m; k++) {
+    s1 = out[k+m] * w[k*fstride];
+    s2 = out[k+2*m] * w[2*k*fstride];
+    
+    u = out[k] - 0.5 * (s1 + s2);
+    v = I * y * (s1 - s2);
+    
+    out[k] += s1 + s2;
+    out[k+m] = u + v;
+    out[k+2*m] = u - v;
+  }
+}
+
+static void fft_butterfly_4(double complex *out, const double complex *w,
+                            int fstride, int m) {
+  int k;
+  double complex s0, s1, s2, t0, t1, t2, t3;
+  
+  for (k = 0; k < m; k++) {
+    s0 = out[k+m] * w[k*fstride];
+    s1 = out[k+2*m] * w[2*k*fstride];
+    s2 = out[k+3*m] * w[3*k*fstride];
+    
+    t0 = out[k] + s1;
+    t1 = out[k] - s1;
+    t2 = s0 + s2;
+    t3 = s0 - s2;
+    
+    out[k] = t0 + t2;
+    out[k+m] = t1 - I * t3;
+    out[k+2*m] = t0 - t2;
+    out[k+3*m] = t1 + I * t3;
+  }
+}
+
+static void fft_butterfly_5(double complex *out, const double complex *w,
+                            int fstride, int m) {
+  int k;
+  double complex s0, s1, s2, s3, s4, u, v;
+  /* Exp[-I * 2*pi/5] und Exp[-I * 4*pi/5] */
+  const double complex ya = w[fstride*m];
+  const double complex yb = w[2*fstride*m];
+  
+  for (k = 0; k < m; k++) {
+    s0 = out[k];
+    s1 = out[k+m] * w[k*fstride];
+    s2 = out[k+2*m] * w[2*k*fstride];
+    s3 = out[k+3*m] * w[3*k*fstride];
+    s4 = out[k+4*m] * w[4*k*fstride];
+    
+    out[k] = s0 + s1 + s2 + s3 + s4;
+    
+    u = s0 + creal(ya) * (s1 + s4) + creal(yb) * (s2 + s3);
+    v = I * (cimag(ya) * (s1 - s4) + cimag(yb) * (s2 - s3));
+    out[k+m] = u + v;
+    out[k+4*m] = u - v;
+    
+    u = s0 + creal(yb) * (s1 + s4) + creal(ya) * (s2 + s3);
+    v = I * (cimag(yb) * (s1 - s4) - cimag(ya) * (s2 - s3));
+    out[k+2*m] = u + v;
+    out[k+3*m] = u - v;
+  }
+}
+
+/* Rekursive Mixed-Radix-FFT (Zerlegung im Zeitbereich): Transformiert die
+ * Werte in[j * fstride] fuer j = 0, ..., p*m - 1 nach out */
+static void fft_mixed(double complex *out, const double complex *in,
+                      int fstride, const int *factors, const double complex *w) {
   int i;
-  int l, m, n;
+  int p = factors[0];
+  int m = factors[1];
+  
+  if (m == 1) {
+    for (i = 0; i < p; i++) {
+      out[i] = in[i * fstride];
+    }
+  } else {
+    /* p Teiltransformationen der Laenge m (jeder p-te Wert) */
+    for (i = 0; i < p; i++) {
+      fft_mixed(out + i * m, in + i * fstride, fstride * p, factors + 2, w);
+    }
+  }
   
-  int *index_table;
-  double complex *g;
+  switch (p) {
+    case 2: fft_butterfly_2(out, w, fstride, m); break;
+    case 3: fft_butterfly_3(out, w, fstride, m); break;
+    case 4: fft_butterfly_4(out, w, fstride, m); break;
+    case 5: fft_butterfly_5(out, w, fstride, m); break;
+  }
+}
+
+static void fft_bluestein(FFT_PLAN *plan, double complex *f) {
+  int j;
+  int n = plan->n;
+  int m = plan->inner->n;
+  double complex *work = plan->work;
   
-  /* 2^r mit Bitshift */
-  n = 1 << r;
+  for (j = 0; j < n; j++) {
+    work[j] = f[j] * plan->chirp[j];
+  }
+  for (j = n; j < m; j++) {
+    work[j] = 0;
+  }
+  
+  fft_execute(plan->inner, work);
+  
+  /* Faltung durch Multiplikation; die Ruecktransformation erfolgt als
+   * Konjugierte der FFT der konjugierten Werte */
+  for (j = 0; j < m; j++) {
+    work[j] = conj(work[j] * plan->chirp_fft[j]);
+  }
+  
+  fft_execute(plan->inner, work);
   
-  /* Lookup-Table fuer die korrekte Reihenfolge */
-  index_table = malloc(n * sizeof(int));
-  /* Zwischenspeicher zum Vertauschen der Reihenfolge */
-  g = malloc(n * sizeof(double complex));
+  for (j = 0; j < n; j++) {
+    f[j] = plan->chirp[j] * conj(work[j]);
+  }
+}
+
+void fft_execute(FFT_PLAN *plan, double complex *f) {
+  int i;
+  int n = plan->n;
   
-  if (index_table == NULL || g == NULL) {
-    free(index_table);
-    free(g);
+  switch (plan->type) {
+    case FFT_RADIX2:
+      fft_radix2(plan, f);
+      break;
+    
+    case FFT_MIXED_RADIX:
+      /* Die Rekursion arbeitet nicht in-place */
+      for (i = 0; i < n; i++) {
+        plan->work[i] = f[i];
+      }
+      fft_mixed(f, plan->work, 1, plan->factors, plan->w);
+      for (i = 0; i < n; i++) {
+        f[i] *= plan->scale;
+      }
+      break;
+    
+    case FFT_BLUESTEIN:
+      fft_bluestein(plan, f);
+      break;
+  }
+}
+
+FFT_ERR fft(int r, double complex *f) {
+  FFT_PLAN *plan = fft_plan_alloc(1 << r);
+  
+  if (plan == NULL) {
     return FFT_ALLOC_ERROR;
   }
   
-  /* Lookup-Table anlegen */
+  fft_execute(plan, f);
+  fft_plan_free(plan);
+  
+  return FFT_SUCCESS;
+}
+
+FFT_ERR fft_rearrange(int r, double complex *f) {
+  int i;
+  int l, m, n;
+  double complex temp;
+  
+  /* 2^r mit Bitshift */
+  n = 1 << r;
+  
+  /* Die Indizes der Bitumkehr werden direkt mitgezaehlt und jedes Paar (i, l)
+   * mit i < l einmal vertauscht */
   l = 0;
   for (i = 0; i < n - 1; i++) {
-    index_table[i] = l;
+    if (i < l) {
+      temp = f[i];
+      f[i] = f[l];
+      f[l] = temp;
+    }
     m = n / 2;
     while (m <= l) {
       l = l - m;
@@ -86,20 +631,100 @@ FFT_ERR fft_rearrange(int r, double complex *f) {
     }
     l = l + m;
   }
-  index_table[n-1] = n-1;
   
-  /* f in g zwischenspeichern */
-  for (i = 0; i < n; i++) {
-    g[i] = f[i];
+  return FFT_SUCCESS;
+}
+
+FFT_REAL_PLAN *fft_real_plan_alloc(int n) {
+  int k;
+  FFT_REAL_PLAN *ret;
+  
+  if (n < 2 || n % 2 != 0) return NULL;
+  
+  ret = malloc(sizeof(FFT_REAL_PLAN));
+  if (ret == NULL) return NULL;
+  
+  ret->n = n;
+  ret->half = fft_plan_alloc(n / 2);
+  ret->w = malloc((n / 4 + 1) * sizeof(double complex));
+  if (ret->half == NULL || ret->w == NULL) {
+    if (ret->half != NULL) fft_plan_free(ret->half);
+    free(ret->w);
+    free(ret);
+    return NULL;
   }
   
-  /* von g in f mit richtiger Reihenfolge speichern */
-  for (i = 0; i < n; i++) {
-    f[i] = g[index_table[i]];
+  for (k = 0; k <= n / 4; k++) {
+    ret->w[k] = cos(2. * fft_pi * k / n) - I * sin(2. * fft_pi * k / n);
   }
   
-  free(index_table);
-  free(g);
+  return ret;
+}
+
+void fft_real_plan_free(FFT_REAL_PLAN *plan) {
+  fft_plan_free(plan->half);
+  free(plan->w);
+  free(plan);
+}
+
+void fft_real_execute(FFT_REAL_PLAN *plan, double complex *g) {
+  int k;
+  int N = plan->n / 2;
+  double complex a, b, even, odd, w;
+  /* Normierung: "fft_execute" normiert mit 1/Sqrt[N], benoetigt wird
+   * 1/Sqrt[n] = 1/Sqrt[2 N] */
+  const double scale = 1 / sqrt(2.);
+  
+  /* Die n reellen Werte werden als N komplexe Zahlen x[2j] + I x[2j+1]
+   * aufgefasst und transformiert */
+  fft_execute(plan->half, g);
   
-  return FFT_SUCCESS;
+  /* Randwerte: X[0] und X[N] aus Z[0] */
+  a = g[0];
+  g[0] = scale * (creal(a) + cimag(a));
+  g[N] = scale * (creal(a) - cimag(a));
+  
+  /* Trennung in die Transformationen der geraden und ungeraden Werte und
+   * Zusammensetzen zu X[k] und X[N-k] = Konjugierte von (even - w^k odd) */
+  for (k = 1; k <= N / 2; k++) {
+    a = g[k];
+    b = g[N-k];
+    even = 0.5 * (a + conj(b));
+    odd = -0.5 * I * (a - conj(b));
+    
+    /* w^k fuer k > n/4 ueber w^k = -conj(w^(N-k)) */
+    w = (k <= plan->n / 4) ? plan->w[k] : -conj(plan->w[N-k]);
+    
+    g[k] = scale * (even + w * odd);
+    g[N-k] = scale * conj(even - w * odd);
+  }
+}
+
+void fft_real_pair_execute(FFT_PLAN *plan, double complex *f) {
+  int k;
+  int n = plan->n;
+  double complex a, b;
+  
+  fft_execute(plan, f);
+  
+  /* f[0] (und f[n/2] bei geradem n) enthalten bereits X + I Y, da X und Y
+   * dort reell sind. Fuer 0 < k < n - k wird X[k] in f[k] und Y[k] in f[n-k]
+   * gespeichert. */
+  for (k = 1; k < n - k; k++) {
+    a = f[k];
+    b = f[n-k];
+    f[k] = 0.5 * (a + conj(b));
+    f[n-k] = -0.5 * I * (a - conj(b));
+  }
+}
+
+void fft_real_pair_get(int n, const double complex *f, int k,
+                       double complex *gx, double complex *gy) {
+  if (k == 0 || 2 * k == n) {
+    *gx = creal(f[k]);
+    *gy = cimag(f[k]);
+  } else {
+    *gx = f[k];
+    *gy = f[n-k];
+  }
 }
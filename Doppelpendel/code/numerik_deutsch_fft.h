@@ -10,15 +10,127 @@ typedef enum {
   FFT_ALLOC_ERROR
 } FFT_ERR;
 
+/* Verfahren eines FFT-Plans */
+typedef enum {
+  /* n = 2^r: Stockham-Verfahren (ohne Bitumkehr) mit Radix-4/2-Schritten
+   * auf getrennten Real- und Imaginaerteilen */
+  FFT_RADIX2,
+  /* n = 2^a 3^b 5^c: Mixed-Radix mit Radix-2/3/4/5-Butterflies */
+  FFT_MIXED_RADIX,
+  /* sonstige n: Bluestein-Algorithmus (Faltung mit einer FFT der Laenge
+   * m = 2^s >= 2n - 1) */
+  FFT_BLUESTEIN
+} FFT_TYPE;
+
+/* Maximale Anzahl der Faktoren beim Mixed-Radix-Verfahren */
+#define FFT_MAX_FACTORS 32
+
+/* Anzahl der Butterflies, die bei der Radix-2-FFT als ein Block (an einen
+ * Thread) vergeben werden */
+#define FFT_BLOCK 256
+
+/* Ab dieser Laenge wird die Radix-2-FFT mit OpenMP (falls aktiviert) auf
+ * mehrere Threads verteilt */
+#define FFT_PARALLEL_MIN (1 << 15)
+
+/* Vorberechnete Daten fuer wiederholte FFTs gleicher Laenge n:
+ * type: verwendetes Verfahren
+ * r: n = 2^r (nur FFT_RADIX2)
+ * scale: Normierung 1/Sqrt[n]
+ * w: Exponentialfaktoren Exp[-I * 2*pi/n * k] fuer k = 0, ..., n - 1
+ *    (FFT_MIXED_RADIX)
+ * w_re, w_im: Real- und Imaginaerteile von Exp[-I * 2*pi/n * k] fuer
+ *             k = 0, ..., n - 1 (FFT_RADIX2)
+ * split: Zwischenspeicher fuer 2n Werte (Real- und Imaginaerteile getrennt,
+ *        FFT_RADIX2)
+ * factors: Paare (p, n/(p_1 ... p)) der Zerlegung (FFT_MIXED_RADIX)
+ * work: Zwischenspeicher (n bzw. m Werte, FFT_MIXED_RADIX/FFT_BLUESTEIN)
+ * inner, chirp, chirp_fft: FFT der Laenge m, Exp[-I * pi/n * k^2] fuer
+ *                          k < n und die skalierte Transformierte der
+ *                          Faltungsfolge (FFT_BLUESTEIN)
+ * Da "work" und "split" zum Plan gehoeren, darf ein Plan nicht von mehreren Threads
+ * gleichzeitig ausgefuehrt werden. */
+typedef struct FFT_PLAN {
+  int n;
+  FFT_TYPE type;
+  int r;
+  double scale;
+  
+  double complex *w;
+  double *w_re;
+  double *w_im;
+  double *split;
+  
+  int factors[2 * FFT_MAX_FACTORS];
+  double complex *work;
+  
+  struct FFT_PLAN *inner;
+  double complex *chirp;
+  double complex *chirp_fft;
+} FFT_PLAN;
+
+/* Erstellt einen Plan fuer die FFT von n >= 1 Werten. Das Verfahren wird
+ * anhand der Zerlegung von n gewaehlt. Schlaegt die Allokierung fehl, wird
+ * NULL zurueckgegeben. */
+FFT_PLAN *fft_plan_alloc(int n);
+
+/* Gibt den Speicher des Plans wieder frei */
+void fft_plan_free(FFT_PLAN *plan);
+
+/* Berechnet die diskrete Fouriertransformation (Konvention wie "fft") der
+ * plan->n Werte in "f" ohne weitere Allokierungen */
+void fft_execute(FFT_PLAN *plan, double complex *f);
+
+/* Wie "fft_execute" fuer Real- und Imaginaerteile in getrennten Arrays "re"
+ * und "im" (nur FFT_RADIX2). Entfaellt die Umsortierung in getrennte Arrays,
+ * koennen die Butterflies direkt mit SIMD-Befehlen berechnet werden. */
+void fft_execute_split(FFT_PLAN *plan, double *re, double *im);
+
+/* Plan fuer die FFT von n reellen Werten (n gerade):
+ * half: komplexe FFT der Laenge n/2
+ * w: Exponentialfaktoren Exp[-I * 2*pi/n * k] fuer k = 0, ..., n/4 */
+typedef struct {
+  int n;
+  FFT_PLAN *half;
+  double complex *w;
+} FFT_REAL_PLAN;
+
+/* Erstellt einen Plan fuer die FFT von n reellen Werten. Bei ungueltigem n oder
+ * fehlgeschlagener Allokierung wird NULL zurueckgegeben. */
+FFT_REAL_PLAN *fft_real_plan_alloc(int n);
+
+/* Gibt den Speicher des Plans wieder frei */
+void fft_real_plan_free(FFT_REAL_PLAN *plan);
+
+/* FFT reeller Werte (Konvention wie "fft"): "g" ist ein Array von n/2 + 1
+ * komplexen Zahlen, das zu Beginn die n reellen Werte hintereinander enthaelt
+ * (als double-Array ((double *)g)[j] fuer j = 0, ..., n - 1). Danach stehen
+ * in g[k] die nicht redundanten Koeffizienten g_k fuer k = 0, ..., n/2 (die
+ * uebrigen sind g_(n-k) = Konjugierte von g_k). */
+void fft_real_execute(FFT_REAL_PLAN *plan, double complex *g);
+
+/* FFT zweier reeller Signale x, y der Laenge n = plan->n mit einer komplexen
+ * FFT: "f" enthaelt zu Beginn f[j] = x[j] + I y[j]. Danach enthaelt "f" die
+ * halben Spektren beider Signale in gepackter Form (auslesen mit
+ * "fft_real_pair_get"). */
+void fft_real_pair_execute(FFT_PLAN *plan, double complex *f);
+
+/* Liest die Koeffizienten gx = g_k(x) und gy = g_k(y) fuer 0 <= k <= n/2
+ * (ganzzahlige Division) aus dem Ergebnis von "fft_real_pair_execute" */
+void fft_real_pair_get(int n, const double complex *f, int k,
+                       double complex *gx, double complex *gy);
+
 /* Radix-2 FFT: Berechnet die diskrete Fouriertransformation der n = 2^r -
  * Funktionswerte in "f". Dabei werden die Koeffizienten in richtiger Ordnung in
  * f gespeichert.
  * Verwendete Konvention fuer die Fouriertransformation:
  *   g_k = 1/Sqrt[n] * Sum[f_j * Exp[-I * 2*pi/n * k * j], {j, 0, n-1}]
- *   fuer k = 0, 1, ..., n - 1 */
+ *   fuer k = 0, 1, ..., n - 1
+ * Fuer mehrere FFTs gleicher Laenge sollte ein FFT_PLAN verwendet werden. */
 FFT_ERR fft(int r, double complex *f);
 
-/* Bringt die 2^r Koeffizienten in "f" in die vorgesehene Reihenfolge */
+/* Bringt die 2^r Koeffizienten in "f" in die vorgesehene Reihenfolge (ohne
+ * Zwischenspeicher) */
 FFT_ERR fft_rearrange(int r, double complex *f);
 
 #endif
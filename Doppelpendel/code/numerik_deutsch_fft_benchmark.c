@@ -0,0 +1,115 @@
+/* Christopher Deutsch */
+/* gcc -o fft_benchmark -O2 numerik_deutsch_fft.c numerik_deutsch_fft_benchmark.c -lm */
+/* Mit AVX2-Butterflies und mehreren Threads (OMP_NUM_THREADS):
+ * gcc -o fft_benchmark -O3 -march=native -fopenmp numerik_deutsch_fft.c numerik_deutsch_fft_benchmark.c -lm */
+
+/* Misst die Geschwindigkeit der Radix-2-FFT fuer n = 2^r_min, ..., 2^r_max
+ * und gibt die Rechenleistung in GFLOP/s aus. Als Anzahl der Gleitkomma-
+ * operationen wird wie ueblich 5 n log2(n) angenommen. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <complex.h>
+#include <time.h>
+#include "numerik_deutsch_fft.h"
+
+/* Mindestdauer einer Messung in Sekunden */
+#define BENCHMARK_MIN_TIME 0.25
+
+/* Zeit in Sekunden (monoton) */
+double wall_time(void);
+
+/* Mittlere Dauer einer FFT der Laenge n = plan->n mit "fft_execute" bzw.
+ * "fft_execute_split" (split != 0) */
+double benchmark(FFT_PLAN *plan, int split);
+
+int main(int argc, char **argv) {
+  int r, r_min = 10, r_max = 22;
+  double n, t_complex, t_split, flop;
+  FFT_PLAN *plan;
+  
+  if (argc > 3 || (argc > 1 && sscanf(argv[1], "%d", &r_max) != 1) ||
+      (argc > 2 && sscanf(argv[2], "%d", &r_min) != 1) ||
+      r_min < 1 || r_max < r_min || r_max > 28) {
+    printf("Benutzung:\n"
+           "%s (r_max (r_min))\n\n"
+           "Misst die FFT fuer n = 2^r_min, ..., 2^r_max (Standard: r_min = 10,\n"
+           "r_max = 22, hoechstens 28)\n", argv[0]);
+    return -1;
+  }
+  
+  printf("r\tn\tt_complex[s]\tGFLOP/s\tt_split[s]\tGFLOP/s\n");
+  for (r = r_min; r <= r_max; r++) {
+    plan = fft_plan_alloc(1 << r);
+    if (plan == NULL) {
+      printf("Speicher zur FFT konnte nicht allokiert werden\n");
+      return -1;
+    }
+    
+    t_complex = benchmark(plan, 0);
+    t_split = benchmark(plan, 1);
+    if (t_complex < 0 || t_split < 0) {
+      printf("Speicher fuer die Daten konnte nicht allokiert werden\n");
+      fft_plan_free(plan);
+      return -1;
+    }
+    
+    n = 1 << r;
+    flop = 5 * n * r;
+    printf("%d\t%.0f\t%e\t%.3f\t%e\t%.3f\n", r, n,
+           t_complex, flop / t_complex * 1e-9, t_split, flop / t_split * 1e-9);
+    fflush(stdout);
+    
+    fft_plan_free(plan);
+  }
+  
+  return 0;
+}
+
+double wall_time(void) {
+  struct timespec ts;
+  
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+double benchmark(FFT_PLAN *plan, int split) {
+  int i, count;
+  int n = plan->n;
+  double start, elapsed;
+  double *re, *im;
+  double complex *f;
+  
+  f = malloc(n * sizeof(double complex));
+  if (f == NULL) return -1;
+  
+  /* Im Split-Format liegen Real- und Imaginaerteile hintereinander im selben
+   * Speicher */
+  re = (double *)f;
+  im = re + n;
+  
+  for (i = 0; i < n; i++) {
+    if (split) {
+      re[i] = sin(0.1 * i);
+      im[i] = cos(0.3 * i);
+    } else {
+      f[i] = sin(0.1 * i) + I * cos(0.3 * i);
+    }
+  }
+  
+  /* Wiederholen, bis die Messung lange genug dauert. Da die FFT normiert
+   * ist, bleiben die Werte beschraenkt. */
+  count = 0;
+  start = wall_time();
+  do {
+    if (split) fft_execute_split(plan, re, im);
+    else fft_execute(plan, f);
+    count++;
+    elapsed = wall_time() - start;
+  } while (elapsed < BENCHMARK_MIN_TIME);
+  
+  free(f);
+  
+  return elapsed / count;
+}
@@ -0,0 +1,394 @@
+/* Christopher Deutsch */
+/* gcc -o numerik_map -O2 numerik_deutsch_ode_solver.c numerik_deutsch_trajectory.c numerik_deutsch_pendulum.c numerik_deutsch_map.c -lm */
+/* Parallel (OMP_NUM_THREADS) und vektorisiert (vgl. numerik_deutsch_6.c):
+ * gcc -o numerik_map -O3 -march=native -ffast-math -fno-builtin -fopenmp numerik_deutsch_ode_solver.c numerik_deutsch_trajectory.c numerik_deutsch_pendulum.c numerik_deutsch_map.c -lm */
+
+/* Karte des Doppelpendels ueber die Anfangswinkel: Fuer width x height
+ * Anfangsbedingungen (theta1, theta2) aus [-theta_max, theta_max]^2 (Mitten der
+ * Pixel) und omega1 = omega2 = 0 wird die Zeit bis zum ersten Ueberschlag
+ * eines der beiden Pendel und optional der groesste Lyapunov-Exponent
+ * berechnet. Das Ergebnis wird als Binaerdatei (TRAJ_MAP) gespeichert und kann
+ * mit "numerik_6 -c datei" in eine Texttabelle umgewandelt werden.
+ *
+ * Jeweils RK4_BATCH_BLOCK benachbarte Pixel einer Zeile werden als Block im
+ * "structure of arrays"-Layout gemeinsam mit RK4 entwickelt. Die Bloecke
+ * werden dynamisch an die Threads verteilt: Ein Thread holt sich den naechsten
+ * Block, sobald er fertig ist, sodass Bereiche mit fruehem Ueberschlag (kurze
+ * Rechnung) und ohne Ueberschlag (volle Laenge) die Threads gleichmaessig
+ * auslasten. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "numerik_deutsch_ode_solver.h"
+#include "numerik_deutsch_trajectory.h"
+#include "numerik_deutsch_pendulum.h"
+
+/* Anzahl der Zeitschritte zwischen zwei Renormierungen der Tangentenvektoren
+ * (verhindert einen Ueberlauf bei exponentiellem Wachstum) */
+#define MAP_RENORM 8
+
+static const double map_pi = 3.1415926535897932384626433832795;
+
+/* Beschreibung der Karte:
+ * system: Doppelpendel (dimension 4) bzw. mit Tangentengleichungen
+ *         (dimension 8, Lyapunov-Exponent)
+ * flip_min: Kleinste potentielle Energie (pro Masse und g) eines Zustands mit
+ *           einem Pendel im oberen Totpunkt. Liegt die Anfangsenergie darunter,
+ *           ist kein Ueberschlag moeglich und das Pixel wird ohne
+ *           Lyapunov-Exponent nicht integriert.
+ * flip_time, exponent: Ergebnisse je Pixel (zeilenweise, "exponent" nur bei
+ *                      dimension 8) */
+typedef struct {
+  int width, height;
+  double theta_max;
+  double t, h;
+  
+  ODE_SYSTEM *system;
+  double flip_min;
+  
+  double *flip_time;
+  double *exponent;
+} PENDULUM_MAP;
+
+/* Berechnet die Karte
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Allokierung fehlgeschlagen */
+int compute_map(PENDULUM_MAP *map);
+
+/* Zeit in Sekunden (monoton) */
+double wall_time(void);
+
+int main(int argc, char **argv) {
+  /* Zaehlt die eingelesenen Argumente */
+  int input_cnt;
+  
+  char *prog = argv[0];
+  int opt;
+  
+  /* Lyapunov-Exponent berechnen (Option -l) */
+  int lyapunov = 0;
+  char *filename = "numerik_deutsch_map.bin";
+  
+  /* Groesse der Karte und Bereich der Winkel */
+  int width, height;
+  double theta_max = map_pi;
+  
+  /* physikalische Parameter (Default-Werte) */
+  double g = 9.81;
+  double m1 = 1.0;
+  double m2 = 1.0;
+  double L1 = 1.0;
+  double L2 = 1.0;
+  
+  /* Laenge der Zeitentwicklung und Zeitschritt */
+  double t;
+  double h;
+  
+  double start, elapsed;
+  long count, flipped;
+  long i;
+  double traj_params[10];
+  TRAJECTORY *traj;
+  PENDULUM_MAP map;
+  int ret;
+  
+  ODE_SYSTEM system;
+  double params[4];
+  
+  system.eqns = NULL;
+  system.params = params;
+  system.events = NULL;
+  system.event_count = 0;
+  
+  /* Optionen einlesen */
+  opt = 1;
+  while (opt < argc && argv[opt][0] == '-' &&
+         isalpha((unsigned char)argv[opt][1])) {
+    if (strcmp(argv[opt], "-l") == 0) {
+      lyapunov = 1;
+      opt += 1;
+    } else if (strcmp(argv[opt], "-r") == 0 && opt + 1 < argc &&
+               sscanf(argv[opt+1], "%lf", &theta_max) == 1 && theta_max > 0) {
+      opt += 2;
+    } else if (strcmp(argv[opt], "-o") == 0 && opt + 1 < argc) {
+      filename = argv[opt+1];
+      opt += 2;
+    } else {
+      printf("Unbekannte oder unvollstaendige Option %s\n", argv[opt]);
+      return -1;
+    }
+  }
+  argc -= opt - 1;
+  argv += opt - 1;
+  
+  if (argc != 5 && argc != 10) {
+    printf("Benutzung:\n"
+           "%s [-l] [-r theta_max] [-o datei] width height t h (g m1 m2 L1 L2)\n\n"
+           "Die Klammern enthalten optionale Argumente\n"
+           "-l: zusaetzlich den groessten Lyapunov-Exponenten berechnen (Tangenten-\n"
+           "    gleichungen, ohne -l endet die Integration eines Pixels beim\n"
+           "    ersten Ueberschlag)\n"
+           "-r theta_max: Bereich der Anfangswinkel [-theta_max, theta_max]\n"
+           "              (Standard: Pi)\n"
+           "-o datei: Name der Binaerdatei (Standard: numerik_deutsch_map.bin)\n"
+           "width, height: Anzahl der Pixel fuer theta1 bzw. theta2\n"
+           "t: Laenge der Zeitentwicklung\n"
+           "h: Zeitschritt\n"
+           "g: Gravitationsbeschleunigung\n"
+           "m: Massen\n"
+           "L1: Laengen der Pendelstange\n\n"
+           "Beispielaufruf:\n"
+           "%s 1000 1000 20 0.005\n"
+           "Zeit bis zum Ueberschlag fuer 1000 x 1000 Anfangsbedingungen ueber\n"
+           "hoechstens 20 s in Schritten von 0.005 s\n\n",
+           prog, prog);
+    return -1;
+  }
+  
+  input_cnt = 0;
+  input_cnt += sscanf(argv[1], "%i", &width);
+  input_cnt += sscanf(argv[2], "%i", &height);
+  input_cnt += sscanf(argv[3], "%lf", &t);
+  input_cnt += sscanf(argv[4], "%lf", &h);
+  if (argc == 10) {
+    input_cnt += sscanf(argv[5], "%lf", &g);
+    input_cnt += sscanf(argv[6], "%lf", &m1);
+    input_cnt += sscanf(argv[7], "%lf", &m2);
+    input_cnt += sscanf(argv[8], "%lf", &L1);
+    input_cnt += sscanf(argv[9], "%lf", &L2);
+  }
+  if (input_cnt != argc - 1 || width < 1 || height < 1 || t <= 0 || h <= 0) {
+    printf("Es konnten nicht alle Argumente eingelesen werden\n");
+    return -1;
+  }
+  
+  params[0] = g;
+  params[1] = m2 / (m1 + m2);
+  params[2] = L1;
+  params[3] = L2;
+  
+  if (lyapunov) {
+    system.dimension = 8;
+    system.rhs = double_pendulum_tangent;
+    system.rhs_batch = double_pendulum_tangent_batch;
+  } else {
+    system.dimension = 4;
+    system.rhs = double_pendulum;
+    system.rhs_batch = double_pendulum_batch;
+  }
+  
+  printf("Karte mit %i x %i Pixeln, theta1, theta2 in [%.4f, %.4f] rad\n"
+         "t = %.3f s;  h = %f s\n"
+         "g = %.3f m s^-2;  m1 = %.3f kg;  m2 = %.3f kg\n"
+         "L1 = %.3f m;  L2 = %.3f m\n",
+         width, height, -theta_max, theta_max, t, h, g, m1, m2, L1, L2);
+#ifdef _OPENMP
+  printf("Threads: %i\n", omp_get_max_threads());
+#endif
+  
+  /* Ergebnisse werden direkt in die Spalten der Binaerdatei geschrieben */
+  count = (long)width * height;
+  traj_params[0] = width;
+  traj_params[1] = height;
+  traj_params[2] = theta_max;
+  traj_params[3] = t;
+  traj_params[4] = h;
+  traj_params[5] = g;
+  traj_params[6] = m1;
+  traj_params[7] = m2;
+  traj_params[8] = L1;
+  traj_params[9] = L2;
+  traj = traj_create(filename, TRAJ_MAP, lyapunov ? 2 : 1, count,
+                     traj_params, 10);
+  if (traj == NULL) {
+    printf("Konnte die Datei %s nicht erstellen\n", filename);
+    return -1;
+  }
+  
+  map.width = width;
+  map.height = height;
+  map.theta_max = theta_max;
+  map.t = t;
+  map.h = h;
+  map.system = &system;
+  map.flip_min = -fabs(L1 - params[1] * L2);
+  map.flip_time = traj_column(traj, 0);
+  map.exponent = lyapunov ? traj_column(traj, 1) : NULL;
+  
+  start = wall_time();
+  ret = compute_map(&map);
+  elapsed = wall_time() - start;
+  if (ret != 0) {
+    printf("Speicher fuer die Integration konnte nicht allokiert werden\n");
+    traj_close(traj);
+    return -1;
+  }
+  
+  flipped = 0;
+  for (i = 0; i < count; i++) {
+    if (map.flip_time[i] >= 0) flipped++;
+  }
+  traj->header->valid = count;
+  if (traj_close(traj) != 0) {
+    printf("Fehler beim Schreiben der Datei %s\n", filename);
+    return -1;
+  }
+  
+  printf("Fertig nach %.2f s (%.0f Pixel/s), Ueberschlag bei %li von %li "
+         "Pixeln\nGespeichert in \"%s\"\n",
+         elapsed, count / elapsed, flipped, count, filename);
+  
+  return 0;
+}
+
+/* Abstand zum Ueberschlag: pi - max(|theta_1|, |theta_2|) */
+static double flip_distance(double theta_1, double theta_2) {
+  return map_pi - fmax(fabs(theta_1), fabs(theta_2));
+}
+
+/* Berechnet die "size" (<= RK4_BATCH_BLOCK) Pixel ab "first". "y" bietet
+ * Platz fuer zwei Zustaende des Blocks im "structure of arrays"-Layout. */
+static void map_block(PENDULUM_MAP *map, RK4_BATCH_WORKSPACE *workspace,
+                      double *y, long first, int size) {
+  int i, j, k;
+  int dimension = map->system->dimension;
+  int t_steps = map->t / map->h;
+  int active;
+  long pixel;
+  double h = map->h;
+  double *params = map->system->params;
+  double theta_1, theta_2, distance, distance_next, norm;
+  double *y_next = y + dimension * size;
+  double *swap_temp;
+  
+  /* Pixel ohne (weiteren) moeglichen Ueberschlag und Summe der Logarithmen
+   * der Renormierungsfaktoren */
+  int done[RK4_BATCH_BLOCK];
+  double log_sum[RK4_BATCH_BLOCK];
+  
+  active = 0;
+  for (k = 0; k < size; k++) {
+    pixel = first + k;
+    theta_1 = map->theta_max * (2.0 * (pixel % map->width + 0.5) / map->width
+                                - 1);
+    theta_2 = map->theta_max * (2.0 * (pixel / map->width + 0.5) / map->height
+                                - 1);
+    y[k] = theta_1;
+    y[size + k] = 0;
+    y[2 * size + k] = theta_2;
+    y[3 * size + k] = 0;
+  
+    /* Tangentenvektor der Laenge 1 */
+    if (dimension == 8) {
+      for (i = 4; i < 8; i++) {
+        y[i * size + k] = 0.5;
+      }
+    }
+    log_sum[k] = 0;
+  
+    /* Energieerhaltung: V / (M g) = -L_1 cos(theta_1) - mu L_2 cos(theta_2) */
+    map->flip_time[pixel] = -1;
+    done[k] = (-params[2] * cos(theta_1) - params[1] * params[3] * cos(theta_2)
+               < map->flip_min);
+    if (!done[k]) active++;
+  }
+  
+  for (j = 1; j <= t_steps; j++) {
+    if (dimension == 4 && active == 0) break;
+  
+    rk4_evolve_batch(map->system, workspace, y, (j - 1) * h, h, y_next, size);
+  
+    /* Ueberschlag: Zeitpunkt durch lineare Interpolation im Schritt */
+    for (k = 0; k < size; k++) {
+      if (done[k]) continue;
+      distance_next = flip_distance(y_next[k], y_next[2 * size + k]);
+      if (distance_next <= 0) {
+        distance = flip_distance(y[k], y[2 * size + k]);
+        map->flip_time[first + k] =
+          (j - 1) * h + h * distance / (distance - distance_next);
+        done[k] = 1;
+        active--;
+      }
+    }
+  
+    /* Renormierung der Tangentenvektoren */
+    if (dimension == 8 && (j % MAP_RENORM == 0 || j == t_steps)) {
+      for (k = 0; k < size; k++) {
+        norm = 0;
+        for (i = 4; i < 8; i++) {
+          norm += y_next[i * size + k] * y_next[i * size + k];
+        }
+        norm = sqrt(norm);
+        log_sum[k] += log(norm);
+        for (i = 4; i < 8; i++) {
+          y_next[i * size + k] /= norm;
+        }
+      }
+    }
+  
+    swap_temp = y;
+    y = y_next;
+    y_next = swap_temp;
+  }
+  
+  if (dimension == 8) {
+    for (k = 0; k < size; k++) {
+      map->exponent[first + k] = (t_steps > 0) ? log_sum[k] / (t_steps * h) : 0;
+    }
+  }
+}
+
+int compute_map(PENDULUM_MAP *map) {
+  int dimension = map->system->dimension;
+  long blocks_per_row = (map->width + RK4_BATCH_BLOCK - 1) / RK4_BATCH_BLOCK;
+  long blocks = blocks_per_row * map->height;
+  int failed = 0;
+  
+  /* Bloecke enden am Zeilenende, damit benachbarte Pixel (aehnliche Dauer
+   * bis zum Ueberschlag) gemeinsam entwickelt werden */
+  #pragma omp parallel
+  {
+    long b, first;
+    int column, size;
+    double *y;
+    RK4_BATCH_WORKSPACE *workspace;
+  
+    workspace = rk4_batch_workspace_alloc(dimension, RK4_BATCH_BLOCK);
+    y = malloc(2 * dimension * RK4_BATCH_BLOCK * sizeof(double));
+    if (workspace == NULL || y == NULL) {
+      #pragma omp atomic write
+      failed = 1;
+    }
+  
+    #pragma omp for schedule(dynamic)
+    for (b = 0; b < blocks; b++) {
+      if (workspace == NULL || y == NULL) continue;
+  
+      column = (b % blocks_per_row) * RK4_BATCH_BLOCK;
+      first = (b / blocks_per_row) * map->width + column;
+      size = (map->width - column < RK4_BATCH_BLOCK) ?
+             map->width - column : RK4_BATCH_BLOCK;
+      map_block(map, workspace, y, first, size);
+    }
+  
+    free(y);
+    if (workspace != NULL) rk4_batch_workspace_free(workspace);
+  }
+  
+  return failed ? -1 : 0;
+}
+
+double wall_time(void) {
+  struct timespec ts;
+  
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
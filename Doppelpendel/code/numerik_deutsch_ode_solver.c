@@ -1,6 +1,7 @@
 #include "numerik_deutsch_ode_solver.h"
 #include <stdlib.h>
 #include <assert.h>
+#include <math.h>
 
 RK4_WORKSPACE *rk4_workspace_alloc(int dimension) {
   RK4_WORKSPACE *ret = malloc(sizeof(RK4_WORKSPACE));
@@ -29,12 +30,25 @@ void rk4_workspace_free(RK4_WORKSPACE *workspace) {
   free(workspace);
 }
 
+void ode_system_eval(ODE_SYSTEM *system, double t, const double *y,
+                     double *dydt) {
+  int i;
+  
+  /* Gesamte rechte Seite in einem Aufruf */
+  if (system->rhs != NULL) {
+    system->rhs(t, y, dydt, system->params);
+    return;
+  }
+  
+  /* Einzelne Gleichungen */
+  for (i = 0; i < system->dimension; i++) {
+    dydt[i] = system->eqns[i].dydt(t, (double *)y, system->eqns[i].params);
+  }
+}
+
 void rk4_evolve(ODE_SYSTEM *system, RK4_WORKSPACE *workspace,
                double *y0, double t0, double h, double *y1) {
-  int i, j;
-  
-  double (*f_i)(double t, double *y, double *params);
-  double *params;
+  int i;
   int dimension = system->dimension;
   
   /* Benoetigte temporaere Arrays */
@@ -46,57 +60,35 @@ void rk4_evolve(ODE_SYSTEM *system, RK4_WORKSPACE *workspace,
   
   assert(system->dimension == workspace->dimension);
   
+  /* Die Zwischenwerte "y_temp" werden pro Stufe nur einmal fuer alle
+   * Gleichungen berechnet, die k_i enthalten hier zunaechst f(t, y) und werden
+   * erst bei der Berechnung von y1 mit h multipliziert */
+  
   /* Berechnung von k_1 */
-  for (i = 0; i < dimension; i++) {
-    f_i = (system->eqns[i]).dydt;
-    params = (system->eqns[i]).params;
-    
-    k_1[i] = h * f_i(t0, y0, params);
-  }
+  ode_system_eval(system, t0, y0, k_1);
   
-  /* Berechnung von k_2 */
+  /* Berechnung von k_2 mit "y_temp = y0 + 0.5 * h * k_1" */
   for (i = 0; i < dimension; i++) {
-    f_i = (system->eqns[i]).dydt;
-    params = (system->eqns[i]).params;
-    
-    /* Berechne "y_temp = y0 + 0.5 * k_1" fuer alle Gleichungen */
-    for (j = 0; j < dimension; j++) {
-      y_temp[j] = y0[j] + 0.5 * k_1[j];
-    }
-    
-    k_2[i] = h * f_i(t0 + 0.5 * h, y_temp, params);
+    y_temp[i] = y0[i] + 0.5 * h * k_1[i];
   }
+  ode_system_eval(system, t0 + 0.5 * h, y_temp, k_2);
   
-  /* Berechnung von k_3 */
+  /* Berechnung von k_3 mit "y_temp = y0 + 0.5 * h * k_2" */
   for (i = 0; i < dimension; i++) {
-    f_i = (system->eqns[i]).dydt;
-    params = (system->eqns[i]).params;
-    
-    /* Berechne y_temp = y0 + 0.5 * k_2 fuer alle Gleichungen */
-    for (j = 0; j < dimension; j++) {
-      y_temp[j] = y0[j] + 0.5 * k_2[j];
-    }
-    
-    k_3[i] = h * f_i(t0 + 0.5 * h, y_temp, params);
+    y_temp[i] = y0[i] + 0.5 * h * k_2[i];
   }
+  ode_system_eval(system, t0 + 0.5 * h, y_temp, k_3);
   
-  /* Berechnung von k_4 */
+  /* Berechnung von k_4 mit "y_temp = y0 + h * k_3" */
   for (i = 0; i < dimension; i++) {
-    f_i = (system->eqns[i]).dydt;
-    params = (system->eqns[i]).params;
-    
-    /* Berechne y_temp = y0 + k_3 fuer alle Gleichungen */
-    for (j = 0; j < dimension; j++) {
-      y_temp[j] = y0[j] + k_3[j];
-    }
-    
-    k_4[i] = h * f_i(t0 + 0.5 * h, y_temp, params);
+    y_temp[i] = y0[i] + h * k_3[i];
   }
+  ode_system_eval(system, t0 + h, y_temp, k_4);
   
   /* Berechnet den Loesungsvektor "y1" nach der Zeitentwicklung um "h" durch:
    * y_(n+1) = y_n + h/6 * (k1 + 2*k2 + 2*k3 + k4) fuer jede Gleichung */
   for (i = 0; i < dimension; i++) {
-    y1[i] = y0[i] + (k_1[i] + 2 * k_2[i] + 2 * k_3[i] + k_4[i]) / 6.0;
+    y1[i] = y0[i] + h * (k_1[i] + 2 * k_2[i] + 2 * k_3[i] + k_4[i]) / 6.0;
   }
 }
 
@@ -151,25 +143,257 @@ void ode_solution_free(ODE_SOLUTION *sol) {
   free(sol);
 }
 
-ODE_SOLUTION *rk4_solve(ODE_SYSTEM *system, double *y0, double t0, double t1, double h) {
-  int i, j;
+/* Uebergibt den j-ten Loesungspunkt an alle Beobachter, die ihn gemaess ihrem
+ * "every" erhalten. Gibt ungleich 0 zurueck, wenn ein Beobachter abbricht. */
+static int ode_notify(ODE_OBSERVER *observers, int observer_count, int j,
+                      double t, const double *y, int dimension) {
+  int i;
+  
+  for (i = 0; i < observer_count; i++) {
+    if (j % observers[i].every == 0 &&
+        observers[i].observe(t, y, dimension, observers[i].data) != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Uebergibt den Zustand nach "step" Schritten an den Checkpoint (vgl.
+ * ODE_STATE). Gibt ungleich 0 zurueck, wenn das Speichern fehlschlaegt. */
+static int ode_checkpoint_save(ODE_CHECKPOINT *checkpoint, int dimension,
+                               long step, double t, double h, double *y,
+                               double *dydt, const long *stats) {
+  int i;
+  ODE_STATE state;
+  
+  state.dimension = dimension;
+  state.step = step;
+  state.t = t;
+  state.h = h;
+  state.y = y;
+  state.dydt = dydt;
+  for (i = 0; i < 3; i++) {
+    state.stats[i] = (stats != NULL) ? stats[i] : 0;
+  }
+  
+  return checkpoint->save(&state, checkpoint->data);
+}
+
+/* Beobachter, der die Loesungspunkte der Reihe nach in ein ODE_SOLUTION-
+ * Objekt eintraegt (fuer rk4_solve und rkdp45_solve) */
+typedef struct {
+  ODE_SOLUTION *sol;
+  int index;
+} ODE_STORE;
+
+static int ode_store(double t, const double *y, int dimension, void *data) {
+  int i;
+  ODE_STORE *store = data;
+  
+  store->sol->t[store->index] = t;
+  for (i = 0; i < dimension; i++) {
+    store->sol->y[i][store->index] = y[i];
+  }
+  store->index++;
+  
+  return 0;
+}
+
+/* Zustand der Ereignissuche waehrend eines Loesungsvorgangs:
+ * g, g_new: Werte der Ereignisfunktionen am Anfang und Ende des Schrittes
+ * theta: relative Position der Nulldurchgaenge im Schritt (-1: keiner)
+ * y: interpolierter Zustand
+ * f_0, f_1: Ableitungen am Anfang und Ende des Schrittes (Hermite) */
+typedef struct {
+  double *g;
+  double *g_new;
+  double *theta;
+  double *y;
+  double *f_0;
+  double *f_1;
+} ODE_EVENT_STATE;
+
+/* Interpolation innerhalb eines Schrittes: Zustand bei t0 + theta * h */
+typedef void (*ODE_INTERPOLATE)(double theta, double *y, void *data);
+
+/* Allokiert den Zustand der Ereignissuche und wertet die Ereignisfunktionen
+ * am Anfang aus. Rueckgabewert -1, wenn die Allokierung fehlschlaegt. */
+static int ode_events_init(ODE_SYSTEM *system, ODE_EVENT_STATE *state,
+                           double t0, const double *y0) {
+  int e;
+  int n = system->event_count;
+  int dimension = system->dimension;
+  
+  state->g = NULL;
+  if (n <= 0) return 0;
+  
+  state->g = malloc((3 * n + 3 * dimension) * sizeof(double));
+  if (state->g == NULL) return -1;
+  state->g_new = state->g + n;
+  state->theta = state->g_new + n;
+  state->y = state->theta + n;
+  state->f_0 = state->y + dimension;
+  state->f_1 = state->f_0 + dimension;
+  
+  for (e = 0; e < n; e++) {
+    state->g[e] = system->events[e].g(t0, y0, system->events[e].params);
+  }
+  return 0;
+}
+
+static void ode_events_free(ODE_EVENT_STATE *state) {
+  free(state->g);
+}
+
+/* Wertet die Ereignisfunktionen am Ende des Schrittes (t1, y1) aus und gibt
+ * die Anzahl der Vorzeichenwechsel (in der gewuenschten Richtung) zurueck.
+ * Ein Wert g = 0 am Anfang des Schrittes zaehlt nicht, damit ein Ereignis
+ * genau auf dem Gitter nicht doppelt gemeldet wird. */
+static int ode_events_detect(ODE_SYSTEM *system, ODE_EVENT_STATE *state,
+                             double t1, const double *y1) {
+  int e, count = 0;
+  double g_0, g_1;
+  ODE_EVENT *event;
+  
+  for (e = 0; e < system->event_count; e++) {
+    event = system->events + e;
+    g_0 = state->g[e];
+    g_1 = state->g_new[e] = event->g(t1, y1, event->params);
+    
+    state->theta[e] = -1;
+    if ((g_0 < 0 && g_1 >= 0 && event->direction >= 0) ||
+        (g_0 > 0 && g_1 <= 0 && event->direction <= 0)) {
+      state->theta[e] = 0;
+      count++;
+    }
+  }
+  return count;
+}
+
+/* Bestimmt die Nulldurchgaenge im Schritt von t0 nach t0 + h (Illinois-
+ * Variante der Regula falsi auf der Interpolation) und meldet sie in
+ * zeitlicher Reihenfolge. Bei einem terminalen Ereignis wird dessen Zeitpunkt
+ * in "t_stop" gespeichert.
+ * Rueckgabewert:
+ * 0: weiter integrieren
+ * 1: Abbruch durch einen Beobachter
+ * 2: terminales Ereignis */
+static int ode_events_locate(ODE_SYSTEM *system, ODE_EVENT_STATE *state,
+                             double t0, double h, ODE_INTERPOLATE interpolate,
+                             void *data, double *t_stop) {
+  int e, first, iter, side;
+  int dimension = system->dimension;
+  double a, b, c, g_a, g_b, g_c;
+  ODE_EVENT *event;
+  
+  for (e = 0; e < system->event_count; e++) {
+    if (state->theta[e] < 0) continue;
+    event = system->events + e;
+    
+    a = 0, g_a = state->g[e];
+    b = 1, g_b = state->g_new[e];
+    c = 1;
+    side = 0;
+    for (iter = 0; iter < 100 && b - a > ODE_EVENT_TOL; iter++) {
+      c = (a * g_b - b * g_a) / (g_b - g_a);
+      interpolate(c, state->y, data);
+      g_c = event->g(t0 + c * h, state->y, event->params);
+      if (g_c == 0) break;
+      
+      /* Bleibt ein Intervallende zweimal hintereinander stehen, wird sein
+       * Funktionswert halbiert (Illinois) */
+      if ((g_c > 0) == (g_b > 0)) {
+        b = c, g_b = g_c;
+        if (side == -1) g_a *= 0.5;
+        side = -1;
+      } else {
+        a = c, g_a = g_c;
+        if (side == 1) g_b *= 0.5;
+        side = 1;
+      }
+    }
+    state->theta[e] = c;
+  }
+  
+  /* Meldung in zeitlicher Reihenfolge */
+  for (;;) {
+    first = -1;
+    for (e = 0; e < system->event_count; e++) {
+      if (state->theta[e] >= 0 &&
+          (first < 0 || state->theta[e] < state->theta[first])) {
+        first = e;
+      }
+    }
+    if (first < 0) break;
+    
+    event = system->events + first;
+    interpolate(state->theta[first], state->y, data);
+    if (event->observe != NULL &&
+        event->observe(t0 + state->theta[first] * h, state->y, dimension,
+                       event->data) != 0) {
+      return 1;
+    }
+    if (event->terminal) {
+      *t_stop = t0 + state->theta[first] * h;
+      return 2;
+    }
+    state->theta[first] = -1;
+  }
+  return 0;
+}
+
+/* Uebernimmt die Werte am Ende des Schrittes als Anfangswerte des naechsten */
+static void ode_events_advance(ODE_SYSTEM *system, ODE_EVENT_STATE *state) {
+  int e;
+  
+  for (e = 0; e < system->event_count; e++) {
+    state->g[e] = state->g_new[e];
+  }
+}
+
+/* Kubische Hermite-Interpolation eines RK4-Schrittes aus y und f = y' an
+ * beiden Enden */
+typedef struct {
+  int dimension;
+  double h;
+  const double *y_0;
+  const double *y_1;
+  const double *f_0;
+  const double *f_1;
+} ODE_HERMITE;
+
+static void ode_hermite(double theta, double *y, void *data) {
+  int i;
+  ODE_HERMITE *hermite = data;
+  double t2 = theta * theta, t3 = t2 * theta;
+  double h00 = 2 * t3 - 3 * t2 + 1, h10 = t3 - 2 * t2 + theta;
+  double h01 = -2 * t3 + 3 * t2, h11 = t3 - t2;
+  
+  for (i = 0; i < hermite->dimension; i++) {
+    y[i] = h00 * hermite->y_0[i] + h01 * hermite->y_1[i]
+           + hermite->h * (h10 * hermite->f_0[i] + h11 * hermite->f_1[i]);
+  }
+}
+
+int rk4_solve_observed(ODE_SYSTEM *system, double *y0, double t0, double t1,
+                       double h, ODE_OBSERVER *observers, int observer_count,
+                       ODE_CHECKPOINT *checkpoint) {
+  int i;
   int dimension = system->dimension;
   int t_steps = (t1 - t0) / h;
+  int ret = 0;
+  int first = 1;
+  ODE_STATE *resume = (checkpoint != NULL) ? checkpoint->resume : NULL;
   
-  ODE_SOLUTION *sol;
   RK4_WORKSPACE *workspace;
   double *y, *y_next, *swap_temp;
-  
-  /* Allokiert Speicher fuer die Loesung (t_steps + 1, da die Anfangsbedingung
-   * mitgespeichert wird) */
-  sol = ode_solution_alloc(dimension, t_steps + 1);
+  ODE_EVENT_STATE events;
+  ODE_HERMITE hermite;
+  double t_stop;
   
   /* Workspace */
   workspace = rk4_workspace_alloc(dimension);
-  if (workspace == NULL) {
-    ode_solution_free(sol);
-    return NULL;
-  }
+  if (workspace == NULL) return -1;
   
   /* Temporaere Loesung */
   y = malloc(dimension * sizeof(double));
@@ -177,35 +401,942 @@ ODE_SOLUTION *rk4_solve(ODE_SYSTEM *system, double *y0, double t0, double t1, do
   if (y == NULL || y_next == NULL) {
     free(y);
     free(y_next);
-    ode_solution_free(sol);
     rk4_workspace_free(workspace);
+    return -1;
+  }
+  
+  /* Anfangsbedingung bzw. fortgesetzter Zustand */
+  if (resume != NULL) {
+    for (i = 0; i < dimension; i++) {
+      y[i] = resume->y[i];
+    }
+    first = resume->step + 1;
+  } else {
+    for (i = 0; i < dimension; i++) {
+      y[i] = y0[i];
+    }
+  }
+  if (ode_events_init(system, &events, t0 + (first - 1) * h,
+                      (resume != NULL) ? resume->y : y0) != 0) {
+    free(y);
+    free(y_next);
+    rk4_workspace_free(workspace);
+    return -1;
+  }
+  if (resume == NULL &&
+      ode_notify(observers, observer_count, 0, t0, y, dimension) != 0) {
+    ret = 1;
+  }
+  
+  for (i = first; i <= t_steps && ret == 0; i++) {
+    rk4_evolve(system, workspace, y, t0 + (i - 1) * h, h, y_next);
+    
+    /* Ereignisse im Schritt: Die Ableitungen fuer die Interpolation werden
+     * nur bei einem Vorzeichenwechsel berechnet */
+    if (system->event_count > 0) {
+      if (ode_events_detect(system, &events, t0 + i * h, y_next) > 0) {
+        ode_system_eval(system, t0 + (i - 1) * h, y, events.f_0);
+        ode_system_eval(system, t0 + i * h, y_next, events.f_1);
+        hermite.dimension = dimension;
+        hermite.h = h;
+        hermite.y_0 = y;
+        hermite.y_1 = y_next;
+        hermite.f_0 = events.f_0;
+        hermite.f_1 = events.f_1;
+        ret = ode_events_locate(system, &events, t0 + (i - 1) * h, h,
+                                ode_hermite, &hermite, &t_stop);
+        if (ret != 0) break;
+      }
+      ode_events_advance(system, &events);
+    }
+    
+    /* Tausche Pointer um kopieren der einzelnen Werte zu vermeiden */
+    swap_temp = y;
+    y = y_next;
+    y_next = swap_temp;
+    
+    /* Loesung weitergeben */
+    if (ode_notify(observers, observer_count, i, t0 + i * h, y,
+                   dimension) != 0) {
+      ret = 1;
+    }
+    
+    if (ret == 0 && checkpoint != NULL && checkpoint->every > 0 &&
+        (i % checkpoint->every == 0 || i == t_steps) &&
+        ode_checkpoint_save(checkpoint, dimension, i, t0 + i * h, h, y,
+                            NULL, NULL) != 0) {
+      ret = 1;
+    }
+  }
+  
+  ode_events_free(&events);
+  free(y);
+  free(y_next);
+  rk4_workspace_free(workspace);
+  return ret;
+}
+
+ODE_SOLUTION *rk4_solve(ODE_SYSTEM *system, double *y0, double t0, double t1, double h) {
+  int t_steps = (t1 - t0) / h;
+  int ret;
+  ODE_STORE store;
+  ODE_OBSERVER observer;
+  
+  /* Allokiert Speicher fuer die Loesung (t_steps + 1, da die Anfangsbedingung
+   * mitgespeichert wird) */
+  store.sol = ode_solution_alloc(system->dimension, t_steps + 1);
+  store.index = 0;
+  if (store.sol == NULL) return NULL;
+  
+  observer.observe = ode_store;
+  observer.data = &store;
+  observer.every = 1;
+  
+  ret = rk4_solve_observed(system, y0, t0, t1, h, &observer, 1, NULL);
+  if (ret != 0 && ret != 2) {
+    ode_solution_free(store.sol);
     return NULL;
   }
   
-  /* Anfangsbedingung eintragen */
-  sol->t[0] = t0;
+  /* Nach einem terminalen Ereignis enthaelt die Loesung weniger Punkte */
+  store.sol->t_count = store.index;
+  
+  return store.sol;
+}
+
+RK4_BATCH_WORKSPACE *rk4_batch_workspace_alloc(int dimension, int count) {
+  RK4_BATCH_WORKSPACE *ret = malloc(sizeof(RK4_BATCH_WORKSPACE));
+  if (ret == NULL) return NULL;
+  
+  ret->dimension = dimension;
+  ret->count = count;
+  
+  /* Ein Speicherblock fuer 5 Arrays mit je "dimension * count" Elementen und
+   * die beiden Vektoren fuer ein einzelnes System */
+  ret->k_1 = malloc((5 * count + 2) * dimension * sizeof(double));
+  if (ret->k_1 == NULL) {
+    free(ret);
+    return NULL;
+  }
+  
+  ret->k_2 = ret->k_1 + dimension * count;
+  ret->k_3 = ret->k_2 + dimension * count;
+  ret->k_4 = ret->k_3 + dimension * count;
+  ret->y = ret->k_4 + dimension * count;
+  ret->lane = ret->y + dimension * count;
+  
+  return ret;
+}
+
+void rk4_batch_workspace_free(RK4_BATCH_WORKSPACE *workspace) {
+  free(workspace->k_1);
+  free(workspace);
+}
+
+/* Wertet die rechte Seite fuer "count" Systeme im "structure of arrays"-Layout
+ * aus. Ohne "rhs_batch" wird jedes System einzeln in "lane" umkopiert. */
+static void ode_system_eval_batch(ODE_SYSTEM *system, RK4_BATCH_WORKSPACE *space,
+                                  double t, const double *y, double *dydt,
+                                  int count) {
+  int i, k;
+  int dimension = system->dimension;
+  double *y_lane = space->lane;
+  double *f_lane = space->lane + dimension;
+  
+  if (system->rhs_batch != NULL) {
+    system->rhs_batch(t, y, dydt, count, system->params);
+    return;
+  }
+  
+  for (k = 0; k < count; k++) {
+    for (i = 0; i < dimension; i++) {
+      y_lane[i] = y[i * count + k];
+    }
+    ode_system_eval(system, t, y_lane, f_lane);
+    for (i = 0; i < dimension; i++) {
+      dydt[i * count + k] = f_lane[i];
+    }
+  }
+}
+
+void rk4_evolve_batch(ODE_SYSTEM *system, RK4_BATCH_WORKSPACE *workspace,
+                      double *y0, double t0, double h, double *y1, int count) {
+  int i;
+  /* Alle Systeme eines Blocks liegen hintereinander, sodass die Stufen als
+   * eine Schleife ueber "n" Elemente berechnet werden koennen */
+  int n = system->dimension * count;
+  
+  double *y_temp = workspace->y;
+  double *k_1 = workspace->k_1;
+  double *k_2 = workspace->k_2;
+  double *k_3 = workspace->k_3;
+  double *k_4 = workspace->k_4;
+  
+  assert(system->dimension == workspace->dimension);
+  assert(count <= workspace->count);
+  
+  ode_system_eval_batch(system, workspace, t0, y0, k_1, count);
+  
+  for (i = 0; i < n; i++) {
+    y_temp[i] = y0[i] + 0.5 * h * k_1[i];
+  }
+  ode_system_eval_batch(system, workspace, t0 + 0.5 * h, y_temp, k_2, count);
+  
+  for (i = 0; i < n; i++) {
+    y_temp[i] = y0[i] + 0.5 * h * k_2[i];
+  }
+  ode_system_eval_batch(system, workspace, t0 + 0.5 * h, y_temp, k_3, count);
+  
+  for (i = 0; i < n; i++) {
+    y_temp[i] = y0[i] + h * k_3[i];
+  }
+  ode_system_eval_batch(system, workspace, t0 + h, y_temp, k_4, count);
+  
+  for (i = 0; i < n; i++) {
+    y1[i] = y0[i] + h * (k_1[i] + 2 * k_2[i] + 2 * k_3[i] + k_4[i]) / 6.0;
+  }
+}
+
+int rk4_solve_batch(ODE_SYSTEM *system, int count, double *y0,
+                    double t0, double t1, double h, double *y1) {
+  int dimension = system->dimension;
+  int t_steps = (t1 - t0) / h;
+  int blocks = (count + RK4_BATCH_BLOCK - 1) / RK4_BATCH_BLOCK;
+  int failed = 0;
+  
+  /* Jeder Thread arbeitet mit eigenem Workspace auf ganzen Bloecken */
+  #pragma omp parallel
+  {
+    int b, i, k, j, first, size;
+    double t;
+    double *y, *y_next, *swap_temp;
+    RK4_BATCH_WORKSPACE *workspace;
+    
+    workspace = rk4_batch_workspace_alloc(dimension, RK4_BATCH_BLOCK);
+    y = malloc(2 * dimension * RK4_BATCH_BLOCK * sizeof(double));
+    if (workspace == NULL || y == NULL) {
+      #pragma omp atomic write
+      failed = 1;
+    }
+    
+    #pragma omp for schedule(dynamic)
+    for (b = 0; b < blocks; b++) {
+      if (workspace == NULL || y == NULL) continue;
+      
+      first = b * RK4_BATCH_BLOCK;
+      size = (count - first < RK4_BATCH_BLOCK) ? count - first : RK4_BATCH_BLOCK;
+      y_next = y + dimension * size;
+      
+      /* Anfangsbedingungen in das "structure of arrays"-Layout umordnen */
+      for (k = 0; k < size; k++) {
+        for (i = 0; i < dimension; i++) {
+          y[i * size + k] = y0[(first + k) * dimension + i];
+        }
+      }
+      
+      t = t0;
+      for (j = 1; j <= t_steps; j++) {
+        rk4_evolve_batch(system, workspace, y, t, h, y_next, size);
+        t = t0 + j * h;
+        
+        swap_temp = y;
+        y = y_next;
+        y_next = swap_temp;
+      }
+      
+      /* Endzustaende zurueck in das Array "y1" */
+      for (k = 0; k < size; k++) {
+        for (i = 0; i < dimension; i++) {
+          y1[(first + k) * dimension + i] = y[i * size + k];
+        }
+      }
+      
+      /* "y" wieder auf den Anfang des allokierten Speicherblocks setzen */
+      if (y > y_next) y = y_next;
+    }
+    
+    free(y);
+    if (workspace != NULL) rk4_batch_workspace_free(workspace);
+  }
+  
+  return failed ? -1 : 0;
+}
+
+/* Koeffizienten des Dormand-Prince-Verfahrens (Butcher-Tableau) */
+static const double dp_c2 = 1.0/5, dp_c3 = 3.0/10, dp_c4 = 4.0/5, dp_c5 = 8.0/9;
+
+static const double dp_a21 = 1.0/5;
+static const double dp_a31 = 3.0/40, dp_a32 = 9.0/40;
+static const double dp_a41 = 44.0/45, dp_a42 = -56.0/15, dp_a43 = 32.0/9;
+static const double dp_a51 = 19372.0/6561, dp_a52 = -25360.0/2187,
+                    dp_a53 = 64448.0/6561, dp_a54 = -212.0/729;
+static const double dp_a61 = 9017.0/3168, dp_a62 = -355.0/33,
+                    dp_a63 = 46732.0/5247, dp_a64 = 49.0/176,
+                    dp_a65 = -5103.0/18656;
+/* Gewichte der Loesung 5. Ordnung (gleichzeitig letzte Zeile der Matrix) */
+static const double dp_a71 = 35.0/384, dp_a73 = 500.0/1113, dp_a74 = 125.0/192,
+                    dp_a75 = -2187.0/6784, dp_a76 = 11.0/84;
+
+/* Differenz der Gewichte 5. und 4. Ordnung zur Fehlerschaetzung */
+static const double dp_e1 = 71.0/57600, dp_e3 = -71.0/16695,
+                    dp_e4 = 71.0/1920, dp_e5 = -17253.0/339200,
+                    dp_e6 = 22.0/525, dp_e7 = -1.0/40;
+
+/* Koeffizienten der stetigen Fortsetzung (nach Hairer) */
+static const double dp_d1 = -12715105075.0/11282082432,
+                    dp_d3 = 87487479700.0/32700410799,
+                    dp_d4 = -10690763975.0/1880347072,
+                    dp_d5 = 701980252875.0/199316789632,
+                    dp_d6 = -1453857185.0/822651844,
+                    dp_d7 = 69997945.0/29380423;
+
+RKDP45_WORKSPACE *rkdp45_workspace_alloc(int dimension) {
+  RKDP45_WORKSPACE *ret = malloc(sizeof(RKDP45_WORKSPACE));
+  if (ret == NULL) return NULL;
+  
+  ret->dimension = dimension;
+  
+  /* Wie beim RK4-Workspace ein einziger Speicherblock: 7 Stufen, ein
+   * Zwischenvektor und 5 Vektoren fuer die stetige Fortsetzung */
+  ret->k_1 = malloc(13 * dimension * sizeof(double));
+  if (ret->k_1 == NULL) {
+    free(ret);
+    return NULL;
+  }
+  
+  ret->k_2 = ret->k_1 + dimension;
+  ret->k_3 = ret->k_2 + dimension;
+  ret->k_4 = ret->k_3 + dimension;
+  ret->k_5 = ret->k_4 + dimension;
+  ret->k_6 = ret->k_5 + dimension;
+  ret->k_7 = ret->k_6 + dimension;
+  ret->y = ret->k_7 + dimension;
+  ret->cont = ret->y + dimension;
+  
+  return ret;
+}
+
+void rkdp45_workspace_free(RKDP45_WORKSPACE *workspace) {
+  free(workspace->k_1);
+  free(workspace);
+}
+
+double rkdp45_step(ODE_SYSTEM *system, RKDP45_WORKSPACE *space,
+                   double *y0, double t0, double h, double *y1,
+                   double atol, double rtol) {
+  int i;
+  int dimension = system->dimension;
+  double err, sc, sum;
+  
+  double *y_temp = space->y;
+  double *k_1 = space->k_1;
+  double *k_2 = space->k_2;
+  double *k_3 = space->k_3;
+  double *k_4 = space->k_4;
+  double *k_5 = space->k_5;
+  double *k_6 = space->k_6;
+  double *k_7 = space->k_7;
+  
+  assert(system->dimension == space->dimension);
+  
+  /* Stufen 2 bis 6 */
+  for (i = 0; i < dimension; i++) {
+    y_temp[i] = y0[i] + h * dp_a21 * k_1[i];
+  }
+  ode_system_eval(system, t0 + dp_c2 * h, y_temp, k_2);
+  
+  for (i = 0; i < dimension; i++) {
+    y_temp[i] = y0[i] + h * (dp_a31 * k_1[i] + dp_a32 * k_2[i]);
+  }
+  ode_system_eval(system, t0 + dp_c3 * h, y_temp, k_3);
+  
+  for (i = 0; i < dimension; i++) {
+    y_temp[i] = y0[i] + h * (dp_a41 * k_1[i] + dp_a42 * k_2[i]
+                             + dp_a43 * k_3[i]);
+  }
+  ode_system_eval(system, t0 + dp_c4 * h, y_temp, k_4);
+  
+  for (i = 0; i < dimension; i++) {
+    y_temp[i] = y0[i] + h * (dp_a51 * k_1[i] + dp_a52 * k_2[i]
+                             + dp_a53 * k_3[i] + dp_a54 * k_4[i]);
+  }
+  ode_system_eval(system, t0 + dp_c5 * h, y_temp, k_5);
+  
+  for (i = 0; i < dimension; i++) {
+    y_temp[i] = y0[i] + h * (dp_a61 * k_1[i] + dp_a62 * k_2[i]
+                             + dp_a63 * k_3[i] + dp_a64 * k_4[i]
+                             + dp_a65 * k_5[i]);
+  }
+  ode_system_eval(system, t0 + h, y_temp, k_6);
+  
+  /* Loesung 5. Ordnung */
+  for (i = 0; i < dimension; i++) {
+    y1[i] = y0[i] + h * (dp_a71 * k_1[i] + dp_a73 * k_3[i] + dp_a74 * k_4[i]
+                         + dp_a75 * k_5[i] + dp_a76 * k_6[i]);
+  }
+  
+  /* Auswertung am Schrittende: wird fuer die Fehlerschaetzung benoetigt und
+   * ist bei Akzeptanz des Schrittes die erste Stufe des naechsten (FSAL) */
+  ode_system_eval(system, t0 + h, y1, k_7);
+  
+  /* Fehlernorm: Wurzel des mittleren Fehlerquadrats relativ zur Toleranz */
+  sum = 0;
+  for (i = 0; i < dimension; i++) {
+    err = h * (dp_e1 * k_1[i] + dp_e3 * k_3[i] + dp_e4 * k_4[i]
+               + dp_e5 * k_5[i] + dp_e6 * k_6[i] + dp_e7 * k_7[i]);
+    sc = atol + rtol * fmax(fabs(y0[i]), fabs(y1[i]));
+    sum += (err / sc) * (err / sc);
+  }
+  
+  return sqrt(sum / dimension);
+}
+
+void rkdp45_dense_setup(RKDP45_WORKSPACE *space, double *y0, double *y1,
+                        double h) {
+  int i;
+  int dimension = space->dimension;
+  double ydiff, bspl;
+  
+  double *r1 = space->cont;
+  double *r2 = r1 + dimension;
+  double *r3 = r2 + dimension;
+  double *r4 = r3 + dimension;
+  double *r5 = r4 + dimension;
+  
+  for (i = 0; i < dimension; i++) {
+    ydiff = y1[i] - y0[i];
+    bspl = h * space->k_1[i] - ydiff;
+    
+    r1[i] = y0[i];
+    r2[i] = ydiff;
+    r3[i] = bspl;
+    r4[i] = ydiff - h * space->k_7[i] - bspl;
+    r5[i] = h * (dp_d1 * space->k_1[i] + dp_d3 * space->k_3[i]
+                 + dp_d4 * space->k_4[i] + dp_d5 * space->k_5[i]
+                 + dp_d6 * space->k_6[i] + dp_d7 * space->k_7[i]);
+  }
+}
+
+void rkdp45_dense_eval(RKDP45_WORKSPACE *space, double theta, double *y) {
+  int i;
+  int dimension = space->dimension;
+  double theta1 = 1 - theta;
+  
+  double *r1 = space->cont;
+  double *r2 = r1 + dimension;
+  double *r3 = r2 + dimension;
+  double *r4 = r3 + dimension;
+  double *r5 = r4 + dimension;
+  
   for (i = 0; i < dimension; i++) {
-    y[i] = sol->y[i][0] = y0[i];
+    y[i] = r1[i] + theta * (r2[i] + theta1 * (r3[i] + theta * (r4[i]
+                                              + theta1 * r5[i])));
+  }
+}
+
+/* Interpolation fuer die Ereignissuche ueber die stetige Fortsetzung */
+static void rkdp45_interpolate(double theta, double *y, void *data) {
+  rkdp45_dense_eval(data, theta, y);
+}
+
+int rkdp45_solve_observed(ODE_SYSTEM *system, double *y0,
+                          double t0, double t1, double h_out,
+                          double atol, double rtol, RKDP45_STATS *stats,
+                          ODE_OBSERVER *observers, int observer_count,
+                          ODE_CHECKPOINT *checkpoint) {
+  int i, j;
+  int dimension = system->dimension;
+  int t_steps = (t1 - t0) / h_out;
+  int ret = 0;
+  ODE_STATE *resume = (checkpoint != NULL) ? checkpoint->resume : NULL;
+  long next_checkpoint = 0;
+  long counters[3];
+  
+  /* Zeitpunkt des letzten Ausgabepunktes, bis zu dem integriert wird */
+  double t_end = t0 + t_steps * h_out;
+  double t = t0;
+  double h, t_sample, t_limit, err, fac, norm_y, norm_f;
+  int last_step, reject;
+  
+  RKDP45_WORKSPACE *workspace;
+  RKDP45_STATS count = {0, 0, 0};
+  double *y, *y_next, *swap_temp;
+  ODE_EVENT_STATE events;
+  double t_stop;
+  
+  workspace = rkdp45_workspace_alloc(dimension);
+  if (workspace == NULL) return -1;
+  
+  /* Temporaere Loesung */
+  y = malloc(dimension * sizeof(double));
+  y_next = malloc(dimension * sizeof(double));
+  if (y == NULL || y_next == NULL) {
+    free(y);
+    free(y_next);
+    rkdp45_workspace_free(workspace);
+    return -1;
   }
   
-  for (i = 1; i <= t_steps; i++) {
-    rk4_evolve(system, workspace, y, t0, h, y_next);
-    t0 += h;
+  if (resume != NULL) {
+    /* Fortsetzung: Zustand, FSAL-Stufe, Schrittweite und Statistik des
+     * gespeicherten Schrittes */
+    for (i = 0; i < dimension; i++) {
+      y[i] = resume->y[i];
+      workspace->k_1[i] = resume->dydt[i];
+    }
+    t = resume->t;
+    h = resume->h;
+    j = resume->step;
+    count.accepted = resume->stats[0];
+    count.rejected = resume->stats[1];
+    count.evaluations = resume->stats[2];
+  } else {
+    /* Anfangsbedingung */
+    for (i = 0; i < dimension; i++) {
+      y[i] = y0[i];
+    }
+    if (ode_notify(observers, observer_count, 0, t0, y, dimension) != 0) {
+      ret = 1;
+    }
+    
+    ode_system_eval(system, t0, y, workspace->k_1);
+    count.evaluations++;
+    
+    /* Startschrittweite aus dem Verhaeltnis der Normen von y und f
+     * (vereinfachte Variante nach Hairer), begrenzt durch das
+     * Ausgabeintervall */
+    norm_y = norm_f = 0;
+    for (i = 0; i < dimension; i++) {
+      fac = atol + rtol * fabs(y[i]);
+      norm_y += (y[i] / fac) * (y[i] / fac);
+      norm_f += (workspace->k_1[i] / fac) * (workspace->k_1[i] / fac);
+    }
+    if (norm_y < 1E-10 || norm_f < 1E-10) {
+      h = 1E-6;
+    } else {
+      h = 0.01 * sqrt(norm_y / norm_f);
+    }
+    if (h > 10 * h_out) h = 10 * h_out;
+    
+    j = 1;
+  }
+  if (ode_events_init(system, &events, t, y) != 0) {
+    free(y);
+    free(y_next);
+    rkdp45_workspace_free(workspace);
+    return -1;
+  }
+  if (checkpoint != NULL) next_checkpoint = j + checkpoint->every;
+  
+  reject = 0;
+  while (j <= t_steps && ret == 0) {
+    /* Der letzte Schritt endet genau auf "t_end" */
+    last_step = 0;
+    if (t + h >= t_end) {
+      h = t_end - t;
+      last_step = 1;
+    }
+    
+    /* Schrittweite zu klein: Toleranz nicht erreichbar */
+    if (h <= 1E-14 * fabs(t)) {
+      ret = -2;
+      break;
+    }
+    
+    err = rkdp45_step(system, workspace, y, t, h, y_next, atol, rtol);
+    count.evaluations += 6;
+    
+    /* Schrittweitenfaktor mit Sicherheitsfaktor 0.9, begrenzt auf [0.2, 10] */
+    fac = (err > 0) ? 0.9 * pow(err, -0.2) : 10;
+    if (fac > 10) fac = 10;
+    if (fac < 0.2) fac = 0.2;
+    
+    if (err > 1) {
+      /* Schritt verwerfen und mit kleinerer Schrittweite wiederholen */
+      count.rejected++;
+      reject = 1;
+      h *= fac;
+      continue;
+    }
+    count.accepted++;
+    
+    /* Ereignisse im Schritt ueber die stetige Fortsetzung; nach einem
+     * terminalen Ereignis werden nur noch die Ausgabepunkte davor
+     * uebergeben */
+    rkdp45_dense_setup(workspace, y, y_next, h);
+    t_limit = t + h;
+    if (system->event_count > 0) {
+      if (ode_events_detect(system, &events, t + h, y_next) > 0) {
+        ret = ode_events_locate(system, &events, t, h, rkdp45_interpolate,
+                                workspace, &t_stop);
+        if (ret == 1) break;
+        if (ret == 2) {
+          last_step = 0;
+          t_limit = t_stop;
+        }
+      }
+      ode_events_advance(system, &events);
+    }
+    
+    /* Ausgabepunkte innerhalb des Schrittes ueber die stetige Fortsetzung */
+    t_sample = t0 + j * h_out;
+    while (j <= t_steps && (t_sample <= t_limit || last_step)) {
+      rkdp45_dense_eval(workspace, fmin((t_sample - t) / h, 1.0),
+                        workspace->y);
+      if (ode_notify(observers, observer_count, j, t_sample, workspace->y,
+                     dimension) != 0) {
+        ret = 1;
+        break;
+      }
+      j++;
+      t_sample = t0 + j * h_out;
+    }
+    
+    t += h;
     
-    /* Loesung eintragen */
-    sol->t[i] = t0;
-    for (j = 0; j < dimension; j++) {
-      sol->y[j][i] = y_next[j];
+    /* FSAL: die letzte Stufe ist die erste des naechsten Schrittes */
+    for (i = 0; i < dimension; i++) {
+      workspace->k_1[i] = workspace->k_7[i];
     }
     
     /* Tausche Pointer um kopieren der einzelnen Werte zu vermeiden */
     swap_temp = y;
     y = y_next;
     y_next = swap_temp;
+    
+    /* Nach einem verworfenen Schritt wird die Schrittweite nicht vergroessert */
+    if (reject && fac > 1) fac = 1;
+    reject = 0;
+    h *= fac;
+    
+    /* Checkpoint nach ganzen Schritten (nicht nach einem verkuerzten letzten
+     * Schritt oder einem terminalen Ereignis) */
+    if (ret == 0 && !last_step && checkpoint != NULL &&
+        checkpoint->every > 0 && j >= next_checkpoint) {
+      counters[0] = count.accepted;
+      counters[1] = count.rejected;
+      counters[2] = count.evaluations;
+      if (ode_checkpoint_save(checkpoint, dimension, j, t, h, y,
+                              workspace->k_1, counters) != 0) {
+        ret = 1;
+      }
+      next_checkpoint = j + checkpoint->every;
+    }
   }
   
+  if (stats != NULL) *stats = count;
+  
+  ode_events_free(&events);
   free(y);
   free(y_next);
-  rk4_workspace_free(workspace);
-  return sol;
+  rkdp45_workspace_free(workspace);
+  return ret;
+}
+
+ODE_SOLUTION *rkdp45_solve(ODE_SYSTEM *system, double *y0,
+                           double t0, double t1, double h_out,
+                           double atol, double rtol, RKDP45_STATS *stats) {
+  int t_steps = (t1 - t0) / h_out;
+  int ret;
+  ODE_STORE store;
+  ODE_OBSERVER observer;
+  
+  store.sol = ode_solution_alloc(system->dimension, t_steps + 1);
+  store.index = 0;
+  if (store.sol == NULL) return NULL;
+  
+  observer.observe = ode_store;
+  observer.data = &store;
+  observer.every = 1;
+  
+  ret = rkdp45_solve_observed(system, y0, t0, t1, h_out, atol, rtol, stats,
+                              &observer, 1, NULL);
+  if (ret != 0 && ret != 2) {
+    ode_solution_free(store.sol);
+    return NULL;
+  }
+  
+  /* Nach einem terminalen Ereignis enthaelt die Loesung weniger Punkte */
+  store.sol->t_count = store.index;
+  
+  return store.sol;
+}
+
+/* Koeffizienten der Kompositionsverfahren nach Yoshida (symmetrische Folgen
+ * von Stoermer-Verlet-Schritten der Laenge w_i * h) */
+static const double yoshida4_w[3] = {
+  1.3512071919596576340, -1.7024143839193152681, 1.3512071919596576340
+};
+static const double yoshida6_w[7] = {
+  0.78451361047755726382, 0.23557321335935813368, -1.1776799841788710069,
+  1.3151863206839112189,
+  -1.1776799841788710069, 0.23557321335935813368, 0.78451361047755726382
+};
+
+SYMPLECTIC_WORKSPACE *symplectic_workspace_alloc(int dimension) {
+  SYMPLECTIC_WORKSPACE *ret = malloc(sizeof(SYMPLECTIC_WORKSPACE));
+  if (ret == NULL) return NULL;
+  
+  ret->dimension = dimension;
+  
+  /* Ein Speicherblock; "q_new" und "p_half" liegen hintereinander und bilden
+   * bei der Mittelpunktsregel den neuen Zustand */
+  ret->q_new = malloc(8 * dimension * sizeof(double));
+  if (ret->q_new == NULL) {
+    free(ret);
+    return NULL;
+  }
+  
+  ret->p_half = ret->q_new + dimension;
+  ret->dH_0 = ret->p_half + dimension;
+  ret->dH_1 = ret->dH_0 + dimension;
+  ret->y_mid = ret->dH_1 + dimension;
+  ret->f = ret->y_mid + 2 * dimension;
+  
+  return ret;
+}
+
+void symplectic_workspace_free(SYMPLECTIC_WORKSPACE *workspace) {
+  free(workspace->q_new);
+  free(workspace);
+}
+
+/* Fixpunktiteration: Setzt x = x_0 + c * d und prueft, ob sich x dabei um
+ * weniger als SYMPLECTIC_TOL (relativ) geaendert hat */
+static int symplectic_update(double *x, const double *x_0, double c,
+                             const double *d, int n) {
+  int i, converged = 1;
+  double x_new;
+  
+  for (i = 0; i < n; i++) {
+    x_new = x_0[i] + c * d[i];
+    if (fabs(x_new - x[i]) > SYMPLECTIC_TOL * (1 + fabs(x_new))) {
+      converged = 0;
+    }
+    x[i] = x_new;
+  }
+  return converged;
+}
+
+/* Verallgemeinertes Leapfrog-Verfahren (Stoermer-Verlet):
+ *   p_half = p - h/2 dH/dq(q, p_half)
+ *   q_new  = q + h/2 (dH/dp(q, p_half) + dH/dp(q_new, p_half))
+ *   p_new  = p_half - h/2 dH/dq(q_new, p_half)
+ * Bei separablen Systemen sind die ersten beiden Gleichungen explizit. */
+static int symplectic_verlet(HAMILTONIAN_SYSTEM *system,
+                             SYMPLECTIC_WORKSPACE *space, double *y, double h,
+                             SYMPLECTIC_STATS *stats) {
+  int i, iter;
+  int d = system->dimension;
+  double *q = y, *p = y + d;
+  long evaluations = 0, iterations = 0;
+  
+  /* Impuls nach einem halben Schritt */
+  system->dH_dq(q, p, space->dH_0, system->params);
+  evaluations++;
+  for (i = 0; i < d; i++) {
+    space->p_half[i] = p[i] - 0.5 * h * space->dH_0[i];
+  }
+  for (iter = 0; !system->separable; iter++) {
+    if (iter == SYMPLECTIC_MAX_ITER) return -2;
+    system->dH_dq(q, space->p_half, space->dH_0, system->params);
+    evaluations++, iterations++;
+    if (symplectic_update(space->p_half, p, -0.5 * h, space->dH_0, d)) break;
+  }
+  
+  /* Koordinaten nach einem ganzen Schritt */
+  system->dH_dp(q, space->p_half, space->dH_1, system->params);
+  evaluations++;
+  for (i = 0; i < d; i++) {
+    space->q_new[i] = q[i] + h * space->dH_1[i];
+  }
+  for (iter = 0; !system->separable; iter++) {
+    if (iter == SYMPLECTIC_MAX_ITER) return -2;
+    system->dH_dp(space->q_new, space->p_half, space->dH_0, system->params);
+    evaluations++, iterations++;
+    for (i = 0; i < d; i++) {
+      space->dH_0[i] += space->dH_1[i];
+    }
+    if (symplectic_update(space->q_new, q, 0.5 * h, space->dH_0, d)) break;
+  }
+  
+  /* Impuls nach einem ganzen Schritt */
+  system->dH_dq(space->q_new, space->p_half, space->dH_0, system->params);
+  evaluations++;
+  for (i = 0; i < d; i++) {
+    q[i] = space->q_new[i];
+    p[i] = space->p_half[i] - 0.5 * h * space->dH_0[i];
+  }
+  
+  if (stats != NULL) {
+    stats->evaluations += evaluations;
+    stats->iterations += iterations;
+  }
+  return 0;
+}
+
+/* Rechte Seite f(y) = (dH/dp, -dH/dq) */
+static void symplectic_rhs(HAMILTONIAN_SYSTEM *system, const double *y,
+                           double *f) {
+  int i;
+  int d = system->dimension;
+  
+  system->dH_dp(y, y + d, f, system->params);
+  system->dH_dq(y, y + d, f + d, system->params);
+  for (i = d; i < 2 * d; i++) {
+    f[i] = -f[i];
+  }
+}
+
+/* Implizite Mittelpunktsregel y_new = y + h f((y + y_new) / 2) */
+static int symplectic_midpoint(HAMILTONIAN_SYSTEM *system,
+                               SYMPLECTIC_WORKSPACE *space, double *y,
+                               double h, SYMPLECTIC_STATS *stats) {
+  int i, iter;
+  int n = 2 * system->dimension;
+  double *y_new = space->q_new;
+  long iterations = 0;
+  
+  /* Startwert: expliziter Euler-Schritt */
+  symplectic_rhs(system, y, space->f);
+  for (i = 0; i < n; i++) {
+    y_new[i] = y[i] + h * space->f[i];
+  }
+  
+  for (iter = 0; ; iter++) {
+    if (iter == SYMPLECTIC_MAX_ITER) return -2;
+    for (i = 0; i < n; i++) {
+      space->y_mid[i] = 0.5 * (y[i] + y_new[i]);
+    }
+    symplectic_rhs(system, space->y_mid, space->f);
+    iterations++;
+    if (symplectic_update(y_new, y, h, space->f, n)) break;
+  }
+  
+  for (i = 0; i < n; i++) {
+    y[i] = y_new[i];
+  }
+  
+  if (stats != NULL) {
+    stats->evaluations += 2 * (iterations + 1);
+    stats->iterations += iterations;
+  }
+  return 0;
+}
+
+int symplectic_step(HAMILTONIAN_SYSTEM *system, SYMPLECTIC_WORKSPACE *space,
+                    SYMPLECTIC_METHOD method, double *y, double h,
+                    SYMPLECTIC_STATS *stats) {
+  int i;
+  
+  switch (method) {
+    case SYMPLECTIC_VERLET:
+      return symplectic_verlet(system, space, y, h, stats);
+    
+    case SYMPLECTIC_YOSHIDA4:
+      for (i = 0; i < 3; i++) {
+        if (symplectic_verlet(system, space, y, yoshida4_w[i] * h,
+                              stats) != 0) {
+          return -2;
+        }
+      }
+      return 0;
+    
+    case SYMPLECTIC_YOSHIDA6:
+      for (i = 0; i < 7; i++) {
+        if (symplectic_verlet(system, space, y, yoshida6_w[i] * h,
+                              stats) != 0) {
+          return -2;
+        }
+      }
+      return 0;
+    
+    case SYMPLECTIC_MIDPOINT:
+      return symplectic_midpoint(system, space, y, h, stats);
+  }
+  
+  return 0;
+}
+
+int symplectic_solve_observed(HAMILTONIAN_SYSTEM *system,
+                              SYMPLECTIC_METHOD method, double *y0,
+                              double t0, double t1, double h,
+                              SYMPLECTIC_STATS *stats,
+                              ODE_OBSERVER *observers, int observer_count,
+                              ODE_CHECKPOINT *checkpoint) {
+  int i;
+  int n = 2 * system->dimension;
+  int t_steps = (t1 - t0) / h;
+  int ret = 0;
+  int first = 1;
+  ODE_STATE *resume = (checkpoint != NULL) ? checkpoint->resume : NULL;
+  long counters[3];
+  
+  SYMPLECTIC_WORKSPACE *workspace;
+  SYMPLECTIC_STATS local_stats = {0, 0, 0};
+  double *y, *out;
+  int out_dimension;
+  
+  workspace = symplectic_workspace_alloc(system->dimension);
+  if (workspace == NULL) return -1;
+  
+  /* Zustand und (abgebildete) Ausgabe in einem Block */
+  out_dimension = (system->output != NULL) ? system->output_dimension : n;
+  y = malloc((n + out_dimension) * sizeof(double));
+  if (y == NULL) {
+    symplectic_workspace_free(workspace);
+    return -1;
+  }
+  out = (system->output != NULL) ? y + n : y;
+  
+  /* Anfangsbedingung bzw. fortgesetzter Zustand */
+  if (resume != NULL) {
+    for (i = 0; i < n; i++) {
+      y[i] = resume->y[i];
+    }
+    first = resume->step + 1;
+    local_stats.steps = resume->stats[0];
+    local_stats.iterations = resume->stats[1];
+    local_stats.evaluations = resume->stats[2];
+  } else {
+    for (i = 0; i < n; i++) {
+      y[i] = y0[i];
+    }
+    if (system->output != NULL) system->output(y, out, system->params);
+    if (ode_notify(observers, observer_count, 0, t0, out,
+                   out_dimension) != 0) {
+      ret = 1;
+    }
+  }
+  
+  for (i = first; i <= t_steps && ret == 0; i++) {
+    if (symplectic_step(system, workspace, method, y, h, &local_stats) != 0) {
+      ret = -2;
+      break;
+    }
+    local_stats.steps++;
+    
+    if (system->output != NULL) system->output(y, out, system->params);
+    if (ode_notify(observers, observer_count, i, t0 + i * h, out,
+                   out_dimension) != 0) {
+      ret = 1;
+    }
+    
+    if (ret == 0 && checkpoint != NULL && checkpoint->every > 0 &&
+        (i % checkpoint->every == 0 || i == t_steps)) {
+      counters[0] = local_stats.steps;
+      counters[1] = local_stats.iterations;
+      counters[2] = local_stats.evaluations;
+      if (ode_checkpoint_save(checkpoint, n, i, t0 + i * h, h, y, NULL,
+                              counters) != 0) {
+        ret = 1;
+      }
+    }
+  }
+  
+  if (stats != NULL) *stats = local_stats;
+  
+  free(y);
+  symplectic_workspace_free(workspace);
+  return ret;
 }
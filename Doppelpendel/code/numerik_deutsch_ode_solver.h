@@ -14,11 +14,61 @@ typedef struct {
   double *params;
 } ODE;
 
+/* Rechte Seite des gesamten Systems in einem Aufruf: Die Funktion schreibt
+ * y_i'[t] fuer alle i = 0, ..., n nach "dydt". Gemeinsame Terme (z.B. Winkel-
+ * funktionen, die in mehreren Gleichungen vorkommen) muessen so nur einmal pro
+ * Auswertung berechnet werden. */
+typedef void (*ODE_RHS)(double t, const double *y, double *dydt, void *params);
+
+/* Rechte Seite fuer "count" Systeme gleichzeitig (Ensemble). Die Zustaende
+ * liegen als "structure of arrays" vor: y[i * count + k] ist die i-te Funktion
+ * des k-ten Systems, dydt entsprechend. Die innere Schleife ueber k kann so vom
+ * Compiler vektorisiert werden. */
+typedef void (*ODE_RHS_BATCH)(double t, const double *y, double *dydt,
+                              int count, void *params);
+
+/* Ereignis: tritt ein, wenn die Ereignisfunktion g(t, y) das Vorzeichen
+ * wechselt (z.B. g = theta_1 fuer einen Poincare-Schnitt). Die Loeser
+ * bestimmen den Zeitpunkt innerhalb des Schrittes durch Interpolation und
+ * uebergeben den Zustand zu diesem Zeitpunkt an "observe" (mit "data", vgl.
+ * ODE_OBSERVER).
+ * direction: 1 nur steigende, -1 nur fallende Nulldurchgaenge, 0 beide
+ * terminal: ungleich 0 beendet die Integration beim ersten Eintreten */
+typedef struct {
+  double (*g)(double t, const double *y, void *params);
+  void *params;
+  int direction;
+  int terminal;
+  
+  int (*observe)(double t, const double *y, int dimension, void *data);
+  void *data;
+} ODE_EVENT;
+
+/* Genauigkeit, mit der der Zeitpunkt eines Ereignisses bestimmt wird (relativ
+ * zur Schrittweite) */
+#define ODE_EVENT_TOL 1e-12
+
 /* Repraesentation eines Differentialgleichungssystem aus "dimension"-Glei-
- * chungen. "eqns" ist das Array von "ODE" Objekten. */
+ * chungen. Das System kann auf zwei Arten angegeben werden:
+ * - "rhs" (ungleich NULL): Funktion fuer die gesamte rechte Seite, die mit
+ *   "params" aufgerufen wird ("eqns" wird dann nicht verwendet)
+ * - "rhs" gleich NULL: "eqns" ist das Array von "ODE" Objekten
+ * Zusaetzlich kann fuer die Ensemble-Integration eine Funktion "rhs_batch"
+ * angegeben werden (ebenfalls mit "params"). Ist sie NULL, werden die Systeme
+ * des Ensembles einzeln ueber "rhs" bzw. "eqns" ausgewertet.
+ * "events" sind die "event_count" Ereignisse, die "rk4_solve_observed" und
+ * "rkdp45_solve_observed" ueberwachen (NULL bzw. 0 fuer keine; bei der
+ * Ensemble-Integration werden sie nicht beachtet). */
 typedef struct {
   ODE *eqns;
   int dimension;
+  
+  ODE_RHS rhs;
+  ODE_RHS_BATCH rhs_batch;
+  void *params;
+  
+  ODE_EVENT *events;
+  int event_count;
 } ODE_SYSTEM;
 
 /* Temporaere Arrays fuer das Runge-Kutta-Verfahren 4. Ordnung, um staendige
@@ -33,6 +83,54 @@ typedef struct {
   double *y;
 } RK4_WORKSPACE;
 
+/* Anzahl der Systeme, die bei der Ensemble-Integration gemeinsam (in einem
+ * Block) entwickelt werden */
+#define RK4_BATCH_BLOCK 64
+
+/* Temporaere Arrays fuer das RK4-Verfahren auf einem Block von bis zu "count"
+ * Systemen im "structure of arrays"-Layout (vgl. ODE_RHS_BATCH). "lane" bietet
+ * Platz fuer Zustand und Ableitung eines einzelnen Systems, falls das System
+ * keine Funktion "rhs_batch" hat. */
+typedef struct {
+  int dimension;
+  int count;
+  
+  double *k_1;
+  double *k_2;
+  double *k_3;
+  double *k_4;
+  double *y;
+  double *lane;
+} RK4_BATCH_WORKSPACE;
+
+/* Temporaere Arrays fuer das eingebettete Runge-Kutta-Verfahren nach
+ * Dormand-Prince 5(4). "k_7" ist die Auswertung am Ende eines Schrittes und
+ * wird als "k_1" des naechsten Schrittes wiederverwendet (FSAL). "cont" enthaelt
+ * die 5 Koeffizientenvektoren der stetigen Fortsetzung (dense output) des
+ * zuletzt berechneten Schrittes. */
+typedef struct {
+  int dimension;
+  
+  double *k_1;
+  double *k_2;
+  double *k_3;
+  double *k_4;
+  double *k_5;
+  double *k_6;
+  double *k_7;
+  double *y;
+  double *cont;
+} RKDP45_WORKSPACE;
+
+/* Statistik eines adaptiven Loesungsvorgangs */
+typedef struct {
+  /* akzeptierte und verworfene Schritte */
+  long accepted;
+  long rejected;
+  /* Anzahl der Auswertungen der rechten Seite */
+  long evaluations;
+} RKDP45_STATS;
+
 /* Struktur zum Speichern der Loesung:
  * dimension: Anzahl der Gleichungen und Funktionen des Differentialgleichungs-
  *            systems
@@ -51,6 +149,121 @@ typedef struct {
 } ODE_SOLUTION;
 
 
+/* Hamiltonsches System mit "dimension" Freiheitsgraden. Der Zustand ist
+ * y = (q_0, ..., q_(d-1), p_0, ..., p_(d-1)) mit den kanonischen Koordinaten q
+ * und Impulsen p, die Bewegungsgleichungen lauten q' = dH/dp, p' = -dH/dq.
+ * dH_dq, dH_dp: partielle Ableitungen der Hamiltonfunktion (je d Werte)
+ * separable: ungleich 0, wenn H = T(p) + V(q); dann sind alle Verfahren
+ *            explizit, sonst werden die impliziten Gleichungen iteriert
+ * output: Abbildung des Zustands auf die Werte, die an die Beobachter
+ *         uebergeben werden (z.B. Geschwindigkeiten statt Impulse), mit
+ *         "output_dimension" Werten; NULL uebergibt y selbst */
+typedef struct {
+  int dimension;
+  void (*dH_dq)(const double *q, const double *p, double *dHdq, void *params);
+  void (*dH_dp)(const double *q, const double *p, double *dHdp, void *params);
+  int separable;
+  void (*output)(const double *y, double *out, void *params);
+  int output_dimension;
+  void *params;
+} HAMILTONIAN_SYSTEM;
+
+/* Symplektische Verfahren:
+ * SYMPLECTIC_VERLET: Stoermer-Verlet (Ordnung 2, fuer nicht separable H das
+ *                    verallgemeinerte, halb-implizite Leapfrog-Verfahren)
+ * SYMPLECTIC_YOSHIDA4, SYMPLECTIC_YOSHIDA6: Komposition von Stoermer-Verlet-
+ *                    Schritten nach Yoshida (Ordnung 4 bzw. 6)
+ * SYMPLECTIC_MIDPOINT: implizite Mittelpunktsregel (Ordnung 2) */
+typedef enum {
+  SYMPLECTIC_VERLET,
+  SYMPLECTIC_YOSHIDA4,
+  SYMPLECTIC_YOSHIDA6,
+  SYMPLECTIC_MIDPOINT
+} SYMPLECTIC_METHOD;
+
+/* Abbruchkriterium der Fixpunktiteration fuer die impliziten Gleichungen:
+ * relative Aenderung kleiner SYMPLECTIC_TOL bzw. hoechstens
+ * SYMPLECTIC_MAX_ITER Iterationen */
+#define SYMPLECTIC_TOL 1e-14
+#define SYMPLECTIC_MAX_ITER 50
+
+/* Workspace der symplektischen Verfahren (alle Vektoren mit "dimension"
+ * Werten, "y_mid" und "f" mit 2 * dimension Werten) */
+typedef struct {
+  int dimension;
+  
+  double *p_half;
+  double *q_new;
+  double *dH_0;
+  double *dH_1;
+  double *y_mid;
+  double *f;
+} SYMPLECTIC_WORKSPACE;
+
+/* Statistik eines symplektischen Loesungsvorgangs */
+typedef struct {
+  long steps;
+  /* Anzahl der Fixpunktiterationen (0 bei separablen Systemen) */
+  long iterations;
+  /* Anzahl der Auswertungen von dH/dq und dH/dp */
+  long evaluations;
+} SYMPLECTIC_STATS;
+
+/* Wertet die rechte Seite des Systems zum Zeitpunkt "t" fuer den Zustand "y"
+ * aus und speichert sie in "dydt" */
+void ode_system_eval(ODE_SYSTEM *system, double t, const double *y,
+                     double *dydt);
+/* Beobachter der Loesung: Die Loeser uebergeben die berechneten Loesungspunkte
+ * waehrend der Integration an "observe", anstatt sie zu speichern (Ausgabe in
+ * eine Datei, Sammeln fuer die FFT, ...). Der Speicherbedarf der Loeser haengt
+ * so nicht von der Anzahl der Loesungspunkte ab.
+ * observe: erhaelt den Loesungspunkt (t, y) und "data", ein Rueckgabewert
+ *          ungleich 0 bricht die Integration ab
+ * every: nur jeder "every"-te Loesungspunkt (beginnend mit der Anfangs-
+ *        bedingung) wird uebergeben, 1 fuer alle */
+typedef struct {
+  int (*observe)(double t, const double *y, int dimension, void *data);
+  void *data;
+  int every;
+} ODE_OBSERVER;
+
+/* Zustand eines Loesers zwischen zwei Schritten, aus dem die Integration
+ * bitgenau fortgesetzt werden kann:
+ * step: Anzahl der ausgefuehrten Schritte (RK4, symplektische Verfahren) bzw.
+ *       Index des naechsten Ausgabepunktes (Dormand-Prince)
+ * t: Zeitpunkt des Zustands (bei fester Schrittweite t0 + step * h)
+ * h: Schrittweite des naechsten Versuchs (Dormand-Prince)
+ * y: Zustand ("dimension" Werte; bei den symplektischen Verfahren (q, p))
+ * dydt: f(t, y) fuer die erste Stufe des naechsten Schrittes (Dormand-Prince)
+ * stats: Zaehler der Statistik (RKDP45_STATS bzw. SYMPLECTIC_STATS in der
+ *        Reihenfolge der Felder) */
+typedef struct {
+  int dimension;
+  long step;
+  double t;
+  double h;
+  double *y;
+  double *dydt;
+  long stats[3];
+} ODE_STATE;
+
+/* Checkpoints: Die Loeser uebergeben alle "every" Schritte (Dormand-Prince:
+ * Ausgabepunkte) und am Ende der Integration ihren Zustand an "save" (mit
+ * "data"), nachdem die Beobachter den letzten Loesungspunkt erhalten haben. Ein
+ * Rueckgabewert ungleich 0 bricht die Integration ab. Bei Dormand-Prince wird
+ * am Ende nur gespeichert, wenn der letzte Schritt nicht auf den Endpunkt
+ * verkuerzt wurde, damit eine Fortsetzung zu einem spaeteren Endpunkt dieselben
+ * Schritte macht wie eine Integration in einem Zug.
+ * Ist "resume" ungleich NULL, beginnt die Integration mit diesem Zustand
+ * ("y0" wird nicht verwendet, der Anfangspunkt nicht erneut an die Beobachter
+ * uebergeben). "t0" muss dabei derselbe Wert wie beim Speichern sein. */
+typedef struct {
+  long every;
+  int (*save)(const ODE_STATE *state, void *data);
+  void *data;
+  ODE_STATE *resume;
+} ODE_CHECKPOINT;
+
 /* Allokiert den Workspace zum Entwickeln der DGL */
 RK4_WORKSPACE *rk4_workspace_alloc(int dimension);
 
@@ -69,8 +282,133 @@ ODE_SOLUTION *ode_solution_alloc(int dimension, int t_count);
 void ode_solution_free(ODE_SOLUTION *sol);
 
 /* Loest das Differentialgleichungssystem von "t0" bis "t1" in Schritten von "h"
- * mit der Anfangsbedingung "y0" und gibt die Loesung zurueck. */
+ * mit der Anfangsbedingung "y0" und uebergibt die Loesungspunkte an die
+ * "observer_count" Beobachter in "observers". Ereignisse (system->events)
+ * werden innerhalb eines Schrittes mit kubischer Hermite-Interpolation
+ * lokalisiert. "checkpoint" (NULL fuer keine) speichert bzw. setzt den
+ * Zustand fort (vgl. ODE_CHECKPOINT).
+ * Rueckgabewert:
+ * 0: Erfolg
+ * 1: Abbruch durch einen Beobachter
+ * 2: Abbruch durch ein terminales Ereignis
+ * -1: Allokierung fehlgeschlagen */
+int rk4_solve_observed(ODE_SYSTEM *system, double *y0, double t0, double t1,
+                       double h, ODE_OBSERVER *observers, int observer_count,
+                       ODE_CHECKPOINT *checkpoint);
+
+/* Loest das Differentialgleichungssystem von "t0" bis "t1" in Schritten von "h"
+ * mit der Anfangsbedingung "y0" und gibt die Loesung zurueck (nach einem
+ * terminalen Ereignis nur die Punkte davor). */
 ODE_SOLUTION *rk4_solve(ODE_SYSTEM *system, double *y0,
                         double t0, double t1, double h);
 
+/* Allokiert den Workspace fuer die Ensemble-Integration von bis zu "count"
+ * Systemen */
+RK4_BATCH_WORKSPACE *rk4_batch_workspace_alloc(int dimension, int count);
+
+/* Gibt den Speicher des Workspaces wieder frei */
+void rk4_batch_workspace_free(RK4_BATCH_WORKSPACE *workspace);
+
+/* Entwickelt "count" Systeme (count <= space->count) im "structure of arrays"-
+ * Layout von (y0, t0) auf (y1, t0 + h) */
+void rk4_evolve_batch(ODE_SYSTEM *system, RK4_BATCH_WORKSPACE *space,
+                      double *y0, double t0, double h, double *y1, int count);
+
+/* Entwickelt das Ensemble von "count" Anfangsbedingungen "y0" von "t0" bis "t1"
+ * in Schritten von "h" und speichert die Endzustaende in "y1". "y0" und "y1"
+ * sind (count x dimension)-Arrays, y0[k * dimension + i] ist also die i-te
+ * Funktion des k-ten Systems. Die Systeme werden in Bloecken von
+ * RK4_BATCH_BLOCK gemeinsam entwickelt, die Bloecke bei Kompilierung mit
+ * -fopenmp auf alle Kerne verteilt.
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Allokierung fehlgeschlagen */
+int rk4_solve_batch(ODE_SYSTEM *system, int count, double *y0,
+                    double t0, double t1, double h, double *y1);
+
+/* Allokiert den Workspace fuer das Dormand-Prince-Verfahren */
+RKDP45_WORKSPACE *rkdp45_workspace_alloc(int dimension);
+
+/* Gibt den Speicher des Workspaces wieder frei */
+void rkdp45_workspace_free(RKDP45_WORKSPACE *workspace);
+
+/* Versucht einen Schritt von (y0, t0) nach (y1, t0 + h). "space->k_1" muss
+ * dabei bereits die rechte Seite f(t0, y0) enthalten, nach dem Schritt steht
+ * f(t0 + h, y1) in "space->k_7". Zurueckgegeben wird die Fehlernorm des
+ * eingebetteten Verfahrens bezogen auf die Toleranz atol + rtol * |y|, der
+ * Schritt ist also fuer Werte <= 1 zu akzeptieren. */
+double rkdp45_step(ODE_SYSTEM *system, RKDP45_WORKSPACE *space,
+                   double *y0, double t0, double h, double *y1,
+                   double atol, double rtol);
+
+/* Berechnet nach einem akzeptierten Schritt von y0 nach y1 die Koeffizienten
+ * der stetigen Fortsetzung in "space->cont" */
+void rkdp45_dense_setup(RKDP45_WORKSPACE *space, double *y0, double *y1,
+                        double h);
+
+/* Interpoliert die Loesung im zuletzt mit "rkdp45_dense_setup" vorbereiteten
+ * Schritt an der Stelle t0 + theta * h (0 <= theta <= 1, Ordnung 4) */
+void rkdp45_dense_eval(RKDP45_WORKSPACE *space, double theta, double *y);
+
+/* Loest das Differentialgleichungssystem von "t0" bis "t1" mit adaptiver
+ * Schrittweite nach Dormand-Prince 5(4) mit der absoluten und relativen
+ * Toleranz "atol" bzw. "rtol". Die Loesung wird ueber die stetige Fortsetzung
+ * auf dem aequidistanten Gitter t0, t0 + h_out, ... ausgegeben (wie bei
+ * "rk4_solve" mit h = h_out). Ist "stats" ungleich NULL, wird dort die Statistik
+ * des Loesungsvorgangs gespeichert.
+ * Rueckgabewert:
+ * NULL: Allokierung fehlgeschlagen oder Schrittweite zu klein */
+ODE_SOLUTION *rkdp45_solve(ODE_SYSTEM *system, double *y0,
+                           double t0, double t1, double h_out,
+                           double atol, double rtol, RKDP45_STATS *stats);
+
+/* Wie "rkdp45_solve", die Loesungspunkte auf dem aequidistanten Gitter werden
+ * jedoch an die Beobachter uebergeben (vgl. "rk4_solve_observed"). Ereignisse
+ * werden mit der stetigen Fortsetzung lokalisiert.
+ * Rueckgabewert:
+ * 0: Erfolg
+ * 1: Abbruch durch einen Beobachter
+ * 2: Abbruch durch ein terminales Ereignis
+ * -1: Allokierung fehlgeschlagen
+ * -2: Schrittweite zu klein */
+int rkdp45_solve_observed(ODE_SYSTEM *system, double *y0,
+                          double t0, double t1, double h_out,
+                          double atol, double rtol, RKDP45_STATS *stats,
+                          ODE_OBSERVER *observers, int observer_count,
+                          ODE_CHECKPOINT *checkpoint);
+
+/* Allokiert den Workspace fuer die symplektischen Verfahren */
+SYMPLECTIC_WORKSPACE *symplectic_workspace_alloc(int dimension);
+
+/* Gibt den Speicher des Workspaces wieder frei */
+void symplectic_workspace_free(SYMPLECTIC_WORKSPACE *workspace);
+
+/* Entwickelt den Zustand "y" (vgl. HAMILTONIAN_SYSTEM) um einen Schritt der
+ * Laenge "h" mit dem Verfahren "method". Ist "stats" ungleich NULL, werden
+ * Iterationen und Auswertungen dort gezaehlt.
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -2: Fixpunktiteration nicht konvergiert (Schrittweite zu gross) */
+int symplectic_step(HAMILTONIAN_SYSTEM *system, SYMPLECTIC_WORKSPACE *space,
+                    SYMPLECTIC_METHOD method, double *y, double h,
+                    SYMPLECTIC_STATS *stats);
+
+/* Loest das Hamiltonsche System von "t0" bis "t1" in Schritten von "h" mit dem
+ * symplektischen Verfahren "method" und der Anfangsbedingung "y0" (q, p) und
+ * uebergibt die Loesungspunkte (abgebildet mit "system->output") an die
+ * Beobachter (vgl. "rk4_solve_observed"). Symplektische Verfahren erhalten
+ * die Energie ueber lange Zeiten bis auf eine beschraenkte Schwankung, waehrend
+ * der Fehler von RK4 mit der Zeit anwaechst.
+ * Rueckgabewert:
+ * 0: Erfolg
+ * 1: Abbruch durch einen Beobachter
+ * -1: Allokierung fehlgeschlagen
+ * -2: Fixpunktiteration nicht konvergiert */
+int symplectic_solve_observed(HAMILTONIAN_SYSTEM *system,
+                              SYMPLECTIC_METHOD method, double *y0,
+                              double t0, double t1, double h,
+                              SYMPLECTIC_STATS *stats,
+                              ODE_OBSERVER *observers, int observer_count,
+                              ODE_CHECKPOINT *checkpoint);
+
 #endif
@@ -0,0 +1,272 @@
+#include "numerik_deutsch_pendulum.h"
+#include <math.h>
+
+void double_pendulum(double t, const double *y, double *dydt, void *params) {
+  double theta_1 = y[0];
+  double omega_1 = y[1];
+  double theta_2 = y[2];
+  double omega_2 = y[3];
+  
+  double *p = params;
+  double g = p[0];
+  double mu = p[1];
+  double L_1 = p[2];
+  double L_2 = p[3];
+  
+  /* Gemeinsame Terme beider Bewegungsgleichungen werden nur einmal berechnet */
+  double sindiff = sin(theta_1 - theta_2);
+  double cosdiff = cos(theta_1 - theta_2);
+  double denominator = 1 - mu * cosdiff * cosdiff;
+  
+  dydt[0] = omega_1;
+  
+  dydt[1] = ((0.5 * mu - 1) * g * sin(theta_1)
+             - 0.5 * mu * g * sin(theta_1 - 2 * theta_2)
+             - mu * sindiff * (L_1 * omega_1 * omega_1 * cosdiff
+                               + L_2 * omega_2 * omega_2))
+            / (L_1 * denominator);
+  
+  dydt[2] = omega_2;
+  
+  dydt[3] = sindiff * (g * cos(theta_1)
+                       + L_1 * omega_1 * omega_1
+                       + mu * L_2 * omega_2 * omega_2 * cosdiff)
+            / (L_2 * denominator);
+}
+
+void double_pendulum_batch(double t, const double *y, double *dydt, int count,
+                           void *params) {
+  int k;
+  
+  double *p = params;
+  double g = p[0];
+  double mu = p[1];
+  double L_1 = p[2];
+  double L_2 = p[3];
+  
+  /* Zeilen des "structure of arrays"-Layouts */
+  const double *theta_1 = y;
+  const double *omega_1 = y + count;
+  const double *theta_2 = y + 2 * count;
+  const double *omega_2 = y + 3 * count;
+  
+  double *d_theta_1 = dydt;
+  double *d_omega_1 = dydt + count;
+  double *d_theta_2 = dydt + 2 * count;
+  double *d_omega_2 = dydt + 3 * count;
+  
+  /* Gleiche Rechnung wie in "double_pendulum", die Schleife ueber die Pendel
+   * ist unabhaengig und kann vektorisiert werden */
+  #pragma omp simd
+  for (k = 0; k < count; k++) {
+    double sindiff = sin(theta_1[k] - theta_2[k]);
+    double cosdiff = cos(theta_1[k] - theta_2[k]);
+    double denominator = 1 - mu * cosdiff * cosdiff;
+    
+    d_theta_1[k] = omega_1[k];
+    
+    d_omega_1[k] = ((0.5 * mu - 1) * g * sin(theta_1[k])
+                    - 0.5 * mu * g * sin(theta_1[k] - 2 * theta_2[k])
+                    - mu * sindiff * (L_1 * omega_1[k] * omega_1[k] * cosdiff
+                                      + L_2 * omega_2[k] * omega_2[k]))
+                   / (L_1 * denominator);
+    
+    d_theta_2[k] = omega_2[k];
+    
+    d_omega_2[k] = sindiff * (g * cos(theta_1[k])
+                              + L_1 * omega_1[k] * omega_1[k]
+                              + mu * L_2 * omega_2[k] * omega_2[k] * cosdiff)
+                   / (L_2 * denominator);
+  }
+}
+
+void double_pendulum_tangent(double t, const double *y, double *dydt,
+                             void *params) {
+  /* Fuer ein einzelnes Pendel stimmt das "structure of arrays"-Layout mit dem
+   * gewoehnlichen ueberein */
+  double_pendulum_tangent_batch(t, y, dydt, 1, params);
+}
+
+void double_pendulum_tangent_batch(double t, const double *y, double *dydt,
+                                   int count, void *params) {
+  int k;
+  
+  double *p = params;
+  double g = p[0];
+  double mu = p[1];
+  double L_1 = p[2];
+  double L_2 = p[3];
+  
+  const double *theta_1 = y;
+  const double *omega_1 = y + count;
+  const double *theta_2 = y + 2 * count;
+  const double *omega_2 = y + 3 * count;
+  const double *v_theta_1 = y + 4 * count;
+  const double *v_omega_1 = y + 5 * count;
+  const double *v_theta_2 = y + 6 * count;
+  const double *v_omega_2 = y + 7 * count;
+  
+  double *d_theta_1 = dydt;
+  double *d_omega_1 = dydt + count;
+  double *d_theta_2 = dydt + 2 * count;
+  double *d_omega_2 = dydt + 3 * count;
+  double *d_v_theta_1 = dydt + 4 * count;
+  double *d_v_omega_1 = dydt + 5 * count;
+  double *d_v_theta_2 = dydt + 6 * count;
+  double *d_v_omega_2 = dydt + 7 * count;
+  
+  #pragma omp simd
+  for (k = 0; k < count; k++) {
+    double sindiff = sin(theta_1[k] - theta_2[k]);
+    double cosdiff = cos(theta_1[k] - theta_2[k]);
+    double denominator = 1 - mu * cosdiff * cosdiff;
+    double sin_1 = sin(theta_1[k]);
+    double cos_1 = cos(theta_1[k]);
+    double sin_12 = sin(theta_1[k] - 2 * theta_2[k]);
+    double cos_12 = cos(theta_1[k] - 2 * theta_2[k]);
+    
+    /* Kinetische Terme L_1 omega_1^2 und L_2 omega_2^2 */
+    double a = L_1 * omega_1[k] * omega_1[k];
+    double b = L_2 * omega_2[k] * omega_2[k];
+    
+    /* Zaehler der Winkelbeschleunigungen: omega' = numerator / (L * D) */
+    double numerator_1 = (0.5 * mu - 1) * g * sin_1 - 0.5 * mu * g * sin_12
+                         - mu * sindiff * (a * cosdiff + b);
+    double numerator_2 = sindiff * (g * cos_1 + a + mu * b * cosdiff);
+    double f_1 = numerator_1 / (L_1 * denominator);
+    double f_2 = numerator_2 / (L_2 * denominator);
+    
+    /* Partielle Ableitungen der Zaehler und des Nenners; der Nenner haengt
+     * nur von theta_1 - theta_2 ab */
+    double cos2diff = cosdiff * cosdiff - sindiff * sindiff;
+    double dD = 2 * mu * cosdiff * sindiff;
+    double dN1_dtheta_1 = (0.5 * mu - 1) * g * cos_1 - 0.5 * mu * g * cos_12
+                          - mu * (a * cos2diff + b * cosdiff);
+    double dN1_dtheta_2 = mu * g * cos_12 + mu * (a * cos2diff + b * cosdiff);
+    double dN1_domega_1 = -2 * mu * sindiff * cosdiff * L_1 * omega_1[k];
+    double dN1_domega_2 = -2 * mu * sindiff * L_2 * omega_2[k];
+    double dN2_dtheta_1 = cosdiff * (g * cos_1 + a + mu * b * cosdiff)
+                          - sindiff * (g * sin_1 + mu * b * sindiff);
+    double dN2_dtheta_2 = -cosdiff * (g * cos_1 + a + mu * b * cosdiff)
+                          + mu * b * sindiff * sindiff;
+    double dN2_domega_1 = 2 * sindiff * L_1 * omega_1[k];
+    double dN2_domega_2 = 2 * mu * sindiff * cosdiff * L_2 * omega_2[k];
+    
+    /* Richtungsableitungen entlang v */
+    double dN1 = dN1_dtheta_1 * v_theta_1[k] + dN1_domega_1 * v_omega_1[k]
+                 + dN1_dtheta_2 * v_theta_2[k] + dN1_domega_2 * v_omega_2[k];
+    double dN2 = dN2_dtheta_1 * v_theta_1[k] + dN2_domega_1 * v_omega_1[k]
+                 + dN2_dtheta_2 * v_theta_2[k] + dN2_domega_2 * v_omega_2[k];
+    double dDv = dD * (v_theta_1[k] - v_theta_2[k]);
+    
+    d_theta_1[k] = omega_1[k];
+    d_omega_1[k] = f_1;
+    d_theta_2[k] = omega_2[k];
+    d_omega_2[k] = f_2;
+    
+    d_v_theta_1[k] = v_omega_1[k];
+    d_v_omega_1[k] = (dN1 / L_1 - f_1 * dDv) / denominator;
+    d_v_theta_2[k] = v_omega_2[k];
+    d_v_omega_2[k] = (dN2 / L_2 - f_2 * dDv) / denominator;
+  }
+}
+
+/* Cody-Waite-Zerlegung von pi/2 und Koeffizienten der Polynome fuer sin und
+ * cos auf [-pi/4, pi/4] (wie in fdlibm) */
+static const double sincos_2_pi = 6.36619772367581382433e-01;
+static const double sincos_pi_2_1 = 1.57079632673412561417e+00;
+static const double sincos_pi_2_2 = 6.07710050630396597660e-11;
+static const double sincos_pi_2_3 = 2.02226624871116645580e-21;
+
+static const double sincos_s1 = -1.66666666666666324348e-01;
+static const double sincos_s2 = 8.33333333332248946124e-03;
+static const double sincos_s3 = -1.98412698298579493134e-04;
+static const double sincos_s4 = 2.75573137070700676789e-06;
+static const double sincos_s5 = -2.50507602534068634195e-08;
+static const double sincos_s6 = 1.58969099521155010221e-10;
+
+static const double sincos_c1 = 4.16666666666666019037e-02;
+static const double sincos_c2 = -1.38888888888741095749e-03;
+static const double sincos_c3 = 2.48015872894767294178e-05;
+static const double sincos_c4 = -2.75573143513906633035e-07;
+static const double sincos_c5 = 2.08757232129817482790e-09;
+static const double sincos_c6 = -1.13596475577881948265e-11;
+
+void double_pendulum_sincos(const double *x, double *s, double *c, int count) {
+  int k;
+  
+  #pragma omp simd
+  for (k = 0; k < count; k++) {
+    /* x = q * pi/2 + r mit |r| <= pi/4, der Quadrant q bestimmt, welches
+     * Polynom mit welchem Vorzeichen sin bzw. cos ergibt. Gerundet wird durch
+     * Umwandeln in int (floor ist ohne Builtins ein Funktionsaufruf), grosse
+     * Winkel werden hier durch 0 ersetzt. */
+    double x_k = (fabs(x[k]) > PENDULUM_SINCOS_MAX) ? 0 : x[k];
+    int quadrant = (int)(x_k * sincos_2_pi + ((x_k < 0) ? -0.5 : 0.5));
+    double q = quadrant;
+    double r = ((x_k - q * sincos_pi_2_1) - q * sincos_pi_2_2)
+               - q * sincos_pi_2_3;
+    double z = r * r;
+    double sin_r = r + r * z * (sincos_s1 + z * (sincos_s2 + z * (sincos_s3
+                   + z * (sincos_s4 + z * (sincos_s5 + z * sincos_s6)))));
+    double cos_r = 1 - 0.5 * z + z * z * (sincos_c1 + z * (sincos_c2
+                   + z * (sincos_c3 + z * (sincos_c4 + z * (sincos_c5
+                   + z * sincos_c6)))));
+    
+    double sin_x = (quadrant & 1) ? cos_r : sin_r;
+    double cos_x = (quadrant & 1) ? sin_r : cos_r;
+    s[k] = (quadrant & 2) ? -sin_x : sin_x;
+    c[k] = ((quadrant + 1) & 2) ? -cos_x : cos_x;
+  }
+  
+  /* Grosse Winkel (selten) mit der Standardbibliothek */
+  for (k = 0; k < count; k++) {
+    if (fabs(x[k]) > PENDULUM_SINCOS_MAX) {
+      s[k] = sin(x[k]);
+      c[k] = cos(x[k]);
+    }
+  }
+}
+
+void double_pendulum_derived(const double *y, double *derived, int count,
+                             int stride, const double *params) {
+  int k;
+  double m_1 = params[0];
+  double m_2 = params[1];
+  double L_1 = params[2];
+  double L_2 = params[3];
+  
+  const double *theta_1 = y;
+  const double *omega_1 = y + stride;
+  const double *theta_2 = y + 2 * stride;
+  const double *omega_2 = y + 3 * stride;
+  
+  double *p_1 = derived;
+  double *p_2 = derived + stride;
+  double *x_1 = derived + 2 * stride;
+  double *y_1 = derived + 3 * stride;
+  double *x_2 = derived + 4 * stride;
+  double *y_2 = derived + 5 * stride;
+  
+  /* Sinus und Kosinus der Winkel werden zunaechst in den Zeilen der
+   * Koordinaten abgelegt */
+  double_pendulum_sincos(theta_1, x_1, y_1, count);
+  double_pendulum_sincos(theta_2, x_2, y_2, count);
+  
+  #pragma omp simd
+  for (k = 0; k < count; k++) {
+    double s_1 = x_1[k], c_1 = y_1[k];
+    double s_2 = x_2[k], c_2 = y_2[k];
+    double cosdiff = c_1 * c_2 + s_1 * s_2;
+    
+    p_1[k] = (m_1 + m_2) * L_1 * L_1 * omega_1[k]
+             + m_2 * L_1 * L_2 * omega_2[k] * cosdiff;
+    p_2[k] = m_2 * L_1 * L_2 * omega_1[k] * cosdiff
+             + m_2 * L_2 * L_2 * omega_2[k];
+    
+    x_1[k] = L_1 * s_1;
+    y_1[k] = -L_1 * c_1;
+    x_2[k] = L_1 * s_1 + L_2 * s_2;
+    y_2[k] = -L_1 * c_1 - L_2 * c_2;
+  }
+}
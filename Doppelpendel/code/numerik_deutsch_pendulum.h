@@ -0,0 +1,73 @@
+#ifndef _PENDULUM_H
+#define _PENDULUM_H
+
+/* Bewegungsgleichungen des Doppelpendels fuer die ODE-Loeser (vgl. ODE_RHS und
+ * ODE_RHS_BATCH) */
+
+/* Inhalt der Binaerdateien (TRAJ_HEADER.kind):
+ * TRAJ_PENDULUM: Spalten t, theta1, omega1, theta2, omega2
+ *                Parameter g, m1, m2, L1, L2, h
+ * TRAJ_SPECTRUM: Spalten omega, |g_k(theta_1)|, |g_k(theta_2)|
+ *                Parameter delta (Abstand der Datenpunkte)
+ * TRAJ_MAP: Spalten T_flip (Zeit bis zum ersten Ueberschlag, -1 wenn keiner
+ *           auftritt) und optional lambda (groesster Lyapunov-Exponent) fuer
+ *           width x height Anfangsbedingungen (theta1, theta2) mit
+ *           omega1 = omega2 = 0, zeilenweise (theta2 konstant je Zeile)
+ *           Parameter width, height, theta_max, t, h, g, m1, m2, L1, L2 */
+enum {
+  TRAJ_PENDULUM = 1,
+  TRAJ_SPECTRUM = 2,
+  TRAJ_MAP = 3
+};
+
+/* Rechte Seite des DGL-Sys. des Doppelpendels
+ * Funktionsargumente:
+ * theta_1 = y[0], omega_1 = y[1]
+ * theta_2 = y[2], omega_2 = y[3]
+ * Die Ableitungen werden in derselben Reihenfolge in "dydt" gespeichert.
+ * Parameter (double-Array):
+ * g = params[0], mu = params[1], L_1 = params[2], L_2 = params[3] */
+void double_pendulum(double t, const double *y, double *dydt, void *params);
+
+/* Rechte Seite fuer "count" Doppelpendel gleichzeitig im "structure of arrays"-
+ * Layout: y[i * count + k] ist das i-te Argument (Reihenfolge wie oben) des
+ * k-ten Pendels */
+void double_pendulum_batch(double t, const double *y, double *dydt, int count,
+                           void *params);
+
+/* Rechte Seite der Bewegungsgleichungen zusammen mit den linearisierten
+ * (Tangenten-) Gleichungen v' = J(y) v (J: Jacobi-Matrix der rechten Seite)
+ * fuer eine Stoerung v = (d_theta_1, d_omega_1, d_theta_2, d_omega_2) in
+ * y[4], ..., y[7]. Das Wachstum von |v| bestimmt den Lyapunov-Exponenten.
+ * Parameter wie bei "double_pendulum". */
+void double_pendulum_tangent(double t, const double *y, double *dydt,
+                             void *params);
+
+/* Wie "double_pendulum_tangent" fuer "count" Pendel im "structure of arrays"-
+ * Layout (8 Zeilen) */
+void double_pendulum_tangent_batch(double t, const double *y, double *dydt,
+                                   int count, void *params);
+
+/* Groesster Betrag eines Winkels, fuer den "double_pendulum_sincos" die
+ * Reduktion auf [-pi/4, pi/4] genau ausfuehrt; groessere Winkel werden mit
+ * sin und cos der Standardbibliothek berechnet */
+#define PENDULUM_SINCOS_MAX 1e5
+
+/* Sinus und Kosinus von "count" Winkeln x[k]. Die Schleife enthaelt nur
+ * Polynome und Auswahlen ohne Bibliotheksaufrufe und wird daher vom Compiler
+ * vektorisiert (Genauigkeit etwa 1 ulp). */
+void double_pendulum_sincos(const double *x, double *s, double *c, int count);
+
+/* Abgeleitete Groessen fuer "count" Zustaende im "structure of arrays"-Layout
+ * mit Zeilenabstand "stride" (y[i * stride + k] ist theta_1, omega_1, theta_2,
+ * omega_2 fuer i = 0, ..., 3): verallgemeinerte Impulse p_1, p_2 und
+ * kartesische Koordinaten x_1, y_1, x_2, y_2 der Punktmassen in
+ * derived[j * stride + k] fuer j = 0, ..., 5 in dieser Reihenfolge.
+ * Pro Zustand werden nur Sinus und Kosinus der beiden Winkel berechnet,
+ * cos(theta_1 - theta_2) folgt aus dem Additionstheorem.
+ * Parameter (double-Array):
+ * m_1 = params[0], m_2 = params[1], L_1 = params[2], L_2 = params[3] */
+void double_pendulum_derived(const double *y, double *derived, int count,
+                             int stride, const double *params);
+
+#endif
@@ -0,0 +1,217 @@
+#include "numerik_deutsch_spectrogram.h"
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+
+/* Erstellt die Spektralanalyse ohne Ausgabedatei */
+static SPECTROGRAM *spectrogram_create(SPECTROGRAM_MODE mode, int window,
+                                      int hop, int channel_1, int channel_2,
+                                      double delta) {
+  int j;
+  int bins = window / 2 + 1;
+  double sum;
+  SPECTROGRAM *ret;
+  
+  if (window < 2 || hop < 1 || hop > window) return NULL;
+  
+  ret = malloc(sizeof(SPECTROGRAM));
+  if (ret == NULL) return NULL;
+  
+  ret->mode = mode;
+  ret->window = window;
+  ret->hop = hop;
+  ret->channel[0] = channel_1;
+  ret->channel[1] = channel_2;
+  ret->delta = delta;
+  ret->count = 0;
+  ret->segments = 0;
+  ret->file = NULL;
+  
+  /* Ringpuffer und Segment (komplex) sowie Fenster und Periodogramme in
+   * jeweils einem Block */
+  ret->ring = malloc(2 * window * sizeof(double complex));
+  ret->weights = malloc((window + 2 * bins) * sizeof(double));
+  ret->plan = fft_plan_alloc(window);
+  if (ret->ring == NULL || ret->weights == NULL || ret->plan == NULL) {
+    free(ret->ring);
+    free(ret->weights);
+    if (ret->plan != NULL) fft_plan_free(ret->plan);
+    free(ret);
+    return NULL;
+  }
+  ret->buffer = ret->ring + window;
+  ret->power = ret->weights + window;
+  
+  /* Periodisches Hann-Fenster (passt zu ueberlappenden Segmenten) */
+  sum = 0;
+  for (j = 0; j < window; j++) {
+    ret->weights[j] = 0.5 * (1 - cos(2 * fft_pi * j / window));
+    sum += ret->weights[j] * ret->weights[j];
+  }
+  ret->norm = window / sum;
+  
+  for (j = 0; j < 2 * bins; j++) {
+    ret->power[j] = 0;
+  }
+  
+  return ret;
+}
+
+SPECTROGRAM *spectrogram_alloc(SPECTROGRAM_MODE mode, int window, int hop,
+                               int channel_1, int channel_2, double delta,
+                               char *filename) {
+  SPECTROGRAM *ret;
+  
+  ret = spectrogram_create(mode, window, hop, channel_1, channel_2, delta);
+  if (ret == NULL) return NULL;
+  
+  if (mode == SPECTROGRAM_STFT) {
+    ret->file = fopen(filename, "w");
+    if (ret->file == NULL) {
+      spectrogram_free(ret);
+      return NULL;
+    }
+    fprintf(ret->file, "t[s]\tomega[rad/s]\tP_1\tP_2\n");
+  }
+  
+  return ret;
+}
+
+int spectrogram_write_state(SPECTROGRAM *spec, FILE *file) {
+  int bins = spec->window / 2 + 1;
+  long offset = 0;
+  
+  /* Bisher geschriebene Laenge der Ausgabedatei */
+  if (spec->file != NULL) {
+    if (fflush(spec->file) != 0) return -1;
+    offset = ftell(spec->file);
+  }
+  
+  if (fwrite(&spec->count, sizeof(long), 1, file) != 1 ||
+      fwrite(&spec->segments, sizeof(long), 1, file) != 1 ||
+      fwrite(&offset, sizeof(long), 1, file) != 1 ||
+      fwrite(spec->ring, sizeof(double complex), spec->window, file)
+      != (size_t)spec->window ||
+      fwrite(spec->power, sizeof(double), 2 * bins, file)
+      != (size_t)(2 * bins)) {
+    return -1;
+  }
+  
+  return 0;
+}
+
+SPECTROGRAM *spectrogram_resume(SPECTROGRAM_MODE mode, int window, int hop,
+                                int channel_1, int channel_2, double delta,
+                                char *filename, FILE *state) {
+  int bins = window / 2 + 1;
+  long offset;
+  SPECTROGRAM *ret;
+  
+  ret = spectrogram_create(mode, window, hop, channel_1, channel_2, delta);
+  if (ret == NULL) return NULL;
+  
+  if (fread(&ret->count, sizeof(long), 1, state) != 1 ||
+      fread(&ret->segments, sizeof(long), 1, state) != 1 ||
+      fread(&offset, sizeof(long), 1, state) != 1 ||
+      fread(ret->ring, sizeof(double complex), window, state)
+      != (size_t)window ||
+      fread(ret->power, sizeof(double), 2 * bins, state)
+      != (size_t)(2 * bins)) {
+    spectrogram_free(ret);
+    return NULL;
+  }
+  
+  /* Ausgabedatei auf den gespeicherten Stand kuerzen und fortsetzen */
+  if (mode == SPECTROGRAM_STFT) {
+    ret->file = fopen(filename, "r+");
+    if (ret->file == NULL || ftruncate(fileno(ret->file), offset) != 0 ||
+        fseek(ret->file, offset, SEEK_SET) != 0) {
+      spectrogram_free(ret);
+      return NULL;
+    }
+  }
+  
+  return ret;
+}
+
+void spectrogram_free(SPECTROGRAM *spec) {
+  if (spec->file != NULL) fclose(spec->file);
+  fft_plan_free(spec->plan);
+  free(spec->ring);
+  free(spec->weights);
+  free(spec);
+}
+
+/* Transformiert das aktuelle Segment (die letzten "window" Werte) und
+ * verarbeitet das Periodogramm; t ist der Zeitpunkt des letzten Werts */
+static void spectrogram_segment(SPECTROGRAM *spec, double t) {
+  int j, k;
+  int n = spec->window;
+  int bins = n / 2 + 1;
+  /* Index des aeltesten Werts im Ringpuffer */
+  int start = spec->count % n;
+  double p_1, p_2;
+  double complex g_1, g_2;
+  
+  /* Werte in zeitlicher Reihenfolge gewichten */
+  for (j = 0; j < n; j++) {
+    spec->buffer[j] = spec->weights[j] * spec->ring[(start + j) % n];
+  }
+  
+  fft_real_pair_execute(spec->plan, spec->buffer);
+  
+  for (k = 0; k < bins; k++) {
+    fft_real_pair_get(n, spec->buffer, k, &g_1, &g_2);
+    p_1 = spec->norm * (creal(g_1) * creal(g_1) + cimag(g_1) * cimag(g_1));
+    p_2 = spec->norm * (creal(g_2) * creal(g_2) + cimag(g_2) * cimag(g_2));
+    
+    if (spec->mode == SPECTROGRAM_WELCH) {
+      spec->power[k] += p_1;
+      spec->power[bins+k] += p_2;
+    } else {
+      fprintf(spec->file, "%f\t%f\t%e\t%e\n",
+              t - 0.5 * (n - 1) * spec->delta,
+              2 * fft_pi * k / (n * spec->delta), p_1, p_2);
+    }
+  }
+  
+  /* Leerzeile trennt die Segmente (Format fuer gnuplot "splot ... pm3d") */
+  if (spec->mode == SPECTROGRAM_STFT) {
+    fprintf(spec->file, "\n");
+  }
+  
+  spec->segments++;
+}
+
+int spectrogram_observe(double t, const double *y, int dimension, void *data) {
+  SPECTROGRAM *spec = data;
+  
+  if (spec->channel[0] >= dimension || spec->channel[1] >= dimension) {
+    return 1;
+  }
+  
+  spec->ring[spec->count % spec->window] =
+    y[spec->channel[0]] + I * y[spec->channel[1]];
+  spec->count++;
+  
+  /* Ein Segment ist voll, wenn seit dem ersten vollen Fenster ein Vielfaches
+   * von "hop" Werten hinzugekommen ist */
+  if (spec->count >= spec->window &&
+      (spec->count - spec->window) % spec->hop == 0) {
+    spectrogram_segment(spec, t);
+  }
+  
+  return 0;
+}
+
+long spectrogram_welch(SPECTROGRAM *spec, double *p_1, double *p_2) {
+  int k;
+  int bins = spec->window / 2 + 1;
+  
+  for (k = 0; k < bins; k++) {
+    p_1[k] = (spec->segments > 0) ? spec->power[k] / spec->segments : 0;
+    p_2[k] = (spec->segments > 0) ? spec->power[bins+k] / spec->segments : 0;
+  }
+  
+  return spec->segments;
+}
@@ -0,0 +1,98 @@
+#ifndef _SPECTROGRAM_H
+#define _SPECTROGRAM_H
+
+#include <stdio.h>
+#include <complex.h>
+#include "numerik_deutsch_fft.h"
+
+/* Spektralanalyse zweier reeller Signale waehrend der Integration
+ *
+ * Die Signale sind die Komponenten y[channel[0]] und y[channel[1]] der
+ * Loesung, die im Abstand "delta" ausgegeben wird. Jeweils die letzten
+ * "window" Werte werden in einem Ringpuffer gehalten; alle "hop" Werte wird
+ * das Segment mit einem Hann-Fenster gewichtet und (beide Signale gemeinsam,
+ * vgl. "fft_real_pair_execute") mit demselben FFT-Plan transformiert. Der
+ * Speicherbedarf haengt daher nur von der Fensterlaenge ab, nicht von der
+ * Laenge der Trajektorie.
+ *
+ * Fuer jedes Segment wird das Periodogramm
+ *   P_k = norm * |g_k|^2  fuer k = 0, ..., window/2
+ * berechnet (g_k: Fourierkoeffizienten wie in "fft" der gewichteten Werte,
+ * norm = window / Sum[w_j^2] gleicht die Daempfung durch das Fenster aus). */
+
+typedef enum {
+  /* Welch-Verfahren: Mittelwert der Periodogramme aller Segmente */
+  SPECTROGRAM_WELCH,
+  /* Kurzzeit-FFT: Das Periodogramm jedes Segments wird in eine Datei
+   * geschrieben (Zeit-Frequenz-Matrix) */
+  SPECTROGRAM_STFT
+} SPECTROGRAM_MODE;
+
+/* Zustand der Spektralanalyse:
+ * count: Anzahl der bisher erhaltenen Werte
+ * segments: Anzahl der transformierten Segmente
+ * ring: die letzten "window" Werte y[channel[0]] + I y[channel[1]]
+ * buffer: gewichtetes Segment bzw. dessen Transformierte
+ * weights: Hann-Fenster
+ * power: Summe der Periodogramme beider Signale (SPECTROGRAM_WELCH,
+ *        power[k] und power[window/2 + 1 + k])
+ * file: Ausgabedatei (SPECTROGRAM_STFT) */
+typedef struct {
+  SPECTROGRAM_MODE mode;
+  int window;
+  int hop;
+  int channel[2];
+  double delta;
+
+  long count;
+  long segments;
+
+  double complex *ring;
+  double complex *buffer;
+  double *weights;
+  double norm;
+  double *power;
+
+  FFT_PLAN *plan;
+  FILE *file;
+} SPECTROGRAM;
+
+/* Erstellt eine Spektralanalyse mit Segmenten der Laenge "window", die um
+ * "hop" Werte gegeneinander verschoben sind (0 < hop <= window). Bei
+ * SPECTROGRAM_STFT werden die Periodogramme in die Datei "filename"
+ * geschrieben (je Zeile t, omega, P(Signal 1), P(Signal 2), Segmente durch
+ * eine Leerzeile getrennt, t ist die Mitte des Segments). Bei Fehlern wird
+ * NULL zurueckgegeben. */
+SPECTROGRAM *spectrogram_alloc(SPECTROGRAM_MODE mode, int window, int hop,
+                               int channel_1, int channel_2, double delta,
+                               char *filename);
+
+/* Schliesst die Ausgabedatei und gibt den Speicher wieder frei */
+void spectrogram_free(SPECTROGRAM *spec);
+
+/* Schreibt den Zustand der Analyse (Ringpuffer, Summe der Periodogramme und
+ * Laenge der Ausgabedatei) fuer einen Checkpoint in "file".
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Fehler beim Schreiben */
+int spectrogram_write_state(SPECTROGRAM *spec, FILE *file);
+
+/* Wie "spectrogram_alloc", setzt aber eine unterbrochene Analyse fort: Der
+ * Zustand wird aus "state" gelesen (vgl. "spectrogram_write_state"), die
+ * Ausgabedatei auf den gespeicherten Stand gekuerzt und fortgesetzt. */
+SPECTROGRAM *spectrogram_resume(SPECTROGRAM_MODE mode, int window, int hop,
+                                int channel_1, int channel_2, double delta,
+                                char *filename, FILE *state);
+
+/* Beobachter fuer die ODE-Loeser (vgl. ODE_OBSERVER, "data" ist das
+ * SPECTROGRAM). Ist ein Kanal keine Komponente der Loesung, wird
+ * abgebrochen. */
+int spectrogram_observe(double t, const double *y, int dimension, void *data);
+
+/* Berechnet den Mittelwert der Periodogramme (SPECTROGRAM_WELCH): Danach
+ * enthalten p_1 und p_2 (je window/2 + 1 Werte) die gemittelten Spektren
+ * beider Signale. Rueckgabewert ist die Anzahl der gemittelten Segmente (0,
+ * wenn die Trajektorie kuerzer als ein Fenster war). */
+long spectrogram_welch(SPECTROGRAM *spec, double *p_1, double *p_2);
+
+#endif
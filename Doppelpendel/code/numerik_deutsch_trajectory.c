@@ -0,0 +1,226 @@
+#include "numerik_deutsch_trajectory.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Setzt die Zeiger auf Parameter und Daten hinter dem Dateikopf */
+static void traj_set_pointers(TRAJECTORY *traj) {
+  traj->header = traj->map;
+  traj->params = (double *)((char *)traj->map + sizeof(TRAJ_HEADER));
+  traj->data = traj->params + traj->header->param_count;
+}
+
+TRAJECTORY *traj_create(char *filename, int kind, int columns, long count,
+                        double *params, int param_count) {
+  int i, fd;
+  TRAJ_HEADER *header;
+  TRAJECTORY *ret;
+  size_t size = sizeof(TRAJ_HEADER)
+                + (param_count + (size_t)columns * count) * sizeof(double);
+  
+  ret = malloc(sizeof(TRAJECTORY));
+  if (ret == NULL) return NULL;
+  
+  /* Datei auf die endgueltige Groesse bringen und abbilden. Der Dateideskriptor
+   * wird danach nicht mehr benoetigt. */
+  fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    free(ret);
+    return NULL;
+  }
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    free(ret);
+    return NULL;
+  }
+  ret->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ret->map == MAP_FAILED) {
+    free(ret);
+    return NULL;
+  }
+  
+  ret->size = size;
+  ret->writable = 1;
+  ret->index = 0;
+  
+  /* Dateikopf */
+  header = ret->map;
+  memcpy(header->magic, TRAJ_MAGIC, 8);
+  header->kind = kind;
+  header->columns = columns;
+  header->count = count;
+  header->valid = 0;
+  header->param_count = param_count;
+  header->reserved = 0;
+  
+  traj_set_pointers(ret);
+  for (i = 0; i < param_count; i++) {
+    ret->params[i] = params[i];
+  }
+  
+  return ret;
+}
+
+TRAJECTORY *traj_open(char *filename) {
+  int fd;
+  struct stat st;
+  TRAJ_HEADER *header;
+  TRAJECTORY *ret;
+  
+  ret = malloc(sizeof(TRAJECTORY));
+  if (ret == NULL) return NULL;
+  
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    free(ret);
+    return NULL;
+  }
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TRAJ_HEADER)) {
+    close(fd);
+    free(ret);
+    return NULL;
+  }
+  
+  ret->size = st.st_size;
+  ret->map = mmap(NULL, ret->size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ret->map == MAP_FAILED) {
+    free(ret);
+    return NULL;
+  }
+  
+  /* Kennung und Groesse ueberpruefen */
+  header = ret->map;
+  if (memcmp(header->magic, TRAJ_MAGIC, 8) != 0 ||
+      header->columns < 0 || header->count < 0 || header->param_count < 0 ||
+      header->valid < 0 || header->valid > header->count ||
+      ret->size < sizeof(TRAJ_HEADER) + (header->param_count
+                  + (size_t)header->columns * header->count) * sizeof(double)) {
+    munmap(ret->map, ret->size);
+    free(ret);
+    return NULL;
+  }
+  
+  ret->writable = 0;
+  ret->index = header->valid;
+  traj_set_pointers(ret);
+  
+  return ret;
+}
+
+TRAJECTORY *traj_resume(char *filename, int kind, int columns, long count,
+                        long index) {
+  int c, fd;
+  struct stat st;
+  TRAJ_HEADER header;
+  TRAJECTORY *ret;
+  size_t size, map_size;
+  long old_count;
+  
+  fd = open(filename, O_RDWR);
+  if (fd < 0) return NULL;
+  
+  /* Dateikopf ueberpruefen, bevor die Datei veraendert wird */
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TRAJ_HEADER) ||
+      read(fd, &header, sizeof(TRAJ_HEADER)) != sizeof(TRAJ_HEADER) ||
+      memcmp(header.magic, TRAJ_MAGIC, 8) != 0 || header.kind != kind ||
+      header.columns != columns || header.param_count < 0 ||
+      header.count < index || count < index ||
+      (size_t)st.st_size < sizeof(TRAJ_HEADER) + (header.param_count
+                           + (size_t)columns * header.count) * sizeof(double)) {
+    close(fd);
+    return NULL;
+  }
+  old_count = header.count;
+  size = sizeof(TRAJ_HEADER)
+         + (header.param_count + (size_t)columns * count) * sizeof(double);
+  
+  ret = malloc(sizeof(TRAJECTORY));
+  if (ret == NULL) {
+    close(fd);
+    return NULL;
+  }
+  
+  /* Abgebildet wird die groessere der beiden Laengen, damit die Spalten
+   * verschoben werden koennen */
+  map_size = (count > old_count) ? size : (size_t)st.st_size;
+  if ((count > old_count && ftruncate(fd, size) != 0) ||
+      (ret->map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0)) == MAP_FAILED) {
+    close(fd);
+    free(ret);
+    return NULL;
+  }
+  ret->size = map_size;
+  traj_set_pointers(ret);
+  
+  /* Die Spalten liegen hintereinander: Beim Verlaengern wird von hinten, beim
+   * Verkuerzen von vorne verschoben, damit keine Spalte ueberschrieben wird,
+   * bevor sie verschoben ist */
+  if (count > old_count) {
+    for (c = columns - 1; c > 0; c--) {
+      memmove(ret->data + c * count, ret->data + c * old_count,
+              index * sizeof(double));
+    }
+  } else if (count < old_count) {
+    for (c = 1; c < columns; c++) {
+      memmove(ret->data + c * count, ret->data + c * old_count,
+              index * sizeof(double));
+    }
+    munmap(ret->map, map_size);
+    if (ftruncate(fd, size) != 0 ||
+        (ret->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         fd, 0)) == MAP_FAILED) {
+      close(fd);
+      free(ret);
+      return NULL;
+    }
+    ret->size = size;
+    traj_set_pointers(ret);
+  }
+  close(fd);
+  
+  ret->header->count = count;
+  ret->header->valid = index;
+  ret->writable = 1;
+  ret->index = index;
+  
+  return ret;
+}
+
+double *traj_column(TRAJECTORY *traj, int c) {
+  return traj->data + c * traj->header->count;
+}
+
+int traj_observe(double t, const double *y, int dimension, void *data) {
+  int i;
+  TRAJECTORY *traj = data;
+  int64_t count = traj->header->count;
+  
+  if (traj->index >= count || dimension + 1 > traj->header->columns) return 1;
+  
+  traj->data[traj->index] = t;
+  for (i = 0; i < dimension; i++) {
+    traj->data[(i + 1) * count + traj->index] = y[i];
+  }
+  traj->index++;
+  
+  return 0;
+}
+
+int traj_close(TRAJECTORY *traj) {
+  int ret = 0;
+  
+  if (traj->writable) {
+    if (traj->index > 0) traj->header->valid = traj->index;
+    if (msync(traj->map, traj->size, MS_SYNC) != 0) ret = -1;
+  }
+  
+  munmap(traj->map, traj->size);
+  free(traj);
+  return ret;
+}
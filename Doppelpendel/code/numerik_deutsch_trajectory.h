@@ -0,0 +1,92 @@
+#ifndef _TRAJECTORY_H
+#define _TRAJECTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Binaeres Dateiformat fuer Trajektorien und Spektren
+ *
+ * Aufbau der Datei:
+ * - TRAJ_HEADER (40 Byte)
+ * - "param_count" Parameter (double)
+ * - "columns" Spalten mit je "count" Werten (double), spaltenweise hinter-
+ *   einander wie in ODE_SOLUTION (Spalte 0: t, Spalte i + 1: y[i])
+ *
+ * Alle Werte werden in der Byte-Reihenfolge des erzeugenden Rechners
+ * gespeichert. Die Datei wird beim Erstellen auf ihre endgueltige Groesse
+ * gebracht und in den Speicher abgebildet (mmap), sodass beim Schreiben keine
+ * Formatierung und beim Lesen keine Kopie noetig ist. */
+
+/* Kennung am Dateianfang */
+#define TRAJ_MAGIC "NUMTRAJ1"
+
+typedef struct {
+  char magic[8];
+  /* Art des Inhalts (vom Anwender festgelegt) */
+  int32_t kind;
+  /* Anzahl der Spalten */
+  int32_t columns;
+  /* Laenge jeder Spalte */
+  int64_t count;
+  /* Anzahl der tatsaechlich geschriebenen Zeilen */
+  int64_t valid;
+  /* Anzahl der Parameter hinter dem Kopf */
+  int32_t param_count;
+  int32_t reserved;
+} TRAJ_HEADER;
+
+/* Geoeffnete (abgebildete) Datei:
+ * header, params, data: Zeiger in den abgebildeten Speicher, data[c * count + i]
+ *                       ist der i-te Wert der c-ten Spalte
+ * index: naechste zu schreibende Zeile (fuer "traj_observe") */
+typedef struct {
+  TRAJ_HEADER *header;
+  double *params;
+  double *data;
+
+  int writable;
+  int64_t index;
+
+  void *map;
+  size_t size;
+} TRAJECTORY;
+
+
+/* Erstellt die Datei "filename" fuer "columns" Spalten der Laenge "count" mit
+ * den Parametern "params" und bildet sie zum Schreiben ab. Bei Fehlern wird
+ * NULL zurueckgegeben. */
+TRAJECTORY *traj_create(char *filename, int kind, int columns, long count,
+                        double *params, int param_count);
+
+/* Oeffnet die Datei "filename" zum Lesen. Die Daten werden nicht kopiert. Bei
+ * Fehlern (auch ungueltigem Dateikopf) wird NULL zurueckgegeben. */
+TRAJECTORY *traj_open(char *filename);
+
+/* Oeffnet die mit "traj_create" erstellte Datei "filename" erneut zum
+ * Schreiben, um eine unterbrochene Rechnung fortzusetzen: Die ersten "index"
+ * Zeilen bleiben erhalten, "traj_observe" schreibt danach in Zeile "index"
+ * weiter. Die Spalten werden auf die Laenge "count" (>= index) gebracht, eine
+ * Rechnung kann so auch verlaengert werden. Stimmen "kind" und "columns" nicht
+ * mit dem Dateikopf ueberein oder enthaelt die Datei weniger als "index"
+ * Zeilen, wird NULL zurueckgegeben. */
+TRAJECTORY *traj_resume(char *filename, int kind, int columns, long count,
+                        long index);
+
+/* Liefert einen Zeiger auf die c-te Spalte */
+double *traj_column(TRAJECTORY *traj, int c);
+
+/* Beobachter fuer die ODE-Loeser (vgl. ODE_OBSERVER, "data" ist die
+ * TRAJECTORY): Schreibt t in Spalte 0 und y in die Spalten 1 bis "dimension"
+ * der naechsten Zeile. Ist die Datei voll, wird abgebrochen. */
+int traj_observe(double t, const double *y, int dimension, void *data);
+
+/* Schliesst die Datei. Wurde mit "traj_observe" geschrieben, wird die Anzahl
+ * der geschriebenen Zeilen im Kopf vermerkt (werden die Spalten direkt
+ * beschrieben, muss "header->valid" selbst gesetzt werden). Beim Schreiben
+ * werden die Daten anschliessend zurueckgeschrieben.
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Fehler beim Zurueckschreiben */
+int traj_close(TRAJECTORY *traj);
+
+#endif
@@ -1,30 +1,61 @@
-/* gcc -o numerik_5 -O2 numerik_bespin_deutsch_sparse_matrix.c numerik_bespin_deutsch_poisson.c numerik_bespin_deutsch_5.c -lm */
+/* gcc -o numerik_5 -O2 numerik_bespin_deutsch_sparse_matrix.c numerik_bespin_deutsch_poisson.c numerik_bespin_deutsch_multigrid.c numerik_bespin_deutsch_5.c -lm */
+/* Mit mehreren Threads fuer das SOR-Verfahren (solver 6, optional):
+ * gcc -o numerik_5 -O2 -fopenmp numerik_bespin_deutsch_sparse_matrix.c numerik_bespin_deutsch_poisson.c numerik_bespin_deutsch_multigrid.c numerik_bespin_deutsch_5.c -lm */
 /* Christian Bespin, Christopher Deutsch */
 
 /* Programmaufruf: Erklaerung bei Aufruf des Programms ohne Argumente */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "numerik_bespin_deutsch_sparse_matrix.h"
 #include "numerik_bespin_deutsch_poisson.h"
+#include "numerik_bespin_deutsch_multigrid.h"
 
 int main(int argc, char **argv) {
   GRID *grid = NULL;
   SPARSE_MATRIX *A = NULL;
   VECTOR *b = NULL, *x = NULL;
-  int i, ret = -1, a = -1, sym = -1;
+  STENCIL *stencil = NULL;
+  MULTIGRID *mg = NULL;
+  double *history = NULL;
+  double omega = 0;
+  COLORING *coloring = NULL;
+  FILE *file;
+  int i, ret = -1, a = -1, sym = -1, solver = 0;
   
-  if (argc != 3) {
-    printf("Benutzung: %s a sym\n"
+  if (argc < 3 || argc > 5) {
+    printf("Benutzung: %s a sym [solver [omega]]\n"
            "a: Gitterabstand in Hundersteln\n"
            "sym: 0 keine Symmetrie\n"
-           "     1 Symmetrie\n", argv[0]);
+           "     1 Symmetrie\n"
+           "solver: 0 Gauss-Seidel mit duenner Matrix (Standard)\n"
+           "        1 Gauss-Seidel ohne Matrix direkt auf dem Gitter\n"
+           "        2 Mehrgitterverfahren\n"
+           "        3 cg-Verfahren, Jacobi-Vorkonditionierung\n"
+           "        4 cg-Verfahren, SSOR-Vorkonditionierung\n"
+           "        5 cg-Verfahren, unvollstaendige Cholesky-Zerlegung\n"
+           "        6 SOR-Verfahren rot-schwarz (parallel mit OpenMP)\n"
+           "omega: Relaxationsparameter fuer solver 6 (0 < omega < 2),\n"
+           "       ohne Angabe wird der optimale Wert geschaetzt\n",
+           argv[0]);
+    return -1;
   }
   
   if (sscanf(argv[1], "%i", &a) != 1 ||
-      sscanf(argv[2], "%i", &sym) != 1) {
+      sscanf(argv[2], "%i", &sym) != 1 ||
+      (argc >= 4 && sscanf(argv[3], "%i", &solver) != 1) ||
+      (argc == 5 && sscanf(argv[4], "%lf", &omega) != 1)) {
     printf("Auslesen der Programmargumente fehlgeschlagen\n");
     return -1;
   }
+  if (solver < 0 || solver > 6) {
+    printf("Ungueltiges Loesungsverfahren\n");
+    return -1;
+  }
+  if (argc == 5 && (solver != 6 || !(omega > 0 && omega < 2))) {
+    printf("Ungueltiger Relaxationsparameter\n");
+    return -1;
+  }
   
   /* Erstelle die Geometrie des Problems in "grid" */
   printf("Diskretisierung der Geometrie...\n");
@@ -47,37 +78,140 @@ int main(int argc, char **argv) {
     return -1;
   }
   
-  /* Erstelle das aus der Diskretisierung folgende Gleichungsystem in der Koef-
-   * fizientenmatrix "A" und der Inhomogenitaet "b" */
-  printf("Aufstellen des Gleichungssystems...\n");
-  ret = setup_gls(grid, &A, &b);
-  if (ret == -1) {
-    printf("Fehler bei der Allokierung des Speichers fuer das Gleichungssystem\n");
-    return -1;
-  } else if (ret == -2) {
-    printf("Fehler bei der Allokierung des Speichers der duennen Matrix\n");
-    return -1;
-  }
-  
-  
-  /* Naeherungsloesung fuer das Gauss-Seidel-Verfahren */
-  printf("Loesen des Gleichungssystems...\n");
-  x = vector_alloc(grid->eq_count);
-  if (x == NULL) {
-    printf("Fehler bei der Allokierung des Speichers des Loesungsvektors\n");
-  }
-  for (i = 0; i < grid->eq_count; i++) {
-    x->elem[i] = 0.24;
+  if (solver == 2) {
+    /* Mehrgitterverfahren: Stufen mit groeberen Gitterabstaenden */
+    printf("Aufstellen der Gitterstufen...\n");
+    mg = multigrid_alloc(grid, a, sym);
+    if (mg == NULL) {
+      printf("Fehler bei der Allokierung des Speichers fuer die "
+             "Gitterstufen\n");
+      return -1;
+    }
+    
+    printf("Loesen des Gleichungssystems...\n");
+    ret = multigrid_solve(mg, 1E-6);
+    if (ret < 0) {
+      printf("Fehler bei der Allokierung des Speichers fuer das "
+             "Mehrgitterverfahren\n");
+      return -1;
+    }
+    printf("%i Stufen, %i V-Zyklen\n", mg->levels, ret);
+  } else if (solver == 1) {
+    /* Ohne Matrix: Koeffizienten des 5-Punkte-Sterns fuer jeden Punkt */
+    printf("Aufstellen der Koeffizienten...\n");
+    stencil = setup_stencil(grid);
+    if (stencil == NULL) {
+      printf("Fehler bei der Allokierung des Speichers fuer die "
+             "Koeffizienten\n");
+      return -1;
+    }
+    
+    /* Startwert wie beim Gauss-Seidel-Verfahren mit Matrix */
+    printf("Loesen des Gleichungssystems...\n");
+    for (i = 0; i < grid->m * grid->n; i++) {
+      if (grid->grid[i].type != DIRICHLET && grid->grid[i].type != NONE) {
+        grid->grid[i].u = 0.24;
+      }
+    }
+    stencil_gauss_seidel(grid, stencil, 1E-6);
+  } else {
+    /* Erstelle das aus der Diskretisierung folgende Gleichungsystem in der
+     * Koeffizientenmatrix "A" und der Inhomogenitaet "b" */
+    printf("Aufstellen des Gleichungssystems...\n");
+    ret = setup_gls(grid, &A, &b);
+    if (ret == -1) {
+      printf("Fehler bei der Allokierung des Speichers fuer das "
+             "Gleichungssystem\n");
+      return -1;
+    } else if (ret == -2) {
+      printf("Fehler bei der Allokierung des Speichers der duennen Matrix\n");
+      return -1;
+    }
+    
+    /* Naeherungsloesung fuer das Iterationsverfahren */
+    printf("Loesen des Gleichungssystems...\n");
+    x = vector_alloc(grid->eq_count);
+    if (x == NULL) {
+      printf("Fehler bei der Allokierung des Speichers des "
+             "Loesungsvektors\n");
+      return -1;
+    }
+    for (i = 0; i < grid->eq_count; i++) {
+      x->elem[i] = 0.24;
+    }
+    
+    if (solver == 6) {
+      /* Zeilen gleicher Farbe werden gleichzeitig aktualisiert */
+      coloring = matrix_coloring(A);
+      if (coloring == NULL) {
+        printf("Fehler bei der Allokierung des Speichers fuer die "
+               "Faerbung\n");
+        return -1;
+      }
+      
+      /* Symmetrisches System fuer die Schaetzung von omega (die Iteration
+       * aendert sich durch das Skalieren der Zeilen nicht) */
+      if (argc != 5) {
+        symmetric_gls(grid, A, b);
+        omega = sor_omega(A, &ret);
+        printf("omega = %f (geschaetzt in %i Lanczos-Schritten)\n", omega,
+               ret);
+      }
+      ret = multicolor_sor(A, coloring, b, x, omega, 1E-6);
+      printf("%i Farben, %i Schritte\n", coloring->colors, ret);
+    } else if (solver >= 3) {
+      /* cg-Verfahren fuer das symmetrische System, Abbruch bei einem
+       * relativen Residuum von 1E-10 (entspricht etwa der Genauigkeit des
+       * Gauss-Seidel-Verfahrens mit 1E-6), hoechstens eq_count Schritte */
+      symmetric_gls(grid, A, b);
+      history = malloc((grid->eq_count + 1) * sizeof(double));
+      if (history == NULL) {
+        printf("Fehler bei der Allokierung des Speichers fuer den "
+               "Residuenverlauf\n");
+        return -1;
+      }
+      
+      ret = pcg(A, b, x, 1E-10, solver == 3 ? PCG_JACOBI :
+                (solver == 4 ? PCG_SSOR : PCG_IC),
+                grid->eq_count, history);
+      if (ret == -2) {
+        printf("Fehler bei der Allokierung des Speichers fuer das "
+               "cg-Verfahren\n");
+        return -1;
+      } else if (ret == -3) {
+        printf("Keine Konvergenz nach %i Iterationen\n", grid->eq_count);
+      } else if (ret == -4) {
+        printf("Vorkonditionierer nicht positiv definit\n");
+        return -1;
+      } else {
+        printf("%i Iterationen, relatives Residuum %e\n", ret,
+               history[ret]);
+        
+        /* Verlauf des relativen Residuums |r_k| / |b| */
+        file = fopen("bespin_deutsch_pcg_residuum.txt", "w");
+        if (file != NULL) {
+          fprintf(file, "{");
+          for (i = 0; i <= ret; i++) {
+            fprintf(file, "%e", history[i]);
+            if (i < ret) fprintf(file, ",");
+          }
+          fprintf(file, "}\n");
+          fclose(file);
+          printf("Residuenverlauf geschrieben in "
+                 "bespin_deutsch_pcg_residuum.txt\n");
+        }
+      }
+    } else {
+      /* Loese das Gleichungssystem mit dem Gauß-Seidel-Verfahren. "x"
+       * enthaelt zunaechst den Startvektor des Iterationsverfahrens und
+       * nachher die Loesung des Gleichungssystems A x = b */
+      gauss_seidel(A, b, x, 1E-6);
+    }
+    
+    /* Ordnet die berechnete Loesung wieder in die Geometrie ein */
+    enter_solution(grid, x);
   }
   
-  /* Loese das Gleichungssystem mit dem Gauß-Seidel-Verfahren. "x" enthaelt
-   * zunaechst den Startvektor des Iterationsverfahrens und nachher die Loesung
-   * des Gleichungssystems A x = b */
-  gauss_seidel(A, b, x, 1E-6);
-  
-  /* Ordnet die berechnete Loesung wieder in die Geometrie ein */
-  enter_solution(grid, x);
-  
   /* Output */
   if (sym == 0) {
     mathematica_output(grid, "bespin_deutsch_poisson_loesung.txt");
@@ -89,9 +223,13 @@ int main(int argc, char **argv) {
   
   /* Allokierten Speicher freigeben */
   grid_free(grid);
-  matrix_free(A);
-  vector_free(b);
-  vector_free(x);
+  if (A != NULL) matrix_free(A);
+  if (b != NULL) vector_free(b);
+  if (x != NULL) vector_free(x);
+  free(stencil);
+  if (mg != NULL) multigrid_free(mg);
+  free(history);
+  if (coloring != NULL) coloring_free(coloring);
   
   return 0;
 }
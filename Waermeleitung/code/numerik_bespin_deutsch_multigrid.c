@@ -0,0 +1,299 @@
+#include "numerik_bespin_deutsch_multigrid.h"
+#include <stdlib.h>
+#include <math.h>
+
+/* Ist der Punkt eine Unbekannte des Gleichungssystems? */
+static int mg_unknown(GridPoint *point) {
+  return point->type == REGULAR ||
+         point->type == NEUMANN_Y ||
+         point->type == NEUMANN_X ||
+         point->type == NEUMANN_XY;
+}
+
+/* Erstellt Koeffizienten und Arrays einer Stufe fuer das Gitter "grid"
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Allokierung fehlgeschlagen */
+static int mg_level_alloc(MG_LEVEL *level, GRID *grid) {
+  int i;
+  int size = grid->m * grid->n;
+  
+  level->grid = grid;
+  level->ratio = 0;
+  level->stencil = setup_stencil(grid);
+  level->u = malloc(3 * size * sizeof(double));
+  if (level->stencil == NULL || level->u == NULL) {
+    free(level->stencil);
+    free(level->u);
+    return -1;
+  }
+  level->f = level->u + size;
+  level->r = level->f + size;
+  
+  for (i = 0; i < 3 * size; i++) {
+    level->u[i] = 0;
+  }
+  
+  return 0;
+}
+
+MULTIGRID *multigrid_alloc(GRID *grid, int h_100, int sym) {
+  int p;
+  /* Verbleibender Faktor bis zum groebsten darstellbaren Gitterabstand */
+  int q = (sym ? 50 : 100) / h_100;
+  GRID *coarse = grid;
+  MULTIGRID *ret = malloc(sizeof(MULTIGRID));
+  
+  if (ret == NULL) return NULL;
+  ret->levels = 0;
+  
+  while (1) {
+    if (mg_level_alloc(&ret->level[ret->levels], coarse) != 0) {
+      if (coarse != grid) grid_free(coarse);
+      multigrid_free(ret);
+      return NULL;
+    }
+    ret->levels++;
+  
+    if (q == 1 || ret->levels == MG_MAX_LEVELS) break;
+  
+    /* Naechster Gitterabstand: kleinster Primfaktor von q */
+    for (p = 2; q % p != 0; p++);
+    q /= p;
+    h_100 *= p;
+    ret->level[ret->levels-1].ratio = p;
+  
+    if ((sym ? geometry_sym(&coarse, h_100) : geometry(&coarse, h_100))
+        != 0) {
+      ret->level[ret->levels-1].ratio = 0;
+      multigrid_free(ret);
+      return NULL;
+    }
+  }
+  
+  return ret;
+}
+
+void multigrid_free(MULTIGRID *mg) {
+  int l;
+  
+  for (l = 0; l < mg->levels; l++) {
+    free(mg->level[l].stencil);
+    free(mg->level[l].u);
+    /* Das feinste Gitter gehoert dem Aufrufer */
+    if (l > 0) grid_free(mg->level[l].grid);
+  }
+  free(mg);
+}
+
+/* Gauss-Seidel-Schritte fuer 4 u - Summe weight[d] u_d = f. Rueckgabewert ist
+ * die maximale Aenderung im letzten Schritt. */
+static double mg_smooth(MG_LEVEL *level, int sweeps) {
+  int s, k, d, index;
+  int count = level->grid->eq_count;
+  int offset[4];
+  double delta = 0, v;
+  double *u = level->u;
+  STENCIL *stencil = level->stencil;
+  
+  offset[0] = level->grid->n;
+  offset[1] = -level->grid->n;
+  offset[2] = -1;
+  offset[3] = 1;
+  
+  for (s = 0; s < sweeps; s++) {
+    delta = 0;
+    for (k = 0; k < count; k++) {
+      index = stencil[k].index;
+      v = level->f[index];
+      for (d = 0; d < 4; d++) {
+        if (stencil[k].weight[d] != 0) {
+          v += stencil[k].weight[d] * u[index + offset[d]];
+        }
+      }
+      v /= 4;
+      if (delta < fabs(v - u[index])) delta = fabs(v - u[index]);
+      u[index] = v;
+    }
+  }
+  
+  return delta;
+}
+
+/* Berechnet das Residuum r = f - A u */
+static void mg_residual(MG_LEVEL *level) {
+  int k, d, index;
+  int count = level->grid->eq_count;
+  int offset[4];
+  double v;
+  double *u = level->u;
+  STENCIL *stencil = level->stencil;
+  
+  offset[0] = level->grid->n;
+  offset[1] = -level->grid->n;
+  offset[2] = -1;
+  offset[3] = 1;
+  
+  for (k = 0; k < count; k++) {
+    index = stencil[k].index;
+    v = level->f[index] - 4 * u[index];
+    for (d = 0; d < 4; d++) {
+      if (stencil[k].weight[d] != 0) {
+        v += stencil[k].weight[d] * u[index + offset[d]];
+      }
+    }
+    level->r[index] = v;
+  }
+}
+
+/* Rechte Seite der groben Stufe f_c = P^T r (die Gleichungen sind mit h^2
+ * multipliziert, daher entfaellt der Faktor 1/q^2 der Restriktion), Start-
+ * wert der Korrektur 0. Ausserhalb des Gitters liegen nur Punkte jenseits
+ * von Neumann-Raendern (unten und rechts), deren Residuum gespiegelt wird. */
+static void mg_restrict(MG_LEVEL *fine, MG_LEVEL *coarse) {
+  int k, i, j, di, dj, index;
+  int q = fine->ratio;
+  int m = fine->grid->m, n = fine->grid->n;
+  int n_c = coarse->grid->n;
+  double sum;
+  
+  for (k = 0; k < coarse->grid->eq_count; k++) {
+    index = coarse->stencil[k].index;
+    sum = 0;
+    for (di = 1 - q; di < q; di++) {
+      i = (index / n_c) * q + di;
+      if (i < 0) i = -i;
+      if (i >= m) continue;
+      for (dj = 1 - q; dj < q; dj++) {
+        j = (index % n_c) * q + dj;
+        if (j >= n) j = 2 * (n - 1) - j;
+        if (j < 0) continue;
+        sum += (q - abs(di)) * (q - abs(dj)) * fine->r[i * n + j];
+      }
+    }
+    coarse->f[index] = sum / (q * q);
+    coarse->u[index] = 0;
+  }
+}
+
+/* Bilineare Interpolation von der groben Stufe auf alle Unbekannten der
+ * feinen Stufe. Bei full = 0 wird die Korrektur addiert (bekannte Werte sind
+ * 0), bei full = 1 wird eine Loesung interpoliert (bekannte Werte aus dem
+ * groben Grid). */
+static void mg_interpolate(MG_LEVEL *fine, MG_LEVEL *coarse, int full) {
+  int k, a, b, c, index, i_c, j_c, i, j;
+  int q = fine->ratio;
+  int n = fine->grid->n;
+  int n_c = coarse->grid->n;
+  double sum, w;
+  GridPoint *point;
+  
+  for (k = 0; k < fine->grid->eq_count; k++) {
+    index = fine->stencil[k].index;
+    a = (index / n) % q;
+    b = (index % n) % q;
+    i_c = (index / n) / q;
+    j_c = (index % n) / q;
+  
+    /* Ecken der groben Zelle (Gewichte 0 werden nicht gelesen, die Zelle
+     * kann am Rand des Gitters enden) */
+    sum = 0;
+    for (c = 0; c < 4; c++) {
+      i = i_c + c / 2;
+      j = j_c + c % 2;
+      w = ((c / 2) ? a : q - a) * ((c % 2) ? b : q - b);
+      if (w == 0) continue;
+  
+      point = &(coarse->grid->grid[i * n_c + j]);
+      if (mg_unknown(point)) {
+        sum += w * coarse->u[i * n_c + j];
+      } else if (full && point->type == DIRICHLET) {
+        sum += w * point->u;
+      }
+    }
+  
+    if (full) {
+      fine->u[index] = sum / (q * q);
+    } else {
+      fine->u[index] += sum / (q * q);
+    }
+  }
+}
+
+/* V-Zyklus ab Stufe l mit der rechten Seite level[l].f */
+static void mg_vcycle(MULTIGRID *mg, int l) {
+  int s;
+  MG_LEVEL *level = &(mg->level[l]);
+  
+  /* Groebstes Gitter: Gauss-Seidel bis zur Konvergenz */
+  if (l == mg->levels - 1) {
+    for (s = 0; s < MG_COARSE_SWEEPS; s++) {
+      if (mg_smooth(level, 1) < 1E-15) break;
+    }
+    return;
+  }
+  
+  mg_smooth(level, MG_PRE_SMOOTH);
+  mg_residual(level);
+  mg_restrict(level, &(mg->level[l+1]));
+  mg_vcycle(mg, l + 1);
+  mg_interpolate(level, &(mg->level[l+1]), 0);
+  mg_smooth(level, MG_POST_SMOOTH);
+}
+
+int multigrid_solve(MULTIGRID *mg, double epsilon) {
+  int l, k, index, cycles;
+  double delta;
+  MG_LEVEL *level;
+  /* Werte vor dem V-Zyklus (im Residuum des feinsten Gitters, das nach
+   * "mg_residual" nicht mehr benoetigt wird, geht nicht: eigenes Array) */
+  double *prev = malloc(mg->level[0].grid->eq_count * sizeof(double));
+  
+  if (prev == NULL) return -1;
+  
+  /* Rechte Seiten aller Stufen (h^2 f und bekannte Nachbarn) */
+  for (l = 0; l < mg->levels; l++) {
+    level = &(mg->level[l]);
+    for (k = 0; k < level->grid->eq_count; k++) {
+      level->f[level->stencil[k].index] = level->stencil[k].rhs;
+    }
+  }
+  
+  /* FMG: Loesung auf dem groebsten Gitter, dann je Stufe Interpolation und
+   * ein V-Zyklus */
+  mg_vcycle(mg, mg->levels - 1);
+  for (l = mg->levels - 2; l >= 0; l--) {
+    mg_interpolate(&(mg->level[l]), &(mg->level[l+1]), 1);
+    mg_vcycle(mg, l);
+  }
+  
+  /* V-Zyklen auf dem feinsten Gitter */
+  level = &(mg->level[0]);
+  cycles = 0;
+  do {
+    for (k = 0; k < level->grid->eq_count; k++) {
+      prev[k] = level->u[level->stencil[k].index];
+    }
+  
+    mg_vcycle(mg, 0);
+    cycles++;
+  
+    delta = 0;
+    for (k = 0; k < level->grid->eq_count; k++) {
+      index = level->stencil[k].index;
+      if (delta < fabs(prev[k] - level->u[index])) {
+        delta = fabs(prev[k] - level->u[index]);
+      }
+    }
+  } while (delta > epsilon);
+  
+  /* Loesung in das Grid eintragen */
+  for (k = 0; k < level->grid->eq_count; k++) {
+    index = level->stencil[k].index;
+    level->grid->grid[index].u = level->u[index];
+  }
+  
+  free(prev);
+  
+  return cycles;
+}
@@ -0,0 +1,68 @@
+#ifndef _MULTIGRID_H
+#define _MULTIGRID_H
+
+#include "numerik_bespin_deutsch_poisson.h"
+
+/* Mehrgitterverfahren fuer die diskrete Poisson-Gleichung
+ *
+ * Die Stufen sind die Geometrien (vgl. "geometry"/"geometry_sym") mit den
+ * Gitterabstaenden h_0 < h_1 < ...: h_(l+1) = q h_l, wobei q der kleinste
+ * Primfaktor ist, fuer den die Geometrie noch darstellbar ist (bei 100 bzw.
+ * 50 ohne Rest teilt). Die Gitter sind damit ineinander geschachtelt, die
+ * Raender der Furchen liegen auf allen Stufen auf Gitterpunkten.
+ *
+ * Die Gleichungen sind wie bei "setup_gls" mit h^2 multipliziert. Die
+ * Grobgitterkorrektur verwendet die bilineare Interpolation P und als
+ * Restriktion P^T (bei q = 2 die gewichtete Mittelung ueber 9 Punkte),
+ * jeweils an Neumann-Raendern gespiegelt. Auf jeder Stufe wird mit dem Gauss-
+ * Seidel-Verfahren (wie "stencil_gauss_seidel") geglaettet. */
+
+/* Maximale Anzahl der Stufen */
+#define MG_MAX_LEVELS 16
+
+/* Gauss-Seidel-Schritte vor und nach der Grobgitterkorrektur */
+#define MG_PRE_SMOOTH 2
+#define MG_POST_SMOOTH 2
+
+/* Maximale Anzahl der Gauss-Seidel-Schritte auf dem groebsten Gitter */
+#define MG_COARSE_SWEEPS 1000
+
+/* Eine Stufe des Verfahrens:
+ * grid: Geometrie der Stufe
+ * stencil: Koeffizienten des 5-Punkte-Sterns (vgl. "setup_stencil")
+ * ratio: Verhaeltnis der Gitterabstaende zur naechst groeberen Stufe
+ * u: Loesung bzw. Korrektur fuer alle Gitterpunkte (Index wie grid->grid)
+ * f: rechte Seite (nur Punkte mit unbekanntem u)
+ * r: Residuum (0 fuer Punkte mit bekanntem u) */
+typedef struct {
+  GRID *grid;
+  STENCIL *stencil;
+  int ratio;
+  double *u;
+  double *f;
+  double *r;
+} MG_LEVEL;
+
+typedef struct {
+  int levels;
+  MG_LEVEL level[MG_MAX_LEVELS];
+} MULTIGRID;
+
+/* Erstellt die Stufen fuer das Gitter "grid" (erstellt mit "geometry" bzw.
+ * "geometry_sym" (sym = 1) und Gitterabstand "h_100" in Hundertsteln). Das
+ * feinste Gitter "grid" gehoert weiterhin dem Aufrufer. Bei fehlgeschlagener
+ * Allokierung wird NULL zurueckgegeben. */
+MULTIGRID *multigrid_alloc(GRID *grid, int h_100, int sym);
+
+/* Gibt den Speicher der groeberen Stufen wieder frei */
+void multigrid_free(MULTIGRID *mg);
+
+/* Loest die diskrete Poisson-Gleichung auf dem feinsten Gitter: Zuerst wird
+ * mit dem vollen Mehrgitterverfahren (FMG: Loesung auf dem groebsten Gitter,
+ * Interpolation und ein V-Zyklus je Stufe) ein Startwert bestimmt, danach
+ * werden V-Zyklen durchgefuehrt, bis sich kein Wert mehr als "epsilon"
+ * aendert. Die Loesung wird in das feinste Grid eingetragen.
+ * Rueckgabewert ist die Anzahl der V-Zyklen auf dem feinsten Gitter. */
+int multigrid_solve(MULTIGRID *mg, double epsilon);
+
+#endif
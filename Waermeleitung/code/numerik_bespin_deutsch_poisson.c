@@ -1,6 +1,7 @@
 #include "numerik_bespin_deutsch_poisson.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 
 GRID *grid_alloc(int m, int n, double h) {
   int i;
@@ -63,7 +64,7 @@ int geometry(GRID **grid, int h_100) {
   *grid = grid_alloc(m, n, h);
   
   /* Ueberpruefen ob die Allokierung erfolgreich war */
-  if (grid == NULL) {
+  if (*grid == NULL) {
     return -1;
   }
   
@@ -155,7 +156,7 @@ int geometry_sym(GRID **grid, int h_100) {
   *grid = grid_alloc(m, n, h);
   
   /* Ueberpruefen ob die Allokierung erfolgreich war */
-  if (grid == NULL) {
+  if (*grid == NULL) {
     return -1;
   }
   
@@ -254,8 +255,8 @@ int setup_gls(GRID *grid, SPARSE_MATRIX **A, VECTOR **b) {
   
   /* Koeffizientenmatrix und Inhomogenitaet des Gleichungssystems.
    * Temporaere Variablen, damit A bzw. b nicht staendig dereferenziert werden
-   * muss. */
-  A_temp = matrix_alloc(eq_count);
+   * muss. Jede Zeile hat hoechstens 4 Nichtdiagonalelemente (Nachbarn). */
+  A_temp = matrix_alloc(eq_count, 4 * eq_count);
   b_temp = vector_alloc(eq_count);
   
   *A = A_temp;
@@ -358,20 +359,48 @@ int setup_gls(GRID *grid, SPARSE_MATRIX **A, VECTOR **b) {
         /* Oben 
          * 2-fach, da dies eine Neumann-Bedingung in y-Richtung ist */
         current = &(grid->elem[i+1][j]);
-        if (handle_neighbor(current, A_temp, b_temp, k, 2));
+        if (handle_neighbor(current, A_temp, b_temp, k, 2) != 0) return -2;
         
         /* Links
          * 2-fach, da dies eine Neumann-Bedingung in x-Richtung ist (Sym.) */
         current = &(grid->elem[i][j-1]);
-        if (handle_neighbor(current, A_temp, b_temp, k, 2));
+        if (handle_neighbor(current, A_temp, b_temp, k, 2) != 0) return -2;
         k++;
       }
     }
   }
   
+  /* Leere Zeilen am Ende der Matrix abschliessen */
+  matrix_finish(A_temp);
+  
   return 0;
 }
 
+void symmetric_gls(GRID *grid, SPARSE_MATRIX *A, VECTOR *b) {
+  int i, k;
+  double scale;
+  GridPoint *current;
+  
+  for (i = 0; i < grid->m * grid->n; i++) {
+    current = &(grid->grid[i]);
+    if (current->type == NEUMANN_Y || current->type == NEUMANN_X) {
+      scale = 0.5;
+    } else if (current->type == NEUMANN_XY) {
+      scale = 0.25;
+    } else {
+      continue;
+    }
+    
+    /* Zeile der Gleichung des Punktes skalieren */
+    A->diag[current->position] *= scale;
+    for (k = A->row[current->position]; k < A->row[current->position+1];
+         k++) {
+      A->value[k] *= scale;
+    }
+    b->elem[current->position] *= scale;
+  }
+}
+
 int handle_neighbor(GridPoint *neighbor, SPARSE_MATRIX *A, VECTOR *b, int k, int factor) {
   /* Wenn der Nachbar ein innerer Punkt oder eine Neumann-Randbedingung ist,
    * ist der Wert fuer u unbekannt und muss in das GLS aufgenommen werden */
@@ -389,6 +418,118 @@ int handle_neighbor(GridPoint *neighbor, SPARSE_MATRIX *A, VECTOR *b, int k, int
   return 0;
 }
 
+STENCIL *setup_stencil(GRID *grid) {
+  int i, j, d, k;
+  double h = grid->h;
+  int m = grid->m, n = grid->n;
+  /* Nachbarn oben, unten, links, rechts (Zeilen- und Spaltenversatz) */
+  int di[4] = {1, -1, 0, 0};
+  int dj[4] = {0, 0, -1, 1};
+  /* Anzahl, mit der die Nachbarn in die Gleichung eingehen (vgl.
+   * "setup_gls") */
+  int times[4];
+  
+  STENCIL *ret;
+  GridPoint *current, *neighbor;
+  
+  /* Position der Unbekannten wie in "setup_gls" */
+  k = 0;
+  for (i = 0; i < m; i++) {
+    for (j = 0; j < n; j++) {
+      current = &(grid->elem[i][j]);
+      if (current->type == REGULAR ||
+          current->type == NEUMANN_Y ||
+          current->type == NEUMANN_X ||
+          current->type == NEUMANN_XY) {
+        current->position = k;
+        k++;
+      }
+    }
+  }
+  grid->eq_count = k;
+  
+  ret = malloc((k > 0 ? k : 1) * sizeof(STENCIL));
+  if (ret == NULL) return NULL;
+  
+  k = 0;
+  for (i = 0; i < m; i++) {
+    for (j = 0; j < n; j++) {
+      current = &(grid->elem[i][j]);
+      
+      /* Neumann-Bedingungen: Der Nachbar auf der anderen Seite des Randes
+       * wird durch den gespiegelten ersetzt (2-fach gezaehlt) */
+      times[0] = times[1] = times[2] = times[3] = 1;
+      if (current->type == NEUMANN_Y) {
+        times[0] = 2;
+        times[1] = 0;
+      } else if (current->type == NEUMANN_X) {
+        times[2] = 2;
+        times[3] = 0;
+      } else if (current->type == NEUMANN_XY) {
+        times[0] = 2;
+        times[1] = 0;
+        times[2] = 2;
+        times[3] = 0;
+      } else if (current->type != REGULAR) {
+        continue;
+      }
+      
+      ret[k].rhs = h * h * current->f;
+      ret[k].index = i * n + j;
+      for (d = 0; d < 4; d++) {
+        ret[k].weight[d] = 0;
+        if (times[d] == 0) continue;
+        
+        neighbor = &(grid->elem[i+di[d]][j+dj[d]]);
+        if (neighbor->type == DIRICHLET) {
+          ret[k].rhs += times[d] * neighbor->u;
+        } else if (neighbor->type != NONE) {
+          ret[k].weight[d] = times[d];
+        }
+      }
+      k++;
+    }
+  }
+  
+  return ret;
+}
+
+void stencil_gauss_seidel(GRID *grid, STENCIL *stencil, double epsilon) {
+  int k, d;
+  int count = grid->eq_count;
+  /* Versatz der Nachbarn oben, unten, links, rechts in grid->grid */
+  int offset[4];
+  double delta, prev, u;
+  GridPoint *point = grid->grid;
+  
+  offset[0] = grid->n;
+  offset[1] = -grid->n;
+  offset[2] = -1;
+  offset[3] = 1;
+  
+  /* Iteration wie "gauss_seidel", nur stehen die Unbekannten direkt im Grid */
+  do {
+    delta = 0;
+    
+    for (k = 0; k < count; k++) {
+      prev = point[stencil[k].index].u;
+      
+      u = stencil[k].rhs;
+      for (d = 0; d < 4; d++) {
+        if (stencil[k].weight[d] != 0) {
+          u += stencil[k].weight[d] * point[stencil[k].index + offset[d]].u;
+        }
+      }
+      u /= 4;
+      point[stencil[k].index].u = u;
+      
+      if (delta < fabs(prev - u)) {
+        delta = fabs(prev - u);
+      }
+    }
+  } while (delta > epsilon);
+}
+
 void enter_solution(GRID *grid, VECTOR *sol) {
   int i, j;
   int m = grid->m, n = grid->n;
@@ -43,6 +43,19 @@ typedef struct {
   GridPoint **elem;
 } GRID;
 
+/* Koeffizienten des 5-Punkte-Sterns fuer einen Punkt mit unbekanntem u
+ * (matrixfreie Loesung direkt auf dem Grid):
+ *   4 u = rhs + Summe weight[d] * u_d
+ * u_d sind die unbekannten Nachbarn oben, unten, links und rechts (d = 0, ...,
+ * 3), weight[d] = 2 fuer an einer Neumann-Bedingung gespiegelte Nachbarn und 0
+ * fuer fehlende Nachbarn und solche mit bekanntem u, deren Beitrag ebenso wie
+ * h^2 f in "rhs" steht. "index" ist die Position des Punktes in grid->grid. */
+typedef struct {
+  double rhs;
+  int index;
+  unsigned char weight[4];
+} STENCIL;
+
 /* Allokierung eines (m x n)-Grids mit Gitterabstand h. Bei Fehlgeschlagener
  * Allokierung wird "NULL" zurueckgegeben. */
 GRID *grid_alloc(int m, int n, double h);
@@ -60,9 +73,27 @@ int geometry_sym(GRID **grid, int h_100);
 /* Erstellt das Gleichungssystem zur Diskretisierung */
 int setup_gls(GRID *grid, SPARSE_MATRIX **A, VECTOR **b);
 
+/* Macht das Gleichungssystem aus "setup_gls" symmetrisch: Die Zeilen der
+ * Punkte mit Neumann-Bedingung enthalten den gespiegelten Nachbarn 2-fach und
+ * werden mit 1/2 (NEUMANN_Y, NEUMANN_X) bzw. 1/4 (NEUMANN_XY) multipliziert.
+ * Die Loesung aendert sich nicht (A ist danach symmetrisch positiv definit). */
+void symmetric_gls(GRID *grid, SPARSE_MATRIX *A, VECTOR *b);
+
 /* Fuegt den Nachbarpunkt gemaess seines Typs in das Gleichungssystem ein */
 int handle_neighbor(GridPoint *neighbor, SPARSE_MATRIX *A, VECTOR *b, int k, int times);
 
+/* Erstellt die Koeffizienten des 5-Punkte-Sterns fuer alle Punkte mit
+ * unbekanntem u (in derselben Reihenfolge wie die Gleichungen von
+ * "setup_gls", Anzahl in grid->eq_count). Bei fehlgeschlagener Allokierung
+ * wird NULL zurueckgegeben. */
+STENCIL *setup_stencil(GRID *grid);
+
+/* Gauss-Seidel-Verfahren ohne Matrix: Die Werte u im Grid werden der Reihe
+ * nach mit den Koeffizienten aus "setup_stencil" aktualisiert, bis sich kein
+ * Wert mehr als "epsilon" aendert. Die u im Grid sind der Startwert (gleiche
+ * Iteration wie "gauss_seidel" mit dem System aus "setup_gls"). */
+void stencil_gauss_seidel(GRID *grid, STENCIL *stencil, double epsilon);
+
 /* Traegt die Loesung in das Grid ein */
 void enter_solution(GRID *grid, VECTOR *sol);
 
@@ -2,7 +2,7 @@
 #include <stdlib.h>
 #include <math.h>
 
-SPARSE_MATRIX *matrix_alloc(int n) {
+SPARSE_MATRIX *matrix_alloc(int n, int capacity) {
   int i;
   SPARSE_MATRIX *ret;
   
@@ -13,65 +13,86 @@ SPARSE_MATRIX *matrix_alloc(int n) {
   }
   
   ret->n = n;
+  ret->capacity = capacity;
+  ret->last = 0;
   
-  /* Allokiert ein Array fuer die verketteten Listen */
-  ret->row = malloc(n * sizeof(NODE*));
-  if (ret->row == NULL) {
-    free(ret);
+  /* Zusammenhaengende Arrays fuer alle Elemente */
+  ret->row = malloc((n + 1) * sizeof(int));
+  ret->column = malloc(capacity * sizeof(int));
+  ret->value = malloc(capacity * sizeof(double));
+  ret->diag = malloc(n * sizeof(double));
+  if (ret->row == NULL || ret->column == NULL || ret->value == NULL ||
+      ret->diag == NULL) {
+    matrix_free(ret);
     return NULL;
   }
   
-  /* Initialisiere die Listen als "leer" */
+  /* Initialisiere alle Zeilen als "leer" */
   for (i = 0; i < n; i++) {
-    ret->row[i] = NULL;
+    ret->row[i] = 0;
+    ret->diag[i] = 0;
   }
+  ret->row[n] = 0;
   
   return ret;
 }
 
 double matrix_get(SPARSE_MATRIX *M, int m, int n) {
-  /* Liste der n-ten Zeile */
-  NODE *current = M->row[m];
-  /* Geht durch die Liste und sucht nach dem Spaltenelement */
-  while (current != NULL) {
-    if (current->column == n) return current->value;
-    current = current->next;
-  }
-  /* Wurde das Element nicht in der Liste gefunden war es null */
+  int k;
+  
+  if (m == n) return M->diag[m];
+  
+  /* Sucht in der m-ten Zeile nach dem Spaltenelement */
+  for (k = M->row[m]; k < M->row[m+1]; k++) {
+    if (M->column[k] == n) return M->value[k];
+  }
+  /* Wurde das Element nicht in der Zeile gefunden war es null */
   return 0;
 }
 
 int matrix_set(SPARSE_MATRIX *M, int m, int n, double value) {
-  /* neues Listenelement allokieren */
-  NODE *new = malloc(sizeof(NODE*));
+  int end;
+  
+  if (m == n) {
+    M->diag[m] = value;
+    return 0;
+  }
+  
+  if (m < M->last) return -1;
   
-  if (NULL == new) return -1;
+  /* Die Zeilen zwischen der zuletzt gefuellten und m bleiben leer */
+  end = M->row[M->last+1];
+  for (; M->last < m; M->last++) {
+    M->row[M->last+2] = end;
+  }
   
-  /* fuegt neues Element an den Anfang der Liste ein */
-  new->next = M->row[m];
-  new->column = n;
-  new->value = value;
+  if (end == M->capacity) return -1;
   
-  M->row[m] = new;
+  /* haengt das Element an die Zeile an */
+  M->column[end] = n;
+  M->value[end] = value;
+  M->row[m+1] = end + 1;
   
   return 0;
 }
 
-void matrix_free(SPARSE_MATRIX *M) {
-  int i;
-  NODE *current, *temp;
+void matrix_finish(SPARSE_MATRIX *M) {
+  int k;
   
-  /* Zeilen der Matrix */
-  for (i = 0; i < M->n; i++) {
-    current = M->row[i];
-    /* Geht durch die Liste und gibt jeden Knoten frei */
-    while (current != NULL) {
-      temp = current->next;
-      free(current);
-      current = temp;
-    }
+  if (M->n == 0) return;
+  
+  /* Bisher ist "row" nur bis zur Zeile last + 1 gesetzt */
+  for (k = M->last + 2; k <= M->n; k++) {
+    M->row[k] = M->row[M->last+1];
   }
+  M->last = M->n - 1;
+}
+
+void matrix_free(SPARSE_MATRIX *M) {
   free(M->row);
+  free(M->column);
+  free(M->value);
+  free(M->diag);
   free(M);
 }
 
@@ -82,13 +103,10 @@ int gauss_seidel(SPARSE_MATRIX *M, VECTOR *b, VECTOR *sol, double epsilon) {
   /* Wert des Loesungselements bei der letzten Iteration (zur Berechnung von
    * "delta") */
   double prev;
-  /* Wert des Diagonalelements der jeweiligen Zeile */
-  double diag_elem = 0;
   /* Dimension der Matrix */
   int n = M->n;
   
-  NODE *current;
-  int k;
+  int k, l;
   
   /* Dimensionskonflikt zwischen Matrix und den Vektoren */
   if (n != b->n || n != sol->n) return -1;
@@ -100,31 +118,22 @@ int gauss_seidel(SPARSE_MATRIX *M, VECTOR *b, VECTOR *sol, double epsilon) {
     
     /* Iteration der k-ten Variable des GLS */
     for (k = 0; k < n; k++) {
-      current = M->row[k];
       prev = sol->elem[k];
       
       /* Es wird vermieden temporaere Variablen anzulegen und stattdessen direkt
        * im Loesungsvektor gerechnet */
       sol->elem[k] = b->elem[k];
       
-      /* Geht durch die nicht verschwindenden Elemente in der k-ten Zeile der 
-       * Matrix. Dabei wird das Diagonalelement der Zeile in "diag_elem" ge-
-       * speichert und alle anderen werden gemaess dem Gauss-Seidel-Verfahren
-       * verarbeitet. */
-      while (current != NULL) {
-        if (current->column == k) {
-          diag_elem = current->value;
-        } else {
-          /* Hier wird zum Teil schon mit Variablen im naechsten Iterations-
-           * schritt gerechnet (sol->elem[l] mit l < k), was zu einer
-           * schnelleren Konvergenz fuehrt */
-          sol->elem[k] -= current->value * sol->elem[current->column];
-        }
-        current = current->next;
+      /* Geht durch die Nichtdiagonalelemente in der k-ten Zeile der Matrix
+       * (hintereinander im Speicher). Hier wird zum Teil schon mit Variablen
+       * im naechsten Iterationsschritt gerechnet (sol->elem[l] mit l < k),
+       * was zu einer schnelleren Konvergenz fuehrt. */
+      for (l = M->row[k]; l < M->row[k+1]; l++) {
+        sol->elem[k] -= M->value[l] * sol->elem[M->column[l]];
       }
       
-      /* es wird davon ausgegangen, dass "diag_elem" ungleich null */
-      sol->elem[k] /= diag_elem;
+      /* es wird davon ausgegangen, dass das Diagonalelement ungleich null */
+      sol->elem[k] /= M->diag[k];
       
       /* Maximum der Abweichung */
       if (delta < fabs(prev - sol->elem[k])) {
@@ -136,6 +145,507 @@ int gauss_seidel(SPARSE_MATRIX *M, VECTOR *b, VECTOR *sol, double epsilon) {
   return 0;
 }
 
+COLORING *matrix_coloring(SPARSE_MATRIX *M) {
+  int i, k, c, max;
+  int n = M->n;
+  /* Farbe jeder Zeile (-1: noch nicht gefaerbt) */
+  int *color;
+  /* used[c] == i: Farbe c kommt in Zeile i bereits vor */
+  int *used;
+  COLORING *ret;
+  
+  /* Hoechstens (maximale Anzahl der Nichtdiagonalelemente + 1) Farben */
+  max = 1;
+  for (i = 0; i < n; i++) {
+    if (M->row[i+1] - M->row[i] + 1 > max) max = M->row[i+1] - M->row[i] + 1;
+  }
+  
+  ret = malloc(sizeof(COLORING));
+  color = malloc((n > 0 ? n : 1) * sizeof(int));
+  used = malloc(max * sizeof(int));
+  if (ret != NULL) {
+    ret->start = malloc((max + 1) * sizeof(int));
+    ret->order = malloc((n > 0 ? n : 1) * sizeof(int));
+  }
+  if (ret == NULL || color == NULL || used == NULL || ret->start == NULL ||
+      ret->order == NULL) {
+    if (ret != NULL) coloring_free(ret);
+    free(color);
+    free(used);
+    return NULL;
+  }
+  
+  for (c = 0; c < max; c++) {
+    used[c] = -1;
+  }
+  for (i = 0; i < n; i++) {
+    color[i] = -1;
+  }
+  
+  ret->colors = 0;
+  for (i = 0; i < n; i++) {
+    for (k = M->row[i]; k < M->row[i+1]; k++) {
+      if (color[M->column[k]] >= 0) used[color[M->column[k]]] = i;
+    }
+    for (c = 0; used[c] == i; c++);
+    color[i] = c;
+    if (c + 1 > ret->colors) ret->colors = c + 1;
+  }
+  
+  /* Zeilen nach Farben sortieren (innerhalb einer Farbe aufsteigend) */
+  for (c = 0; c <= ret->colors; c++) {
+    ret->start[c] = 0;
+  }
+  for (i = 0; i < n; i++) {
+    ret->start[color[i]+1]++;
+  }
+  for (c = 0; c < ret->colors; c++) {
+    ret->start[c+1] += ret->start[c];
+    used[c] = ret->start[c];
+  }
+  for (i = 0; i < n; i++) {
+    ret->order[used[color[i]]++] = i;
+  }
+  
+  free(color);
+  free(used);
+  
+  return ret;
+}
+
+void coloring_free(COLORING *C) {
+  free(C->start);
+  free(C->order);
+  free(C);
+}
+
+/* Ein Schritt des SOR-Verfahrens in der Reihenfolge der Faerbung.
+ * Rueckgabewert ist die maximale Aenderung, in "norm" wird die Summe der
+ * Quadrate der Aenderungen gespeichert. */
+static double multicolor_sweep(SPARSE_MATRIX *M, COLORING *C, double *b,
+                               double *x, double omega, double *norm) {
+  int c, k, l, i;
+  double v, delta = 0, sum = 0;
+  
+  for (c = 0; c < C->colors; c++) {
+    /* Die Zeilen einer Farbe haengen nur von Elementen anderer Farben ab */
+    #pragma omp parallel for private(i, l, v) reduction(max:delta) \
+      reduction(+:sum) schedule(static) \
+      if (C->start[c+1] - C->start[c] >= SOR_PARALLEL_MIN)
+    for (k = C->start[c]; k < C->start[c+1]; k++) {
+      i = C->order[k];
+      v = b[i];
+      for (l = M->row[i]; l < M->row[i+1]; l++) {
+        v -= M->value[l] * x[M->column[l]];
+      }
+      /* Aenderung des Gauss-Seidel-Schritts mit omega gewichtet */
+      v = omega * (v / M->diag[i] - x[i]);
+      x[i] += v;
+      
+      if (delta < fabs(v)) delta = fabs(v);
+      sum += v * v;
+    }
+  }
+  
+  *norm = sum;
+  return delta;
+}
+
+int multicolor_sor(SPARSE_MATRIX *M, COLORING *C, VECTOR *b, VECTOR *sol,
+                   double omega, double epsilon) {
+  int sweeps = 0;
+  double norm;
+  
+  /* Dimensionskonflikt zwischen Matrix und den Vektoren */
+  if (M->n != b->n || M->n != sol->n) return -1;
+  
+  do {
+    sweeps++;
+  } while (multicolor_sweep(M, C, b->elem, sol->elem, omega, &norm) >
+           epsilon);
+  
+  return sweeps;
+}
+
+/* Anzahl der Eigenwerte der symmetrischen Tridiagonalmatrix mit der
+ * Diagonalen "alpha" und der Nebendiagonalen "beta" (Dimension m), die
+ * kleiner als x sind (Vorzeichenwechsel der Sturmschen Kette) */
+static int sturm_count(double *alpha, double *beta, int m, double x) {
+  int j, count = 0;
+  double d = 1;
+  
+  for (j = 0; j < m; j++) {
+    d = alpha[j] - x - (j > 0 ? beta[j-1] * beta[j-1] / d : 0);
+    if (d == 0) d = -1E-300;
+    if (d < 0) count++;
+  }
+  
+  return count;
+}
+
+/* k-kleinster Eigenwert (k = 0, ..., m - 1) der Tridiagonalmatrix durch
+ * Bisektion im Intervall [lo, hi] */
+static double tridiag_eigenvalue(double *alpha, double *beta, int m, int k,
+                                 double lo, double hi) {
+  double mid = (lo + hi) / 2;
+  
+  while (mid > lo && mid < hi) {
+    if (sturm_count(alpha, beta, m, mid) > k) {
+      hi = mid;
+    } else {
+      lo = mid;
+    }
+    mid = (lo + hi) / 2;
+  }
+  
+  return mid;
+}
+
+double sor_omega(SPARSE_MATRIX *M, int *steps) {
+  int i, j, l;
+  int n = M->n;
+  double s, lo, hi, rho = 0, rho_prev;
+  /* Lanczos-Vektoren q_(j-1), q_j und neue Richtung w (in "block") */
+  double *block, *q_prev, *q, *w, *tmp;
+  /* Tridiagonalmatrix T (Diagonale, Nebendiagonale) */
+  double *alpha, *beta;
+  
+  *steps = 0;
+  if (n == 0) return 1;
+  
+  block = malloc(3 * n * sizeof(double));
+  alpha = malloc(2 * SOR_OMEGA_STEPS * sizeof(double));
+  if (block == NULL || alpha == NULL) {
+    free(block);
+    free(alpha);
+    return 1;
+  }
+  q_prev = block;
+  q = q_prev + n;
+  w = q + n;
+  beta = alpha + SOR_OMEGA_STEPS;
+  
+  /* Startvektor (1, ..., 1) normiert im Skalarprodukt (x, y)_D = x^T D y */
+  s = 0;
+  for (i = 0; i < n; i++) {
+    s += M->diag[i];
+  }
+  for (i = 0; i < n; i++) {
+    q_prev[i] = 0;
+    q[i] = 1 / sqrt(s);
+  }
+  
+  /* Lanczos-Verfahren fuer D^-1 M (selbstadjungiert bzgl. (.,.)_D, da M
+   * symmetrisch): Die Eigenwerte von T naehern die extremen Eigenwerte von
+   * D^-1 M und damit den Spektralradius des Jacobi-Verfahrens
+   * rho = max |1 - lambda| schnell an */
+  for (j = 0; j < SOR_OMEGA_STEPS; j++) {
+    for (i = 0; i < n; i++) {
+      s = M->diag[i] * q[i];
+      for (l = M->row[i]; l < M->row[i+1]; l++) {
+        s += M->value[l] * q[M->column[l]];
+      }
+      w[i] = s / M->diag[i] - (j > 0 ? beta[j-1] * q_prev[i] : 0);
+    }
+    
+    s = 0;
+    for (i = 0; i < n; i++) {
+      s += w[i] * M->diag[i] * q[i];
+    }
+    alpha[j] = s;
+    
+    s = 0;
+    for (i = 0; i < n; i++) {
+      w[i] -= alpha[j] * q[i];
+      s += w[i] * M->diag[i] * w[i];
+    }
+    beta[j] = sqrt(s);
+    (*steps)++;
+    
+    /* Extreme Eigenwerte von T alle 10 Schritte (Intervall nach Gerschgorin) */
+    if ((j + 1) % 10 == 0 || j + 1 == SOR_OMEGA_STEPS || beta[j] == 0) {
+      lo = alpha[0];
+      hi = alpha[0];
+      for (l = 0; l <= j; l++) {
+        s = (l > 0 ? fabs(beta[l-1]) : 0) + (l < j ? fabs(beta[l]) : 0);
+        if (alpha[l] - s < lo) lo = alpha[l] - s;
+        if (alpha[l] + s > hi) hi = alpha[l] + s;
+      }
+      rho_prev = rho;
+      rho = fabs(1 - tridiag_eigenvalue(alpha, beta, j + 1, 0, lo, hi));
+      s = fabs(1 - tridiag_eigenvalue(alpha, beta, j + 1, j, lo, hi));
+      if (s > rho) rho = s;
+      
+      /* omega haengt von 1 - rho ab: relative Aenderung */
+      if (fabs(rho - rho_prev) <= SOR_OMEGA_TOL * (1 - rho)) break;
+    }
+    
+    /* Invarianter Unterraum: Eigenwerte von T sind exakt */
+    if (beta[j] == 0) break;
+    
+    for (i = 0; i < n; i++) {
+      w[i] /= beta[j];
+    }
+    tmp = q_prev;
+    q_prev = q;
+    q = w;
+    w = tmp;
+  }
+  
+  free(block);
+  free(alpha);
+  
+  /* Optimaler Parameter fuer konsistent geordnete Matrizen (Young) */
+  if (rho >= 1) return 1;
+  return 2 / (1 + sqrt(1 - rho * rho));
+}
+
+/* Unvollstaendige Cholesky-Zerlegung von M: Das strikte untere Dreieck von L
+ * (Spalten aufsteigend sortiert) steht in "value", die Diagonale in "diag".
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -2: Allokierung fehlgeschlagen
+ * -4: nicht positives Diagonalelement */
+static int ic_factor(SPARSE_MATRIX *M, SPARSE_MATRIX **L) {
+  int i, j, k, p, q, count;
+  int n = M->n;
+  double s;
+  /* Position des Elements L[i][j] der aktuellen Zeile i in "value" oder -1 */
+  int *mark;
+  SPARSE_MATRIX *ret;
+  
+  count = 0;
+  for (i = 0; i < n; i++) {
+    for (k = M->row[i]; k < M->row[i+1]; k++) {
+      if (M->column[k] < i) count++;
+    }
+  }
+  
+  ret = matrix_alloc(n, count > 0 ? count : 1);
+  mark = malloc(n * sizeof(int));
+  if (ret == NULL || mark == NULL) {
+    if (ret != NULL) matrix_free(ret);
+    free(mark);
+    return -2;
+  }
+  
+  /* Besetzungsstruktur: unteres Dreieck von M, je Zeile durch Einfuegen
+   * sortiert */
+  ret->row[0] = 0;
+  for (i = 0; i < n; i++) {
+    mark[i] = -1;
+    p = ret->row[i];
+    for (k = M->row[i]; k < M->row[i+1]; k++) {
+      if (M->column[k] >= i) continue;
+      for (q = p; q > ret->row[i] && ret->column[q-1] > M->column[k]; q--) {
+        ret->column[q] = ret->column[q-1];
+        ret->value[q] = ret->value[q-1];
+      }
+      ret->column[q] = M->column[k];
+      ret->value[q] = M->value[k];
+      p++;
+    }
+    ret->row[i+1] = p;
+  }
+  ret->last = n - 1;
+  
+  /* L[i][j] = (M[i][j] - Summe_(k < j) L[i][k] L[j][k]) / L[j][j] und
+   * L[i][i] = sqrt(M[i][i] - Summe_(k < i) L[i][k]^2), wobei nur Elemente der
+   * Besetzungsstruktur beruecksichtigt werden */
+  for (i = 0; i < n; i++) {
+    for (p = ret->row[i]; p < ret->row[i+1]; p++) {
+      mark[ret->column[p]] = p;
+    }
+    
+    s = M->diag[i];
+    for (p = ret->row[i]; p < ret->row[i+1]; p++) {
+      j = ret->column[p];
+      for (q = ret->row[j]; q < ret->row[j+1]; q++) {
+        if (mark[ret->column[q]] >= 0) {
+          ret->value[p] -= ret->value[mark[ret->column[q]]] * ret->value[q];
+        }
+      }
+      ret->value[p] /= ret->diag[j];
+      s -= ret->value[p] * ret->value[p];
+    }
+    
+    if (!(s > 0)) {
+      matrix_free(ret);
+      free(mark);
+      return -4;
+    }
+    ret->diag[i] = sqrt(s);
+    
+    for (p = ret->row[i]; p < ret->row[i+1]; p++) {
+      mark[ret->column[p]] = -1;
+    }
+  }
+  
+  free(mark);
+  *L = ret;
+  
+  return 0;
+}
+
+/* Anwenden des Vorkonditionierers: z = P^-1 r */
+static void precond_apply(SPARSE_MATRIX *M, SPARSE_MATRIX *L,
+                          PRECONDITIONER precond, double *r, double *z) {
+  int i, k;
+  int n = M->n;
+  double s;
+  
+  if (precond == PCG_JACOBI) {
+    for (i = 0; i < n; i++) {
+      z[i] = r[i] / M->diag[i];
+    }
+  } else if (precond == PCG_SSOR) {
+    /* Vorwaerts: (D + L) y = r */
+    for (i = 0; i < n; i++) {
+      s = r[i];
+      for (k = M->row[i]; k < M->row[i+1]; k++) {
+        if (M->column[k] < i) s -= M->value[k] * z[M->column[k]];
+      }
+      z[i] = s / M->diag[i];
+    }
+    /* Rueckwaerts: (D + L^T) z = D y */
+    for (i = n - 1; i >= 0; i--) {
+      s = M->diag[i] * z[i];
+      for (k = M->row[i]; k < M->row[i+1]; k++) {
+        if (M->column[k] > i) s -= M->value[k] * z[M->column[k]];
+      }
+      z[i] = s / M->diag[i];
+    }
+  } else {
+    /* Vorwaerts: L y = r */
+    for (i = 0; i < n; i++) {
+      s = r[i];
+      for (k = L->row[i]; k < L->row[i+1]; k++) {
+        s -= L->value[k] * z[L->column[k]];
+      }
+      z[i] = s / L->diag[i];
+    }
+    /* Rueckwaerts: L^T z = y (spaltenweise, da L zeilenweise gespeichert) */
+    for (i = n - 1; i >= 0; i--) {
+      z[i] /= L->diag[i];
+      for (k = L->row[i]; k < L->row[i+1]; k++) {
+        z[L->column[k]] -= L->value[k] * z[i];
+      }
+    }
+  }
+}
+
+/* q = M p */
+static void matrix_mul(SPARSE_MATRIX *M, double *p, double *q) {
+  int i, k;
+  
+  for (i = 0; i < M->n; i++) {
+    q[i] = M->diag[i] * p[i];
+    for (k = M->row[i]; k < M->row[i+1]; k++) {
+      q[i] += M->value[k] * p[M->column[k]];
+    }
+  }
+}
+
+int pcg(SPARSE_MATRIX *M, VECTOR *b, VECTOR *sol, double epsilon,
+        PRECONDITIONER precond, int max_iter, double *history) {
+  int i, iter;
+  int n = M->n;
+  double alpha, beta, rz, rz_prev, pq, norm_b, norm_r;
+  /* Residuum, vorkonditioniertes Residuum, Suchrichtung und M p */
+  double *r, *z, *p, *q;
+  double *x = sol->elem;
+  SPARSE_MATRIX *L = NULL;
+  
+  /* Dimensionskonflikt zwischen Matrix und den Vektoren */
+  if (n != b->n || n != sol->n) return -1;
+  
+  if (precond == PCG_JACOBI) {
+    for (i = 0; i < n; i++) {
+      if (!(M->diag[i] > 0)) return -4;
+    }
+  } else if (precond == PCG_IC) {
+    i = ic_factor(M, &L);
+    if (i != 0) return i;
+  }
+  
+  r = malloc(4 * (n > 0 ? n : 1) * sizeof(double));
+  if (r == NULL) {
+    if (L != NULL) matrix_free(L);
+    return -2;
+  }
+  z = r + n;
+  p = z + n;
+  q = p + n;
+  
+  /* Startwerte r = b - M x, p = z = P^-1 r */
+  matrix_mul(M, x, q);
+  norm_b = 0;
+  for (i = 0; i < n; i++) {
+    r[i] = b->elem[i] - q[i];
+    norm_b += b->elem[i] * b->elem[i];
+  }
+  norm_b = sqrt(norm_b);
+  if (norm_b == 0) norm_b = 1;
+  
+  precond_apply(M, L, precond, r, z);
+  rz = 0;
+  for (i = 0; i < n; i++) {
+    p[i] = z[i];
+    rz += r[i] * z[i];
+  }
+  
+  iter = 0;
+  while (1) {
+    norm_r = 0;
+    for (i = 0; i < n; i++) {
+      norm_r += r[i] * r[i];
+    }
+    norm_r = sqrt(norm_r) / norm_b;
+    if (history != NULL) history[iter] = norm_r;
+    
+    if (norm_r <= epsilon) break;
+    if (iter == max_iter) {
+      iter = -3;
+      break;
+    }
+    
+    /* Schrittweite entlang p */
+    matrix_mul(M, p, q);
+    pq = 0;
+    for (i = 0; i < n; i++) {
+      pq += p[i] * q[i];
+    }
+    if (!(pq > 0)) {
+      iter = -4;
+      break;
+    }
+    alpha = rz / pq;
+    
+    for (i = 0; i < n; i++) {
+      x[i] += alpha * p[i];
+      r[i] -= alpha * q[i];
+    }
+    
+    /* Neue Suchrichtung p = z + beta p (M-konjugiert zu den bisherigen) */
+    precond_apply(M, L, precond, r, z);
+    rz_prev = rz;
+    rz = 0;
+    for (i = 0; i < n; i++) {
+      rz += r[i] * z[i];
+    }
+    beta = rz / rz_prev;
+    for (i = 0; i < n; i++) {
+      p[i] = z[i] + beta * p[i];
+    }
+    
+    iter++;
+  }
+  
+  free(r);
+  if (L != NULL) matrix_free(L);
+  
+  return iter;
+}
 
 VECTOR *vector_alloc(int n) {
   VECTOR *ret;
@@ -1,27 +1,48 @@
 #ifndef _SPARSE_MATRIX_H
 #define _SPARSE_MATRIX_H
 
-/* Knoten einer einfach verketteten Liste. */
-typedef struct NODE {
-  /* Pointer auf den naechsten Knoten */
-  struct NODE *next;
-  /* Datenfelder */
-  int column;
-  double value;
-} NODE;
-
-/* Duenne (n x n)-Matrix:
- * Jede Zeile der Matrix wird als verkettete Liste der Nicht-Null-Elemente dar-
- * gestellt. Da jede Zeile der Matrix mindestens ein Element hat, wird beim
- * allokieren der Matrix sofort ein n-dimenensionales Array von verketteten
- * Listen (NODE **row) angelegt. */
+/* Duenne (n x n)-Matrix im CSR-Format (compressed sparse row):
+ * Die Nicht-Null-Elemente neben der Hauptdiagonalen stehen zeilenweise
+ * hintereinander in den Arrays "value" und "column", die Diagonalelemente
+ * getrennt in "diag". Die Arrays werden beim Allokieren der Matrix mit einer
+ * festen Kapazitaet angelegt; die Zeilen werden der Reihe nach gefuellt (vgl.
+ * "matrix_set") und mit "matrix_finish" abgeschlossen. */
 typedef struct {
   /* Dimension der Matrix */
   int n;
-  /* Verkettete Listen der Zeilen der Matrix */
-  NODE **row;
+  /* Anzahl der Plaetze fuer Nichtdiagonalelemente */
+  int capacity;
+  /* Zuletzt gefuellte Zeile */
+  int last;
+  /* Die Elemente der Zeile k stehen an den Positionen row[k], ...,
+   * row[k+1] - 1 (n + 1 Eintraege) */
+  int *row;
+  /* Spaltenindizes und Werte der Nichtdiagonalelemente */
+  int *column;
+  double *value;
+  /* Diagonalelemente */
+  double *diag;
 } SPARSE_MATRIX;
 
+/* Faerbung der Zeilen einer duennen Matrix (vgl. "matrix_coloring"): Zeilen
+ * gleicher Farbe haengen nicht voneinander ab und koennen im Gauss-Seidel-
+ * Verfahren gleichzeitig aktualisiert werden. Die Zeilen der Farbe c sind
+ * order[start[c]], ..., order[start[c+1] - 1] (aufsteigend). */
+typedef struct {
+  int colors;
+  int *start;
+  int *order;
+} COLORING;
+
+/* Anzahl der Zeilen einer Farbe, ab der diese parallel aktualisiert werden
+ * (mit OpenMP) */
+#define SOR_PARALLEL_MIN 10000
+
+/* Abbruch der Schaetzung von omega in "sor_omega": relative Aenderung von
+ * 1 - rho bzw. maximale Anzahl der Lanczos-Schritte */
+#define SOR_OMEGA_TOL 1E-3
+#define SOR_OMEGA_STEPS 1000
+
 /* Vector-Struct fuer n-dimensionale Vektoren
  * elem: Speicherblock fuer Vektorelemente
  *       v->elem[i] fuer das i-te Element */
@@ -31,21 +52,30 @@ typedef struct {
 } VECTOR;
 
 
-/* Allokiert eine duenne (n x n)-Matrix
+/* Allokiert eine duenne (n x n)-Matrix mit Platz fuer "capacity" Nicht-
+ * diagonalelemente
  * Rueckgabewert:
  * NULL: Allokierung fehlgeschlagen */
-SPARSE_MATRIX *matrix_alloc(int n);
+SPARSE_MATRIX *matrix_alloc(int n, int capacity);
 
 /* Gibt das Element M[m][n] aus */
 double matrix_get(SPARSE_MATRIX *M, int m, int n);
 
 /* Setzt das Element M[m][n] auf den Wert "value"
  * Sollte nicht zum mehrfachen Setzen desselben Elements verwendet werden.
+ * Nichtdiagonalelemente werden an die Zeile m angehaengt, daher muessen die
+ * Zeilen der Reihe nach gefuellt werden (m nicht kleiner als beim vorherigen
+ * Aufruf); Diagonalelemente koennen jederzeit gesetzt werden.
  * Rueckgabewert:
  * 0: Erfolg
- * -1: Allokierung fehlgeschlagen */
+ * -1: Kapazitaet erschoepft oder Zeile bereits abgeschlossen */
 int matrix_set(SPARSE_MATRIX *M, int m, int n, double value);
 
+/* Schliesst das Fuellen der Matrix ab: Die Zeilen nach der zuletzt mit
+ * "matrix_set" gefuellten bleiben leer, danach ist "row" fuer alle n + 1
+ * Eintraege gueltig (row[n] ist die Anzahl der Nichtdiagonalelemente). */
+void matrix_finish(SPARSE_MATRIX *M);
+
 /* Gibt den Speicher der gesamten Matrix wieder frei */
 void matrix_free(SPARSE_MATRIX *M);
 
@@ -57,6 +87,67 @@ void matrix_free(SPARSE_MATRIX *M);
  * -1: Dimensionskonflikt */
 int gauss_seidel(SPARSE_MATRIX *M, VECTOR *b, VECTOR *sol, double epsilon);
 
+/* Vorkonditionierer fuer "pcg":
+ * PCG_JACOBI: Diagonale von M
+ * PCG_SSOR: symmetrisches Gauss-Seidel-Verfahren (SSOR mit omega = 1),
+ *           (D + L) D^-1 (D + L^T) mit dem unteren Dreieck L von M
+ * PCG_IC: unvollstaendige Cholesky-Zerlegung L L^T ohne Auffuellung (IC(0)),
+ *         L hat dieselbe Besetzungsstruktur wie das untere Dreieck von M */
+typedef enum {
+  PCG_JACOBI,
+  PCG_SSOR,
+  PCG_IC
+} PRECONDITIONER;
+
+/* Loest das Gleichungssystem M x = b fuer symmetrisch positiv definites M mit
+ * dem vorkonditionierten cg-Verfahren. Der Startvektor wird mit "sol"
+ * uebergeben. Abgebrochen wird, sobald die euklidische Norm des Residuums
+ * r = b - M x hoechstens "epsilon" |b| ist oder nach "max_iter" Schritten.
+ * Ist "history" nicht NULL, wird darin |r| / |b| nach jedem Schritt
+ * gespeichert (history[0] fuer den Startvektor, Platz fuer max_iter + 1
+ * Eintraege).
+ * Rueckgabewert:
+ * >= 0: Anzahl der Iterationen
+ * -1: Dimensionskonflikt
+ * -2: Allokierung fehlgeschlagen
+ * -3: keine Konvergenz nach "max_iter" Schritten
+ * -4: M bzw. Vorkonditionierer nicht positiv definit */
+int pcg(SPARSE_MATRIX *M, VECTOR *b, VECTOR *sol, double epsilon,
+        PRECONDITIONER precond, int max_iter, double *history);
+
+/* Faerbt die Zeilen der Matrix M gierig der Reihe nach: Jede Zeile erhaelt
+ * die kleinste Farbe, die keine bereits gefaerbte Spalte der Zeile hat. Die
+ * Besetzungsstruktur von M muss symmetrisch sein (M[m][n] != 0 genau dann
+ * wenn M[n][m] != 0). Fuer den 5-Punkte-Stern entsteht die Schachbrett-
+ * faerbung (rot-schwarz, 2 Farben).
+ * Rueckgabewert:
+ * NULL: Allokierung fehlgeschlagen */
+COLORING *matrix_coloring(SPARSE_MATRIX *M);
+
+/* Gibt den Speicher der Faerbung wieder frei */
+void coloring_free(COLORING *C);
+
+/* Loest das Gleichungssystem M x = b mit dem SOR-Verfahren (Relaxations-
+ * parameter "omega", 0 < omega < 2; omega = 1 ist das Gauss-Seidel-Verfahren)
+ * in der Reihenfolge der Faerbung "C". Die Zeilen einer Farbe werden parallel
+ * aktualisiert. Der Startvektor wird mit "sol" uebergeben, abgebrochen wird,
+ * wenn sich in einem Schritt kein Element mehr als "epsilon" aendert.
+ * Rueckgabewert:
+ * >= 0: Anzahl der Schritte
+ * -1: Dimensionskonflikt */
+int multicolor_sor(SPARSE_MATRIX *M, COLORING *C, VECTOR *b, VECTOR *sol,
+                   double omega, double epsilon);
+
+/* Schaetzt den optimalen Relaxationsparameter
+ *   omega = 2 / (1 + sqrt(1 - rho^2))
+ * fuer "multicolor_sor" (Young; exakt fuer konsistent geordnete Matrizen wie
+ * bei der rot-schwarz-Faerbung des 5-Punkte-Sterns). rho ist der Spektral-
+ * radius des Jacobi-Verfahrens, der mit dem Lanczos-Verfahren fuer D^-1 M
+ * bestimmt wird; M muss dazu symmetrisch sein (vgl. "symmetric_gls"). Die
+ * Anzahl der Lanczos-Schritte wird in "steps" gespeichert.
+ * Rueckgabewert ist omega (1 bei fehlgeschlagener Allokierung). */
+double sor_omega(SPARSE_MATRIX *M, int *steps);
+
 /* Allokiert einen n-dimensionalen Vektor */
 VECTOR *vector_alloc(int n);
 
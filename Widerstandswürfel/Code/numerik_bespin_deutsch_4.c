@@ -1,16 +1,47 @@
-﻿/* gcc -o numerik_4 -O2 numerik_bespin_deutsch_linalg.c numerik_bespin_deutsch_gls.c numerik_bespin_deutsch_4.c -lm */
+﻿/* gcc -o numerik_4 -O2 numerik_bespin_deutsch_linalg.c numerik_bespin_deutsch_gls.c numerik_bespin_deutsch_sparse.c numerik_bespin_deutsch_netlist.c numerik_bespin_deutsch_4.c -lm */
+/* Mit den SIMD-Befehlen des Prozessors und mehreren Threads fuer grosse
+ * Gleichungssysteme (blockweise LU-Zerlegung, optional):
+ * gcc -o numerik_4 -O3 -march=native -fopenmp numerik_bespin_deutsch_linalg.c numerik_bespin_deutsch_gls.c numerik_bespin_deutsch_sparse.c numerik_bespin_deutsch_netlist.c numerik_bespin_deutsch_4.c -lm */
 /* Christian Bespin, Christopher Deutsch */
 
 /* Programmaufruf: Erklaerung bei Aufruf des Programms ohne Argumente */
 
 #include "numerik_bespin_deutsch_linalg.h"
 #include "numerik_bespin_deutsch_gls.h"
+#include "numerik_bespin_deutsch_netlist.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
 
-/* Erstellt eine Tabelle vo */
+/* Erstellt eine Tabelle der Ersatzwiderstaende fuer die Werte start, start +
+ * step, ..., stop des Widerstands "resistor": Die Matrix wird nur einmal
+ * zerlegt, die Aenderung des Widerstands als Aenderung niedrigen Rangs mit der
+ * Sherman-Morrison-Woodbury-Formel beruecksichtigt (vgl. "low_rank"). */
 void resistance_table(void (*GLS)(MATRIX*, VECTOR*, double*), int size,
                       int resistor, double start, double stop, double step);
 
+/* Wie "resistance_table", loest aber fuer jeden Wert das vollstaendige
+ * Gleichungssystem */
+void resistance_table_direct(void (*GLS)(MATRIX*, VECTOR*, double*), int size,
+                             int resistor, double start, double stop,
+                             double step);
+
+/* Gibt die Tabelle mit der Woodbury-Formel fuer A + (R - start) U V^T aus:
+ * Y enthaelt A^-1 b und die "rank" Spalten von A^-1 U (je size Werte) fuer die
+ * Matrix A zum Startwert, V die Spalten von V (vgl. "low_rank") */
+void woodbury_table(double *Y, double *V, int size, int rank, int resistor,
+                    double start, double stop, double step);
+
+/* Zerlegt die (n x n)-Matrix D durch Elimination mit vollstaendiger
+ * Pivotisierung in D = U V^T mit dem kleinstmoeglichen Rang r. Die r Spalten
+ * von U und V werden hintereinander (je n Werte) gespeichert, D wird dabei
+ * ueberschrieben. Rueckgabewert ist der Rang r. */
+int low_rank(MATRIX *D, double *U, double *V);
+
+/* Liest die Netzliste "filename" (Format in numerik_bespin_deutsch_netlist.h)
+ * und gibt den Ersatzwiderstand zwischen "source" und "sink" aus */
+int netlist_table(char *filename);
+
 int main(int argc, char **argv) {
   void (*GLS[5])(MATRIX *, VECTOR *, double *);
   char *label[5];
@@ -36,10 +67,16 @@ int main(int argc, char **argv) {
   GLS[4] = octahedron_edge;
   label[4] = "Kante eines Oktaeders";
   
+  /* Beliebiges Netzwerk aus einer Netzliste */
+  if ( argc == 2 ) {
+    return netlist_table(argv[1]);
+  }
+  
   /* Ueberprueft die Anzahl der Programmargumente und erklaert die Benutzung */
   if ( argc != 6 ) {
     printf("Benutzung:\n");
-    printf("%s geometry resistor start stop step\n\n", argv[0]);
+    printf("%s geometry resistor start stop step\n", argv[0]);
+    printf("%s netlist\n\n", argv[0]);
     printf("geometry: Geometrie des Widerstandsnetzwerks\n");
     for (i = 0; i < 5; i++) {
       printf("  %i: %s\n", i, label[i]);
@@ -50,7 +87,10 @@ int main(int argc, char **argv) {
            "                   fuer Aenderung des Widerstands \"resistor\"\n"
            "                   von \"start\" bis \"stop\" in Schritten von "
            "\"step\"\n"
-           "                   Einheit: Ohm\n");
+           "                   Einheit: Ohm\n\n");
+    printf("netlist: Datei mit den Widerstaenden eines beliebigen Netzwerks\n"
+           "         (je Zeile \"Knoten Knoten R\" sowie \"source Knoten\"\n"
+           "         und \"sink Knoten\" fuer die Anschluesse)\n");
     
     return -1;
   }
@@ -101,6 +141,146 @@ int main(int argc, char **argv) {
 
 void resistance_table(void (*GLS)(MATRIX*, VECTOR*, double*), int size,
                       int resistor, double start, double stop, double step) {
+  int i, j, rank;
+  
+  /* Koeffizientenmatrix fuer R[resistor] = start, Aenderung der Matrix je Ohm
+   * und Inhomogenitaet */
+  MATRIX *M = matrix_alloc(size);
+  MATRIX *D = matrix_alloc(size);
+  VECTOR *b = vector_alloc(size);
+  /* D = U V^T und die Spalten von A^-1 b und A^-1 U */
+  double *U = malloc(size * size * sizeof(double));
+  double *V = malloc(size * size * sizeof(double));
+  double *Y = malloc(size * (size + 1) * sizeof(double));
+  LU_FACTOR *F = LU_factor_alloc(size);
+  
+  /* Array der Widerstaende R[i] entspricht dabei R(i+1) in der PDF */
+  double R[12] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+  
+  /* Ueberprueft ob alle Speicherallokierungen erfolgreich waren */
+  if ( M != NULL && D != NULL && b != NULL && U != NULL && V != NULL &&
+       Y != NULL && F != NULL ) {
+    /* Die Koeffizienten sind linear in den Widerstaenden, die Differenz fuer
+     * R[resistor] = 1 und 0 ist also die Aenderung je Ohm */
+    R[resistor] = 1;
+    GLS(D, b, R);
+    R[resistor] = 0;
+    GLS(M, b, R);
+    for (i = 0; i < size; i++) {
+      for (j = 0; j < size; j++) {
+        D->elem[i][j] -= M->elem[i][j];
+      }
+    }
+    rank = low_rank(D, U, V);
+    
+    R[resistor] = start;
+    GLS(M, b, R);
+    
+    if ( LU_factor(F, M) == 0 ) {
+      /* Y = A^-1 (b, U) mit einer Zerlegung fuer alle rechten Seiten */
+      for (i = 0; i < size; i++) {
+        Y[i] = b->elem[i];
+      }
+      for (i = 0; i < rank * size; i++) {
+        Y[size + i] = U[i];
+      }
+      LU_solve_many(F, Y, rank + 1, size);
+      
+      woodbury_table(Y, V, size, rank, resistor, start, stop, step);
+    } else {
+      /* Fuer den Startwert singulaer: jedes System wird einzeln geloest */
+      resistance_table_direct(GLS, size, resistor, start, stop, step);
+    }
+  } else {
+    printf("Probleme bei der Allokierung von Speicher!\n");
+  }
+  
+  if ( M != NULL ) matrix_free(M);
+  if ( D != NULL ) matrix_free(D);
+  if ( b != NULL ) vector_free(b);
+  if ( F != NULL ) LU_factor_free(F);
+  free(U);
+  free(V);
+  free(Y);
+}
+
+void woodbury_table(double *Y, double *V, int size, int rank, int resistor,
+                    double start, double stop, double step) {
+  int i, j, p;
+  double x, delta;
+  double value;
+  
+  /* Kleines Gleichungssystem (I + delta C) w = delta g mit C = V^T A^-1 U
+   * und g = V^T A^-1 b */
+  MATRIX *C = matrix_alloc(rank > 0 ? rank : 1);
+  MATRIX *S = matrix_alloc(rank > 0 ? rank : 1);
+  double *g = malloc(2 * (rank > 0 ? rank : 1) * sizeof(double));
+  double *w = g + rank;
+  LU_FACTOR *F = LU_factor_alloc(rank > 0 ? rank : 1);
+  
+  if ( C == NULL || S == NULL || g == NULL || F == NULL ) {
+    printf("Probleme bei der Allokierung von Speicher!\n");
+    if ( C != NULL ) matrix_free(C);
+    if ( S != NULL ) matrix_free(S);
+    if ( F != NULL ) LU_factor_free(F);
+    free(g);
+    return;
+  }
+  
+  for (i = 0; i < rank; i++) {
+    g[i] = 0;
+    for (p = 0; p < size; p++) {
+      g[i] += V[i * size + p] * Y[p];
+    }
+    for (j = 0; j < rank; j++) {
+      C->elem[i][j] = 0;
+      for (p = 0; p < size; p++) {
+        C->elem[i][j] += V[i * size + p] * Y[(j + 1) * size + p];
+      }
+    }
+  }
+  
+  /* Tabellenkopf */
+  printf("# R%i / Ohm\tR_E / Ohm\n", resistor + 1);
+  
+  /* Fuer jeden Wert kostet die Woodbury-Formel nur O(rank^3) Operationen */
+  for (value = start; value <= stop; value += step) {
+    delta = value - start;
+    
+    /* x = A^-1 b - A^-1 U w, benoetigt wird nur das letzte Element */
+    x = Y[size - 1];
+    if ( rank > 0 ) {
+      for (i = 0; i < rank; i++) {
+        for (j = 0; j < rank; j++) {
+          S->elem[i][j] = (i == j) + delta * C->elem[i][j];
+        }
+        w[i] = delta * g[i];
+      }
+      
+      /* Singulaeres System: Der Wert wird wie bei "linear_solve"
+       * uebersprungen */
+      if ( LU_factor(F, S) != 0 ) continue;
+      LU_solve_many(F, w, 1, rank);
+      
+      for (j = 0; j < rank; j++) {
+        x -= Y[(j + 1) * size + size - 1] * w[j];
+      }
+    }
+    
+    /* Ersatzwiderstand R = U/I_ges mit U = 1V (vgl.
+     * "resistance_table_direct") */
+    printf("%f\t%f\n", value, 1.0 / x);
+  }
+  
+  matrix_free(C);
+  matrix_free(S);
+  LU_factor_free(F);
+  free(g);
+}
+
+void resistance_table_direct(void (*GLS)(MATRIX*, VECTOR*, double*), int size,
+                             int resistor, double start, double stop,
+                             double step) {
   /* Allokiert Speicher fuer Koeffizientenmatrix, Inhomogenitaet und Loesung */
   MATRIX *M = matrix_alloc(size);
   VECTOR *b = vector_alloc(size);
@@ -144,3 +324,81 @@ void resistance_table(void (*GLS)(MATRIX*, VECTOR*, double*), int size,
   vector_free(b);
   vector_free(sol);
 }
+
+int low_rank(MATRIX *D, double *U, double *V) {
+  int i, j, p, q, r;
+  int n = D->n;
+  double d, max;
+  double tol = 0;
+  
+  /* Schranke fuer verschwindende Elemente relativ zum groessten Element */
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < n; j++) {
+      if ( fabs(D->elem[i][j]) > tol ) tol = fabs(D->elem[i][j]);
+    }
+  }
+  tol *= 1E-12;
+  
+  for (r = 0; r < n; r++) {
+    /* Betragsmaessig groesstes Element der Restmatrix */
+    p = q = 0;
+    max = 0;
+    for (i = 0; i < n; i++) {
+      for (j = 0; j < n; j++) {
+        if ( fabs(D->elem[i][j]) > max ) {
+          max = fabs(D->elem[i][j]);
+          p = i;
+          q = j;
+        }
+      }
+    }
+    if ( max <= tol ) break;
+    
+    /* u = Spalte q, v = Zeile p / D_pq; D -= u v^T */
+    d = D->elem[p][q];
+    for (i = 0; i < n; i++) {
+      U[r * n + i] = D->elem[i][q];
+      V[r * n + i] = D->elem[p][i] / d;
+    }
+    for (i = 0; i < n; i++) {
+      for (j = 0; j < n; j++) {
+        D->elem[i][j] -= U[r * n + i] * V[r * n + j];
+      }
+    }
+  }
+  
+  return r;
+}
+
+int netlist_table(char *filename) {
+  int line, iterations;
+  double R_E;
+  NETLIST *net = netlist_read(filename, &line);
+  
+  if ( net == NULL ) {
+    if ( line > 0 ) {
+      printf("Fehler in Zeile %i der Netzliste\n", line);
+    } else {
+      printf("Netzliste konnte nicht gelesen werden (Datei, \"source\" oder "
+             "\"sink\" fehlt)\n");
+    }
+    return -1;
+  }
+  
+  /* Knotenanalyse, geloest mit dem CG-Verfahren */
+  iterations = netlist_resistance(net, 1E-10, &R_E);
+  if ( iterations == -3 ) {
+    printf("Probleme bei der Allokierung von Speicher!\n");
+  } else if ( iterations < 0 ) {
+    printf("Keine Konvergenz: Sind Source und Sink verbunden?\n");
+  } else {
+    printf("# %s: %i Knoten, %i Widerstaende, %i Iterationen\n", filename,
+           net->nodes, net->edges, iterations);
+    printf("# R_E / Ohm\n");
+    printf("%.10g\n", R_E);
+  }
+  
+  netlist_free(net);
+  
+  return iterations < 0 ? -1 : 0;
+}
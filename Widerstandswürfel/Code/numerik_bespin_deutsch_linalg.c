@@ -1,6 +1,13 @@
 ﻿#include "numerik_bespin_deutsch_linalg.h"
 #include <stdlib.h>
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Groesse des Zwischenspeichers (double-Werte), den "LU_update" je Thread
+ * benoetigt */
+#define LU_WORK (LU_MC * LU_BLOCK + LU_NC * LU_BLOCK)
 
 MATRIX *matrix_alloc(int n) {
   int i;
@@ -70,7 +77,8 @@ void vector_free(VECTOR *v) {
 }
 
 
-int LU_decomp(MATRIX *A, int *permutation) {
+/* Unblockierte Zerlegung nach Crout (kleine Matrizen) */
+static int LU_decomp_unblocked(MATRIX *A, int *permutation) {
   int i, j, k;
   int n = A->n;
   int piv, temp;
@@ -113,6 +121,401 @@ int LU_decomp(MATRIX *A, int *permutation) {
   return 0;
 }
 
+/* Bestimmt alle Pivot-Zeilen vor der blockweisen Zerlegung und vertauscht die
+ * Zeilen von A entsprechend. Das Kriterium von "pivot_row" im k-ten Schritt
+ * haengt nur von den Elementen A[i][j] mit i, j >= k ab, die im Crout-
+ * Verfahren zu diesem Zeitpunkt noch unveraendert sind. Die Betragssummen der
+ * Zeilen ab Spalte k werden in "sum" mitgefuehrt, statt sie in jedem Schritt
+ * neu zu berechnen. */
+static void pivot_order(MATRIX *A, int *permutation, double *sum) {
+  int i, j, k;
+  int n = A->n;
+  int piv, temp;
+  double max, ratio, temp_sum;
+  
+  for (i = 0; i < n; i++) {
+    sum[i] = 0;
+    for (j = 0; j < n; j++) {
+      sum[i] += fabs(A->elem[i][j]);
+    }
+  }
+  
+  /* Im letzten Schritt ist kein Zeilentausch moeglich */
+  for (k = 0; k < n - 1; k++) {
+    piv = k;
+    max = 0;
+    for (i = k; i < n; i++) {
+      if ( k > 0 ) sum[i] -= fabs(A->elem[i][k - 1]);
+      ratio = A->elem[i][k] / sum[i];
+      
+      if ( ratio > max ) {
+        max = ratio;
+        piv = i;
+      }
+    }
+    
+    if ( piv != k ) {
+      matrix_swap_row(A, k, piv);
+      temp = permutation[k];
+      permutation[k] = permutation[piv];
+      permutation[piv] = temp;
+      temp_sum = sum[k];
+      sum[k] = sum[piv];
+      sum[piv] = temp_sum;
+    }
+  }
+}
+
+/* Zerlegung eines schmalen Blocks (Panel) aus den Zeilen rows[0], ...,
+ * rows[m-1] und den Spalten col, ..., col + w - 1 (m >= w) ohne Pivotisierung.
+ * Jede Zeile wird in einem Durchgang mit den bereits fertigen Zeilen von U
+ * reduziert. */
+static int LU_panel(double **rows, int col, int m, int w) {
+  int i, j, r;
+  double *row, *u;
+  
+  for (r = 0; r < m; r++) {
+    row = rows[r] + col;
+    for (i = 0; i < w && i < r; i++) {
+      u = rows[i] + col;
+      row[i] /= u[i];
+      for (j = i + 1; j < w; j++) {
+        row[j] -= row[i] * u[j];
+      }
+    }
+    
+    /* Diagonalelement von U (vgl. "LU_decomp_unblocked") */
+    if ( r < w && fabs(row[r]) < 1E-10 ) {
+      return -1;
+    }
+  }
+  
+  return 0;
+}
+
+/* SIMD-Vektor aus LU_VL double-Werten (Vektorerweiterung von gcc; ohne
+ * passende Befehle erzeugt der Compiler skalaren Code). LU_VECTOR_U dient zum
+ * Lesen und Schreiben von Vektoren an beliebigen Adressen eines
+ * double-Arrays. */
+typedef double LU_VECTOR
+  __attribute__ ((vector_size (LU_VL * sizeof(double))));
+typedef LU_VECTOR LU_VECTOR_U __attribute__ ((aligned (sizeof(double)),
+                                              may_alias));
+
+/* Mikrokern: C -= A B fuer einen Block von LU_MR x LU_NR Elementen. "a" und
+ * "b" sind umkopierte Streifen (k Spalten von A bzw. k Zeilen von B), C sind
+ * die Zeilen c[0], ..., c[LU_MR-1] ab Spalte "col". Die Summen werden als
+ * Vektoren in Registern gehalten, je Element von A wird eine Zeile von B
+ * (LU_NR / LU_VL Vektoren) multipliziert. */
+static void LU_kernel(int k, const double *a, const double *b, double **c,
+                      int col) {
+  int i, j, p;
+  double a_i;
+  const LU_VECTOR_U *b_p;
+  LU_VECTOR_U *c_i;
+  LU_VECTOR acc[LU_MR][LU_NR / LU_VL];
+  
+  #pragma GCC unroll 16
+  for (i = 0; i < LU_MR; i++) {
+    #pragma GCC unroll 4
+    for (j = 0; j < LU_NR / LU_VL; j++) {
+      acc[i][j] = (LU_VECTOR) {0};
+    }
+  }
+  
+  for (p = 0; p < k; p++) {
+    b_p = (const LU_VECTOR_U *)(b + p * LU_NR);
+    #pragma GCC unroll 16
+    for (i = 0; i < LU_MR; i++) {
+      a_i = a[p * LU_MR + i];
+      #pragma GCC unroll 4
+      for (j = 0; j < LU_NR / LU_VL; j++) {
+        acc[i][j] += a_i * b_p[j];
+      }
+    }
+  }
+  
+  #pragma GCC unroll 16
+  for (i = 0; i < LU_MR; i++) {
+    c_i = (LU_VECTOR_U *)(c[i] + col);
+    #pragma GCC unroll 4
+    for (j = 0; j < LU_NR / LU_VL; j++) {
+      c_i[j] -= acc[i][j];
+    }
+  }
+}
+
+/* Matrixprodukt C -= A B: A steht in den Zeilen a[0], ..., a[m-1] und den
+ * Spalten col_a, ..., col_a + k - 1, B in den Zeilen b[0], ..., b[k-1] und den
+ * Spalten col_b, ..., col_b + n - 1, C in den Zeilen c[0], ..., c[m-1] ab
+ * Spalte col_c.
+ * Bloecke von B (k x LU_NC) und A (LU_MC x k) werden in "work" in Streifen
+ * der Breite LU_NR bzw. LU_MR umkopiert, damit der Mikrokern zusammenhaengend
+ * liest. */
+static void LU_gemm(double **a, int col_a, double **b, int col_b, double **c,
+                    int col_c, int m, int n, int k, double *work) {
+  int i, j, p, ic, jc, ir, jr, mc, nc;
+  double edge[LU_MR * LU_NR];
+  double *edge_rows[LU_MR];
+  double *packed_a = work;
+  double *packed_b = work + LU_MC * LU_BLOCK;
+  
+  for (jc = 0; jc < n; jc += LU_NC) {
+    nc = (n - jc < LU_NC) ? n - jc : LU_NC;
+    
+    /* Streifen von B (am Rand mit 0 aufgefuellt) */
+    for (jr = 0; jr < nc; jr += LU_NR) {
+      for (p = 0; p < k; p++) {
+        for (j = 0; j < LU_NR; j++) {
+          packed_b[jr * k + p * LU_NR + j] =
+            (jr + j < nc) ? b[p][col_b + jc + jr + j] : 0;
+        }
+      }
+    }
+    
+    for (ic = 0; ic < m; ic += LU_MC) {
+      mc = (m - ic < LU_MC) ? m - ic : LU_MC;
+      
+      /* Streifen von A */
+      for (ir = 0; ir < mc; ir += LU_MR) {
+        for (p = 0; p < k; p++) {
+          for (i = 0; i < LU_MR; i++) {
+            packed_a[ir * k + p * LU_MR + i] =
+              (ir + i < mc) ? a[ic + ir + i][col_a + p] : 0;
+          }
+        }
+      }
+      
+      for (jr = 0; jr < nc; jr += LU_NR) {
+        for (ir = 0; ir < mc; ir += LU_MR) {
+          if ( ir + LU_MR <= mc && jr + LU_NR <= nc ) {
+            LU_kernel(k, packed_a + ir * k, packed_b + jr * k, c + ic + ir,
+                      col_c + jc + jr);
+            continue;
+          }
+          
+          /* Am Rand wird der Block zunaechst in "edge" berechnet */
+          for (i = 0; i < LU_MR; i++) {
+            edge_rows[i] = edge + i * LU_NR;
+            for (j = 0; j < LU_NR; j++) {
+              edge[i * LU_NR + j] = 0;
+            }
+          }
+          LU_kernel(k, packed_a + ir * k, packed_b + jr * k, edge_rows, 0);
+          for (i = 0; i < LU_MR && ir + i < mc; i++) {
+            for (j = 0; j < LU_NR && jr + j < nc; j++) {
+              c[ic + ir + i][col_c + jc + jr + j] += edge[i * LU_NR + j];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/* Aktualisierung der Restmatrix A22 -= L21 U12: L21 steht in den Zeilen
+ * a[0], ..., a[m-1] und den Spalten col_a, ..., col_a + k - 1, U12 in den
+ * Zeilen b[0], ..., b[k-1] und den Spalten col_b, ..., col_b + n - 1, A22 in
+ * den Zeilen von L21 und den Spalten von U12. */
+static void LU_update(double **a, int col_a, double **b, int col_b,
+                      int m, int n, int k, double *work) {
+  LU_gemm(a, col_a, b, col_b, a, col_b, m, n, k, work);
+}
+
+/* Berechnet U12 = L11^-1 A12 fuer die Zeilen rows[0], ..., rows[w-1]: L11
+ * steht in den Spalten col, ..., col + w - 1, A12 in den Spalten col_b, ...,
+ * col_b + n - 1. Je LU_PANEL Zeilen werden durch Vorwaertssubstitution
+ * bestimmt und von den folgenden Zeilen mit "LU_update" abgezogen. */
+static void LU_block_sub(double **rows, int col, int w, int col_b, int n,
+                         double *work) {
+  int i, j, p, k, kb;
+  double l;
+  double *row, *u;
+  
+  for (k = 0; k < w; k += LU_PANEL) {
+    kb = (w - k < LU_PANEL) ? w - k : LU_PANEL;
+    
+    for (i = k + 1; i < k + kb; i++) {
+      row = rows[i] + col_b;
+      for (p = k; p < i; p++) {
+        l = rows[i][col + p];
+        u = rows[p] + col_b;
+        #pragma omp simd
+        for (j = 0; j < n; j++) {
+          row[j] -= l * u[j];
+        }
+      }
+    }
+    
+    if ( k + kb < w ) {
+      LU_update(rows + k + kb, col + k, rows + k, col_b,
+                w - k - kb, n, kb, work);
+    }
+  }
+}
+
+/* Rechtsschauende blockweise Zerlegung der Zeilen rows[0], ..., rows[m-1] und
+ * der Spalten col, ..., col + w - 1 (m >= w) ohne Pivotisierung: Fuer jeden
+ * Spaltenblock der Breite "block" wird das Panel zerlegt (selbst wieder
+ * blockweise mit Breite LU_PANEL), U12 berechnet und die Restmatrix
+ * aktualisiert. */
+static int LU_decomp_blocked(double **rows, int col, int m, int w, int block,
+                             double *work) {
+  int k, kb;
+  int ret;
+  
+  for (k = 0; k < w; k += block) {
+    kb = (w - k < block) ? w - k : block;
+    
+    if ( kb <= LU_PANEL ) {
+      ret = LU_panel(rows + k, col + k, m - k, kb);
+    } else {
+      ret = LU_decomp_blocked(rows + k, col + k, m - k, kb, LU_PANEL, work);
+    }
+    if ( ret != 0 ) return ret;
+    
+    if ( k + kb < w ) {
+      LU_block_sub(rows + k, col + k, kb, col + k + kb, w - k - kb, work);
+      LU_update(rows + k + kb, col + k, rows + k, col + k + kb,
+                m - k - kb, w - k - kb, kb, work);
+    }
+  }
+  
+  return 0;
+}
+
+#ifdef _OPENMP
+/* Berechnet L21 = A21 U11^-1 fuer die Zeilen rows[0], ..., rows[m-1] und die
+ * Spalten col, ..., col + w - 1; U11 steht in den Zeilen u[0], ..., u[w-1]
+ * derselben Spalten. Je LU_PANEL Spalten werden zeilenweise bestimmt (wie in
+ * "LU_panel") und mit "LU_update" von den folgenden Spalten abgezogen. */
+static void LU_lower_sub(double **u, double **rows, int col, int m, int w,
+                         double *work) {
+  int i, j, r, k, kb;
+  double *row, *u_i;
+  
+  for (k = 0; k < w; k += LU_PANEL) {
+    kb = (w - k < LU_PANEL) ? w - k : LU_PANEL;
+    
+    for (r = 0; r < m; r++) {
+      row = rows[r] + col + k;
+      for (i = 0; i < kb; i++) {
+        u_i = u[k + i] + col + k;
+        row[i] /= u_i[i];
+        for (j = i + 1; j < kb; j++) {
+          row[j] -= row[i] * u_i[j];
+        }
+      }
+    }
+    
+    if ( k + kb < w ) {
+      LU_update(rows, col + k, u + k, col + k + kb, m, w - k - kb, kb, work);
+    }
+  }
+}
+
+/* Parallele Zerlegung ohne Pivotisierung in Kacheln von LU_BLOCK x LU_BLOCK
+ * Elementen: Fuer jeden Schritt k wird die Diagonalkachel (k, k) zerlegt,
+ * danach werden die Kacheln (i, k) zu L und (k, j) zu U (i, j > k) und
+ * schliesslich die Kacheln (i, j) der Restmatrix aktualisiert. Jede dieser
+ * Operationen ist eine Task, deren Abhaengigkeiten sich auf die Kacheln
+ * beziehen (als Adresse dient das erste Element der Kachel). Dadurch koennen
+ * Tasks verschiedener Schritte ueberlappen, z.B. wird die naechste
+ * Diagonalkachel zerlegt, waehrend die Restmatrix noch aktualisiert wird.
+ * "work" enthaelt fuer jeden Thread LU_WORK Werte. */
+static int LU_decomp_tiles(double **rows, int n, double *work) {
+  int failed = 0;
+  
+  #pragma omp parallel
+  #pragma omp single
+  {
+    int i, j, k, tiles, i0, j0, k0, mi, nj, kb;
+    
+    tiles = (n + LU_BLOCK - 1) / LU_BLOCK;
+    for (k = 0; k < tiles; k++) {
+      k0 = k * LU_BLOCK;
+      kb = (n - k0 < LU_BLOCK) ? n - k0 : LU_BLOCK;
+      
+      #pragma omp task depend(inout: rows[k0][k0]) shared(failed)
+      {
+        if ( LU_decomp_blocked(rows + k0, k0, kb, kb, LU_PANEL,
+                               work + omp_get_thread_num() * LU_WORK) != 0 ) {
+          #pragma omp atomic write
+          failed = 1;
+        }
+      }
+      
+      for (i = k + 1; i < tiles; i++) {
+        i0 = i * LU_BLOCK;
+        mi = (n - i0 < LU_BLOCK) ? n - i0 : LU_BLOCK;
+        #pragma omp task depend(in: rows[k0][k0]) depend(inout: rows[i0][k0])
+        LU_lower_sub(rows + k0, rows + i0, k0, mi, kb,
+                     work + omp_get_thread_num() * LU_WORK);
+      }
+      
+      for (j = k + 1; j < tiles; j++) {
+        j0 = j * LU_BLOCK;
+        nj = (n - j0 < LU_BLOCK) ? n - j0 : LU_BLOCK;
+        #pragma omp task depend(in: rows[k0][k0]) depend(inout: rows[k0][j0])
+        LU_block_sub(rows + k0, k0, kb, j0, nj,
+                     work + omp_get_thread_num() * LU_WORK);
+      }
+      
+      for (i = k + 1; i < tiles; i++) {
+        i0 = i * LU_BLOCK;
+        mi = (n - i0 < LU_BLOCK) ? n - i0 : LU_BLOCK;
+        for (j = k + 1; j < tiles; j++) {
+          j0 = j * LU_BLOCK;
+          nj = (n - j0 < LU_BLOCK) ? n - j0 : LU_BLOCK;
+          #pragma omp task depend(in: rows[i0][k0], rows[k0][j0]) \
+                           depend(inout: rows[i0][j0])
+          LU_update(rows + i0, k0, rows + k0, j0, mi, nj, kb,
+                    work + omp_get_thread_num() * LU_WORK);
+        }
+      }
+    }
+  }
+  
+  /* Nach einer (fast) singulaeren Diagonalkachel sind die folgenden Werte
+   * unbrauchbar, die Zerlegung wird aber zu Ende gefuehrt */
+  return failed ? -1 : 0;
+}
+#endif
+
+int LU_decomp(MATRIX *A, int *permutation) {
+  int n = A->n;
+  int threads = 1;
+  int ret;
+  double *work;
+  
+  /* Kleine Matrizen (und ohne Zwischenspeicher) unblockiert */
+  if ( n <= LU_BLOCK ) {
+    return LU_decomp_unblocked(A, permutation);
+  }
+#ifdef _OPENMP
+  if ( n >= LU_PARALLEL_MIN ) threads = omp_get_max_threads();
+#endif
+  work = malloc((threads * LU_WORK + n) * sizeof(double));
+  if ( work == NULL ) {
+    return LU_decomp_unblocked(A, permutation);
+  }
+  
+  /* Zeilensummen fuer die Pivotisierung am Ende des Zwischenspeichers */
+  pivot_order(A, permutation, work + threads * LU_WORK);
+#ifdef _OPENMP
+  if ( threads > 1 ) {
+    ret = LU_decomp_tiles(A->elem, n, work);
+    free(work);
+    return ret;
+  }
+#endif
+  ret = LU_decomp_blocked(A->elem, 0, n, n, LU_BLOCK, work);
+  
+  free(work);
+  
+  return ret;
+}
+
 int pivot_row(MATRIX *A, int k) {
   int i, j;
   int n = A->n;
@@ -143,48 +546,85 @@ int pivot_row(MATRIX *A, int k) {
 
 int LU_solve(MATRIX *LU, VECTOR *Pb, VECTOR *sol) {
   /* Es ist LUx = Pb zu loesen. */
-  VECTOR *y = vector_alloc(Pb->n);
-  
-  /* Loese zuerst Ly = Pb mit y = Ux durch Vorwaertssubstitution */
-  LU_forward_sub(LU, Pb, y);
-  /* Loese Ux = y durch Rueckwaertssubstitution */
-  LU_back_sub(LU, y, sol);
+  if ( Pb->n != LU->n || sol->n != LU->n ) return -1;
   
-  vector_free(y);
+  /* Loese zuerst Ly = Pb mit y = Ux durch Vorwaertssubstitution; y wird
+   * direkt in "sol" gespeichert */
+  LU_forward_sub(LU, Pb, sol);
+  /* Loese Ux = y durch Rueckwaertssubstitution (Element i von y wird erst
+   * fuer x_i gelesen und dann ueberschrieben) */
+  LU_back_sub(LU, sol, sol);
   
   return 0;
 }
 
 int LU_forward_sub(MATRIX *LU, VECTOR *b, VECTOR *sol) {
-  int i, j;
   int n = LU->n;
   
   if ( n != b->n ) return -1;
   
-  for (i = 0; i < n; i++) {
-    sol->elem[i] = b->elem[i];
-    for (j = 0; j < i; j++) {
-      sol->elem[i] -= LU->elem[i][j] * sol->elem[j];
+  /* Blockweise mit LU_BLOCK Zeilen: Die Beitraege der bereits berechneten
+   * Elemente werden fuer alle Zeilen des Blocks parallel abgezogen, danach
+   * der Block selbst der Reihe nach (gleiche Reihenfolge der Summation wie
+   * Zeile fuer Zeile) */
+  #pragma omp parallel if (n >= LU_PARALLEL_MIN)
+  {
+    int i, j, k0, k1;
+    
+    for (k0 = 0; k0 < n; k0 += LU_BLOCK) {
+      k1 = (n - k0 < LU_BLOCK) ? n : k0 + LU_BLOCK;
+      
+      #pragma omp for schedule(static)
+      for (i = k0; i < k1; i++) {
+        sol->elem[i] = b->elem[i];
+        for (j = 0; j < k0; j++) {
+          sol->elem[i] -= LU->elem[i][j] * sol->elem[j];
+        }
+      }
+      
+      #pragma omp single
+      for (i = k0; i < k1; i++) {
+        for (j = k0; j < i; j++) {
+          sol->elem[i] -= LU->elem[i][j] * sol->elem[j];
+        }
+        /* Es wird hier nicht durch L[i][i] geteilt, da die Diagonalelemente
+         * der unteren Dreickecksmatrix 1 sind. */
+      }
     }
-    /* Es wird hier nicht durch L[i][i] geteilt, da die Diagonalelemente der
-     * unteren Dreickecksmatrix 1 sind. */
   }
   
   return 0;
 }
 
 int LU_back_sub(MATRIX *LU, VECTOR *b, VECTOR *sol) {
-  int i, j;
   int n = LU->n;
   
   if ( n != b->n ) return -1;
   
-  for (i = n - 1; i >= 0; i--) {
-    sol->elem[i] = b->elem[i];
-    for (j = i + 1; j < n; j++) {
-      sol->elem[i] -= LU->elem[i][j] * sol->elem[j];
+  /* Blockweise von unten wie "LU_forward_sub" */
+  #pragma omp parallel if (n >= LU_PARALLEL_MIN)
+  {
+    int i, j, k0, k1;
+    
+    for (k1 = n; k1 > 0; k1 -= LU_BLOCK) {
+      k0 = (k1 < LU_BLOCK) ? 0 : k1 - LU_BLOCK;
+      
+      #pragma omp for schedule(static)
+      for (i = k0; i < k1; i++) {
+        sol->elem[i] = b->elem[i];
+        for (j = k1; j < n; j++) {
+          sol->elem[i] -= LU->elem[i][j] * sol->elem[j];
+        }
+      }
+      
+      #pragma omp single
+      for (i = k1 - 1; i >= k0; i--) {
+        for (j = i + 1; j < k1; j++) {
+          sol->elem[i] -= LU->elem[i][j] * sol->elem[j];
+        }
+        sol->elem[i] /= LU->elem[i][i];
+      }
     }
-    sol->elem[i] /= LU->elem[i][i];
   }
   
   return 0;
@@ -193,11 +633,14 @@ int LU_back_sub(MATRIX *LU, VECTOR *b, VECTOR *sol) {
 int linear_solve(MATRIX *A, VECTOR *b, VECTOR *sol) {
   int i;
   int n = A->n;
-  int *permutation = malloc(n * sizeof(int));
-  VECTOR *Pb = vector_alloc(n);
+  int *permutation;
+  VECTOR *Pb;
   
   if ( A->n != b->n ) return -1;
   
+  permutation = malloc(n * sizeof(int));
+  Pb = vector_alloc(n);
+  
   /* Fuellt das Permutationsarray mit {0, 1, ..., n-1} */
   for (i = 0; i < n; i++) {
     permutation[i] = i;
@@ -205,6 +648,8 @@ int linear_solve(MATRIX *A, VECTOR *b, VECTOR *sol) {
   
   /* LU-Zerlegung der Matrix */
   if ( LU_decomp(A, permutation) == -1 ) {
+    free(permutation);
+    vector_free(Pb);
     return -2;
   }
   
@@ -216,5 +661,158 @@ int linear_solve(MATRIX *A, VECTOR *b, VECTOR *sol) {
   /* Loesung des identischen Gleichungssystems LUx = Pb */
   LU_solve(A, Pb, sol);
   
+  free(permutation);
+  vector_free(Pb);
+  
+  return 0;
+}
+
+LU_FACTOR *LU_factor_alloc(int n) {
+  int threads = 1;
+  LU_FACTOR *F = malloc(sizeof(LU_FACTOR));
+  
+  if ( F == NULL ) return NULL;
+  
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  F->threads = threads;
+  F->LU = matrix_alloc(n);
+  F->permutation = malloc(n * sizeof(int));
+  F->work = malloc(threads * (LU_WORK + (size_t)n * LU_RHS) * sizeof(double));
+  F->rows = malloc(threads * (size_t)n * sizeof(double *));
+  if ( F->LU == NULL || F->permutation == NULL || F->work == NULL ||
+       F->rows == NULL ) {
+    LU_factor_free(F);
+    return NULL;
+  }
+  
+  return F;
+}
+
+void LU_factor_free(LU_FACTOR *F) {
+  if ( F->LU != NULL ) matrix_free(F->LU);
+  free(F->permutation);
+  free(F->work);
+  free(F->rows);
+  free(F);
+}
+
+int LU_factor(LU_FACTOR *F, MATRIX *A) {
+  int i, j;
+  int n = A->n;
+  MATRIX *LU = F->LU;
+  
+  if ( LU->n != n ) return -1;
+  
+  /* Die Zeilenpointer sind von einer frueheren Zerlegung permutiert */
+  for (i = 0; i < n; i++) {
+    LU->elem[i] = LU->data + i * n;
+    F->permutation[i] = i;
+    for (j = 0; j < n; j++) {
+      LU->elem[i][j] = A->elem[i][j];
+    }
+  }
+  
+  if ( LU_decomp(LU, F->permutation) == -1 ) return -2;
+  
+  return 0;
+}
+
+/* Loest A X = B fuer die Spalten c0, ..., c0 + r - 1 von B (r <= LU_RHS):
+ * Der permutierte Block wird zeilenweise in x[0], ..., x[n-1] gespeichert,
+ * damit die Beitraege der Bloecke von L bzw. U mit "LU_gemm" abgezogen
+ * werden koennen. */
+static void LU_solve_block(LU_FACTOR *F, double *B, int ldb, int c0, int r,
+                           double *work, double **x) {
+  int i, p, c, k0, k1;
+  int n = F->LU->n;
+  double l;
+  double **lu = F->LU->elem;
+  double *data = work + LU_WORK;
+  
+  for (i = 0; i < n; i++) {
+    x[i] = data + i * r;
+  }
+  for (c = 0; c < r; c++) {
+    for (i = 0; i < n; i++) {
+      x[i][c] = B[(size_t)(c0 + c) * ldb + F->permutation[i]];
+    }
+  }
+  
+  /* Vorwaertssubstitution: Block von L11 der Reihe nach, danach wird der
+   * Beitrag des Blocks von den folgenden Zeilen abgezogen */
+  for (k0 = 0; k0 < n; k0 += LU_BLOCK) {
+    k1 = (n - k0 < LU_BLOCK) ? n : k0 + LU_BLOCK;
+    
+    for (i = k0 + 1; i < k1; i++) {
+      for (p = k0; p < i; p++) {
+        l = lu[i][p];
+        #pragma omp simd
+        for (c = 0; c < r; c++) {
+          x[i][c] -= l * x[p][c];
+        }
+      }
+    }
+    
+    if ( k1 < n ) {
+      LU_gemm(lu + k1, k0, x + k0, 0, x + k1, 0, n - k1, r, k1 - k0, work);
+    }
+  }
+  
+  /* Rueckwaertssubstitution entsprechend von unten */
+  for (k1 = n; k1 > 0; k1 -= LU_BLOCK) {
+    k0 = (k1 < LU_BLOCK) ? 0 : k1 - LU_BLOCK;
+    
+    for (i = k1 - 1; i >= k0; i--) {
+      for (p = i + 1; p < k1; p++) {
+        l = lu[i][p];
+        #pragma omp simd
+        for (c = 0; c < r; c++) {
+          x[i][c] -= l * x[p][c];
+        }
+      }
+      l = 1 / lu[i][i];
+      #pragma omp simd
+      for (c = 0; c < r; c++) {
+        x[i][c] *= l;
+      }
+    }
+    
+    if ( k0 > 0 ) {
+      LU_gemm(lu, k0, x + k0, 0, x, 0, k0, r, k1 - k0, work);
+    }
+  }
+  
+  for (c = 0; c < r; c++) {
+    for (i = 0; i < n; i++) {
+      B[(size_t)(c0 + c) * ldb + i] = x[i][c];
+    }
+  }
+}
+
+int LU_solve_many(LU_FACTOR *F, double *B, int nrhs, int ldb) {
+  int n = F->LU->n;
+  int blocks = (nrhs + LU_RHS - 1) / LU_RHS;
+  int block;
+  
+  if ( nrhs < 0 || ldb < n ) return -1;
+  
+  /* Jeder Thread verwendet seinen eigenen Teil der Zwischenspeicher */
+  #pragma omp parallel for schedule(dynamic) num_threads(F->threads) \
+    if (blocks > 1)
+  for (block = 0; block < blocks; block++) {
+    int thread = 0;
+    int c0 = block * LU_RHS;
+    int r = (nrhs - c0 < LU_RHS) ? nrhs - c0 : LU_RHS;
+    
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    LU_solve_block(F, B, ldb, c0, r,
+                   F->work + thread * (LU_WORK + (size_t)n * LU_RHS),
+                   F->rows + thread * (size_t)n);
+  }
+  
   return 0;
 }
@@ -37,11 +37,51 @@ VECTOR *vector_alloc(int n);
 void vector_free(VECTOR *v);
 
 
+/* Parameter der blockweisen LU-Zerlegung:
+ * LU_BLOCK: Breite der Spaltenbloecke; Matrizen bis zu dieser Dimension werden
+ *           unblockiert zerlegt
+ * LU_PANEL: Breite der Bloecke innerhalb eines Spaltenblocks
+ * LU_VL: Anzahl der double-Werte in einem SIMD-Register
+ * LU_MR, LU_NR: Zeilen und Spalten des Blocks, den der Mikrokern in Registern
+ *               haelt (LU_MR * LU_NR / LU_VL Register fuer die Summen)
+ * LU_MC, LU_NC: Zeilen von L bzw. Spalten von U, die fuer die Aktualisierung
+ *               der Restmatrix gemeinsam umkopiert werden (LU_MC ein
+ *               Vielfaches von LU_MR, LU_NC eines von LU_NR) */
+#define LU_BLOCK 128
+#define LU_PANEL 16
+#if defined(__AVX512F__)
+#define LU_VL 8
+#define LU_MR 12
+#define LU_NR 8
+#elif defined(__AVX__)
+#define LU_VL 4
+#define LU_MR 6
+#define LU_NR 8
+#else
+#define LU_VL 2
+#define LU_MR 6
+#define LU_NR 4
+#endif
+#define LU_MC 120
+#define LU_NC 1024
+
+/* Ab dieser Dimension werden LU-Zerlegung (in Kacheln von LU_BLOCK x LU_BLOCK
+ * Elementen als Tasks) und Substitution mit OpenMP (falls aktiviert) auf
+ * mehrere Threads verteilt */
+#define LU_PARALLEL_MIN 512
+
 /* LU/LR-Zerlegung der Matrix A mit Pivotisierung
  * Die Permutierung der Zeilen wird analog auf dem Array "permutation" durchge-
  * fuehrt. Es wird fuer die LU-Zerlegung keine neue Matrix angelegt, sondern das
  * Ergebnis der Zerlegung direkt in A gespeichert. Dabei entspricht U dem oberen
  * Dreieck von A und L dem Unteren mit 1-en auf der Diagonalen.
+ * Groessere Matrizen (n > LU_BLOCK) werden blockweise zerlegt: Die Pivot-
+ * Zeilen (Kriterium wie "pivot_row") werden vorab bestimmt, danach wird fuer
+ * jeden Spaltenblock die Restmatrix mit einem Produkt von Matrixbloecken
+ * aktualisiert, die in zusammenhaengende Zwischenspeicher kopiert werden.
+ * Ab LU_PARALLEL_MIN wird mit OpenMP in Kacheln zerlegt, deren Operationen
+ * nach ihren Abhaengigkeiten parallel ausgefuehrt werden; Pivotisierung und
+ * Ergebnis sind dieselben.
  *
  * Rueckgabewert:
  * 0: Erfolgreiche Zerlegung
@@ -58,7 +98,8 @@ int pivot_row(MATRIX *A, int k);
 int LU_solve(MATRIX *LU, VECTOR *Pb, VECTOR *sol);
 
 /* Fuehrt Vorwaerts-/Rueckwaerts-Substitution auf die LU-Zerlegung "LU" mit der
- * Inhomogenitaet "b" durch und speichert das Ergebnis in "sol"
+ * Inhomogenitaet "b" durch und speichert das Ergebnis in "sol" (ab
+ * LU_PARALLEL_MIN blockweise mit mehreren Threads)
  *
  * Rueckgabewert:
  * 0: Erfolg
@@ -75,4 +116,54 @@ int LU_back_sub(MATRIX *LU, VECTOR *b, VECTOR *sol);
  * -2: Matrix ist (fast) singulaer */
 int linear_solve(MATRIX *A, VECTOR *b, VECTOR *sol);
 
+
+/* Anzahl der rechten Seiten, die "LU_solve_many" gemeinsam (als Block von
+ * Zeilen der Laenge LU_RHS) substituiert */
+#define LU_RHS 64
+
+/* LU-Zerlegung zum wiederholten Loesen von Systemen mit derselben Matrix
+ * LU: Zerlegung nach "LU_decomp"
+ * permutation: Zeilenpermutation der Zerlegung
+ * threads: Anzahl der Threads, fuer die Zwischenspeicher vorhanden ist
+ * work: Zwischenspeicher fuer "LU_solve_many" (je Thread Streifen fuer
+ *       "LU_update" und ein Block von n x LU_RHS rechten Seiten)
+ * rows: Zeilenpointer in die Bloecke der rechten Seiten (je Thread n) */
+typedef struct {
+  MATRIX *LU;
+  int *permutation;
+  int threads;
+  double *work;
+  double **rows;
+} LU_FACTOR;
+
+/* Allokiert eine LU_FACTOR-Struktur fuer (n x n)-Matrizen einschliesslich
+ * aller Zwischenspeicher; bei fehlgeschlagener Allokierung wird NULL
+ * zurueckgegeben. */
+LU_FACTOR *LU_factor_alloc(int n);
+
+/* Gibt den Speicher der Zerlegung wieder frei */
+void LU_factor_free(LU_FACTOR *F);
+
+/* Kopiert A in die Zerlegung und fuehrt "LU_decomp" durch, A selbst bleibt
+ * unveraendert.
+ *
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: Dimensionskonflikt zwischen A und der Zerlegung
+ * -2: Matrix ist (fast) singulaer */
+int LU_factor(LU_FACTOR *F, MATRIX *A);
+
+/* Loest A X = B fuer "nrhs" rechte Seiten mit der Zerlegung F von A. B ist
+ * spaltenweise gespeichert (Spalte c beginnt bei B + c * ldb, ldb >= n) und
+ * wird mit der Loesung X ueberschrieben. Je LU_RHS Spalten werden permutiert
+ * in einen Block umkopiert und blockweise substituiert, wobei die Beitraege
+ * bereits berechneter Bloecke als Matrixprodukt (wie bei der Zerlegung)
+ * abgezogen werden. Mit OpenMP werden die Bloecke auf mehrere Threads
+ * verteilt. Es wird kein Speicher allokiert.
+ *
+ * Rueckgabewert:
+ * 0: Erfolg
+ * -1: ungueltige Dimensionen */
+int LU_solve_many(LU_FACTOR *F, double *B, int nrhs, int ldb);
+
 #endif
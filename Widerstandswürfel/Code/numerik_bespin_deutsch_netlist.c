@@ -0,0 +1,263 @@
+#include "numerik_bespin_deutsch_netlist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Haengt einen Widerstand an die Netzliste an (Speicher wird bei Bedarf
+ * verdoppelt); Rueckgabewert -1 bei fehlgeschlagener Allokierung */
+static int netlist_append(NETLIST *net, int *size, int from, int to,
+                          double R) {
+  int *new_from, *new_to;
+  double *new_R;
+  
+  if ( net->edges == *size ) {
+    *size = (*size == 0) ? 1024 : 2 * *size;
+    new_from = realloc(net->from, *size * sizeof(int));
+    if ( new_from != NULL ) net->from = new_from;
+    new_to = realloc(net->to, *size * sizeof(int));
+    if ( new_to != NULL ) net->to = new_to;
+    new_R = realloc(net->R, *size * sizeof(double));
+    if ( new_R != NULL ) net->R = new_R;
+    if ( new_from == NULL || new_to == NULL || new_R == NULL ) return -1;
+  }
+  
+  net->from[net->edges] = from;
+  net->to[net->edges] = to;
+  net->R[net->edges] = R;
+  net->edges++;
+  
+  return 0;
+}
+
+/* Liest die Knotennummer von "source"/"sink" dezimal wie die Knoten der
+ * Widerstaende (nicht mit "%i", das fuehrende Nullen oktal liest); nach der
+ * Zahl darf nur Leerraum folgen. Rueckgabewert -1 bei ungueltiger Zahl */
+static int netlist_node(char *pos, int *node) {
+  long value;
+  char *end;
+  
+  value = strtol(pos, &end, 10);
+  if ( end == pos || value < 0 || value > 2147483646 ) return -1;
+  if ( end[strspn(end, " \t\r\n")] != '\0' ) return -1;
+  
+  *node = value;
+  return 0;
+}
+
+NETLIST *netlist_read(char *filename, int *line) {
+  int size = 0;
+  int error = 0;
+  long from, to;
+  double R;
+  char buffer[256];
+  char *pos, *end;
+  FILE *file;
+  NETLIST *ret;
+  
+  *line = 0;
+  
+  if ( NULL == (file = fopen(filename, "r")) ) {
+    return NULL;
+  }
+  if ( NULL == (ret = malloc(sizeof(NETLIST))) ) {
+    fclose(file);
+    return NULL;
+  }
+  ret->nodes = 0;
+  ret->edges = 0;
+  ret->source = -1;
+  ret->sink = -1;
+  ret->from = NULL;
+  ret->to = NULL;
+  ret->R = NULL;
+  
+  while ( error == 0 && fgets(buffer, sizeof(buffer), file) != NULL ) {
+    (*line)++;
+  
+    /* Kommentare und Leerzeilen */
+    pos = buffer + strspn(buffer, " \t");
+    if ( *pos == '#' || *pos == '\n' || *pos == '\r' || *pos == '\0' ) {
+      continue;
+    }
+  
+    if ( strncmp(pos, "source", 6) == 0 ) {
+      if ( netlist_node(pos + 6, &ret->source) != 0 ) error = 1;
+    } else if ( strncmp(pos, "sink", 4) == 0 ) {
+      if ( netlist_node(pos + 4, &ret->sink) != 0 ) error = 1;
+    } else {
+      /* Widerstand "Knoten Knoten R" (ohne sscanf, da Netzlisten Millionen
+       * Zeilen haben koennen) */
+      from = strtol(pos, &end, 10);
+      if ( end == pos || from < 0 || from > 2147483646 ) error = 1;
+      pos = end;
+      to = strtol(pos, &end, 10);
+      if ( end == pos || to < 0 || to > 2147483646 ) error = 1;
+      pos = end;
+      /* Kurzschluesse (R = 0) sind in der Knotenanalyse nicht darstellbar */
+      R = strtod(pos, &end);
+      if ( end == pos || !(R > 0) ) error = 1;
+  
+      if ( error == 0 ) {
+        if ( netlist_append(ret, &size, from, to, R) != 0 ) {
+          *line = 0;
+          error = 1;
+        }
+        if ( from >= ret->nodes ) ret->nodes = from + 1;
+        if ( to >= ret->nodes ) ret->nodes = to + 1;
+      }
+    }
+  }
+  
+  /* Bei einem Fehler steht in "line" die zuletzt gelesene Zeile */
+  if ( error == 0 && (ret->source < 0 || ret->sink < 0 ||
+                      ret->source == ret->sink) ) {
+    *line = 0;
+    error = 1;
+  }
+  if ( error != 0 ) {
+    fclose(file);
+    netlist_free(ret);
+    return NULL;
+  }
+  fclose(file);
+  
+  if ( ret->source >= ret->nodes ) ret->nodes = ret->source + 1;
+  if ( ret->sink >= ret->nodes ) ret->nodes = ret->sink + 1;
+  
+  return ret;
+}
+
+void netlist_free(NETLIST *net) {
+  free(net->from);
+  free(net->to);
+  free(net->R);
+  free(net);
+}
+
+SPARSE_MATRIX *netlist_system(NETLIST *net) {
+  int i, j, k, e, start, end, nnz;
+  int n = net->nodes - 1;
+  double g;
+  int *pos;
+  SPARSE_MATRIX *T, *A;
+  
+  /* Elemente je Zeile: Diagonale und je ein Element fuer jeden Widerstand
+   * zu einem anderen Knoten als "sink" (Selbstschleifen entfallen) */
+  if ( NULL == (pos = malloc((n + 1) * sizeof(int))) ) {
+    return NULL;
+  }
+  for (i = 0; i < n; i++) {
+    pos[i] = 1;
+  }
+  nnz = n;
+  for (e = 0; e < net->edges; e++) {
+    i = net->from[e];
+    j = net->to[e];
+    if ( i == j || i == net->sink || j == net->sink ) continue;
+    pos[i > net->sink ? i - 1 : i]++;
+    pos[j > net->sink ? j - 1 : j]++;
+    nnz += 2;
+  }
+  
+  T = sparse_alloc(n, nnz);
+  A = sparse_alloc(n, nnz);
+  if ( T == NULL || A == NULL ) {
+    if ( T != NULL ) sparse_free(T);
+    if ( A != NULL ) sparse_free(A);
+    free(pos);
+    return NULL;
+  }
+  
+  /* Zeilen in Reihenfolge der Widerstaende fuellen, Diagonale zuerst */
+  T->row[0] = 0;
+  for (i = 0; i < n; i++) {
+    T->row[i+1] = T->row[i] + pos[i];
+    T->col[T->row[i]] = i;
+    T->val[T->row[i]] = 0;
+    pos[i] = T->row[i] + 1;
+  }
+  for (e = 0; e < net->edges; e++) {
+    i = net->from[e];
+    j = net->to[e];
+    if ( i == j ) continue;
+    g = 1 / net->R[e];
+    i = (i == net->sink) ? -1 : (i > net->sink ? i - 1 : i);
+    j = (j == net->sink) ? -1 : (j > net->sink ? j - 1 : j);
+    if ( i >= 0 ) T->val[T->row[i]] += g;
+    if ( j >= 0 ) T->val[T->row[j]] += g;
+    if ( i >= 0 && j >= 0 ) {
+      T->col[pos[i]] = j;
+      T->val[pos[i]++] = -g;
+      T->col[pos[j]] = i;
+      T->val[pos[j]++] = -g;
+    }
+  }
+  
+  /* Die Matrix ist symmetrisch: Durch Transponieren (zeilenweise verteilen)
+   * erhaelt man dieselbe Matrix mit aufsteigenden Spaltenindizes */
+  for (i = 0; i <= n; i++) {
+    A->row[i] = T->row[i];
+  }
+  for (i = 0; i < n; i++) {
+    pos[i] = A->row[i];
+  }
+  for (i = 0; i < n; i++) {
+    for (k = T->row[i]; k < T->row[i+1]; k++) {
+      j = T->col[k];
+      A->col[pos[j]] = i;
+      A->val[pos[j]++] = T->val[k];
+    }
+  }
+  sparse_free(T);
+  free(pos);
+  
+  /* Parallele Widerstaende zu einem Element zusammenfassen */
+  nnz = 0;
+  start = 0;
+  for (i = 0; i < n; i++) {
+    end = A->row[i+1];
+    A->row[i] = nnz;
+    for (k = start; k < end; k++) {
+      if ( nnz > A->row[i] && A->col[nnz-1] == A->col[k] ) {
+        A->val[nnz-1] += A->val[k];
+      } else {
+        A->col[nnz] = A->col[k];
+        A->val[nnz++] = A->val[k];
+      }
+    }
+    start = end;
+  }
+  A->row[n] = nnz;
+  A->nnz = nnz;
+  
+  return A;
+}
+
+int netlist_resistance(NETLIST *net, double tol, double *R_E) {
+  int i, ret;
+  int n = net->nodes - 1;
+  int source = (net->source > net->sink) ? net->source - 1 : net->source;
+  SPARSE_MATRIX *A = netlist_system(net);
+  VECTOR *b = vector_alloc(n);
+  VECTOR *x = vector_alloc(n);
+  
+  if ( A == NULL || b == NULL || x == NULL ) {
+    ret = -3;
+  } else {
+    /* Strom von 1A bei "source", Startwert 0 */
+    for (i = 0; i < n; i++) {
+      b->elem[i] = 0;
+      x->elem[i] = 0;
+    }
+    b->elem[source] = 1;
+  
+    ret = sparse_cg(A, b, x, tol, 10 * n + 100);
+    if ( ret >= 0 ) *R_E = x->elem[source];
+  }
+  
+  if ( A != NULL ) sparse_free(A);
+  if ( b != NULL ) vector_free(b);
+  if ( x != NULL ) vector_free(x);
+  
+  return ret;
+}
@@ -0,0 +1,59 @@
+#ifndef _NETLIST_H_
+#define _NETLIST_H_
+
+#include "numerik_bespin_deutsch_sparse.h"
+
+/* Beliebiges Widerstandsnetzwerk aus einer Netzliste
+ *
+ * Format der Datei (Zeilen mit '#' am Anfang und Leerzeilen werden
+ * ignoriert):
+ *   source <Knoten>
+ *   sink <Knoten>
+ *   <Knoten> <Knoten> <Widerstand in Ohm>
+ *   ...
+ * Die Knoten sind mit 0, 1, 2, ... nummeriert, jede weitere Zeile ist ein
+ * Widerstand zwischen zwei Knoten (mehrere Widerstaende zwischen denselben
+ * Knoten sind parallel geschaltet). Gesucht ist der Ersatzwiderstand zwischen
+ * "source" und "sink".
+ *
+ * nodes: Anzahl der Knoten (groesster Index + 1)
+ * edges: Anzahl der Widerstaende
+ * from, to, R: Knoten und Wert des Widerstands i */
+typedef struct {
+  int nodes;
+  int edges;
+  int source;
+  int sink;
+  int *from;
+  int *to;
+  double *R;
+} NETLIST;
+
+/* Liest die Netzliste aus der Datei "filename". Bei Fehlern wird NULL
+ * zurueckgegeben und in "line" die fehlerhafte Zeile gespeichert (0, wenn die
+ * Datei nicht geoeffnet werden konnte, Source oder Sink fehlen oder die
+ * Allokierung fehlschlug). */
+NETLIST *netlist_read(char *filename, int *line);
+
+/* Gibt den Speicher der Netzliste wieder frei */
+void netlist_free(NETLIST *net);
+
+/* Stellt das Gleichungssystem der Knotenanalyse auf: Unbekannte sind die
+ * Potentiale aller Knoten ausser "sink" (Potential 0), Knoten k > sink hat
+ * den Index k - 1. Die Matrix ist die Summe der Leitwerte 1/R der
+ * angeschlossenen Widerstaende auf der Diagonalen und -1/R fuer jedes Paar
+ * verbundener Knoten. Fliesst 1A bei "source" hinein, ist das Potential von
+ * "source" der Ersatzwiderstand. Bei fehlgeschlagener Allokierung wird NULL
+ * zurueckgegeben. */
+SPARSE_MATRIX *netlist_system(NETLIST *net);
+
+/* Berechnet den Ersatzwiderstand des Netzwerks (relative Genauigkeit tol)
+ * und speichert ihn in "R_E".
+ *
+ * Rueckgabewert:
+ * >= 0: Anzahl der Iterationen des CG-Verfahrens
+ * -2: keine Konvergenz (z.B. Source und Sink nicht verbunden)
+ * -3: Fehler bei der Allokierung */
+int netlist_resistance(NETLIST *net, double tol, double *R_E);
+
+#endif
@@ -0,0 +1,130 @@
+#include "numerik_bespin_deutsch_sparse.h"
+#include <stdlib.h>
+
+SPARSE_MATRIX *sparse_alloc(int n, int nnz) {
+  SPARSE_MATRIX *ret;
+  
+  if ( NULL == (ret = malloc(sizeof(SPARSE_MATRIX))) ) {
+    return NULL;
+  }
+  ret->n = n;
+  ret->nnz = nnz;
+  ret->row = malloc((n + 1) * sizeof(int));
+  ret->col = malloc(nnz * sizeof(int));
+  ret->val = malloc(nnz * sizeof(double));
+  if ( ret->row == NULL || ret->col == NULL || ret->val == NULL ) {
+    sparse_free(ret);
+    return NULL;
+  }
+  
+  return ret;
+}
+
+void sparse_free(SPARSE_MATRIX *A) {
+  free(A->row);
+  free(A->col);
+  free(A->val);
+  free(A);
+}
+
+void sparse_mul(SPARSE_MATRIX *A, const double *x, double *y) {
+  int i, k;
+  double sum;
+  
+  #pragma omp parallel for private(k, sum) schedule(static) \
+    if (A->n >= SPARSE_PARALLEL_MIN)
+  for (i = 0; i < A->n; i++) {
+    sum = 0;
+    for (k = A->row[i]; k < A->row[i+1]; k++) {
+      sum += A->val[k] * x[A->col[k]];
+    }
+    y[i] = sum;
+  }
+}
+
+int sparse_cg(SPARSE_MATRIX *A, VECTOR *b, VECTOR *x, double tol,
+              int max_iter) {
+  int i, k, iter;
+  int n = A->n;
+  double alpha, beta, rz, rz_new, pq, rr, bb;
+  /* Residuum r, vorkonditioniertes Residuum z, Suchrichtung p, q = A p und
+   * inverse Diagonale d in einem Block */
+  double *r, *z, *p, *q, *d;
+  
+  if ( b->n != n || x->n != n ) return -1;
+  
+  if ( NULL == (r = malloc(5 * (size_t)n * sizeof(double))) ) {
+    return -3;
+  }
+  z = r + n;
+  p = z + n;
+  q = p + n;
+  d = q + n;
+  
+  /* Inverse Diagonale (Zeilen ohne Diagonalelement bleiben unveraendert) */
+  for (i = 0; i < n; i++) {
+    d[i] = 1;
+    for (k = A->row[i]; k < A->row[i+1]; k++) {
+      if ( A->col[k] == i && A->val[k] != 0 ) d[i] = 1 / A->val[k];
+    }
+  }
+  
+  sparse_mul(A, x->elem, q);
+  rz = 0;
+  rr = 0;
+  bb = 0;
+  #pragma omp parallel for reduction(+:rz, rr, bb) schedule(static) \
+    if (n >= SPARSE_PARALLEL_MIN)
+  for (i = 0; i < n; i++) {
+    r[i] = b->elem[i] - q[i];
+    z[i] = d[i] * r[i];
+    p[i] = z[i];
+    rz += r[i] * z[i];
+    rr += r[i] * r[i];
+    bb += b->elem[i] * b->elem[i];
+  }
+  
+  for (iter = 0; rr > tol * tol * bb; iter++) {
+    if ( iter == max_iter ) {
+      free(r);
+      return -2;
+    }
+  
+    sparse_mul(A, p, q);
+    pq = 0;
+    #pragma omp parallel for reduction(+:pq) schedule(static) \
+      if (n >= SPARSE_PARALLEL_MIN)
+    for (i = 0; i < n; i++) {
+      pq += p[i] * q[i];
+    }
+    /* Nur fuer singulaere (nicht positiv definite) Matrizen */
+    if ( !(pq > 0) ) {
+      free(r);
+      return -2;
+    }
+    alpha = rz / pq;
+  
+    rz_new = 0;
+    rr = 0;
+    #pragma omp parallel for reduction(+:rz_new, rr) schedule(static) \
+      if (n >= SPARSE_PARALLEL_MIN)
+    for (i = 0; i < n; i++) {
+      x->elem[i] += alpha * p[i];
+      r[i] -= alpha * q[i];
+      z[i] = d[i] * r[i];
+      rz_new += r[i] * z[i];
+      rr += r[i] * r[i];
+    }
+  
+    beta = rz_new / rz;
+    rz = rz_new;
+    #pragma omp parallel for schedule(static) if (n >= SPARSE_PARALLEL_MIN)
+    for (i = 0; i < n; i++) {
+      p[i] = z[i] + beta * p[i];
+    }
+  }
+  
+  free(r);
+  
+  return iter;
+}
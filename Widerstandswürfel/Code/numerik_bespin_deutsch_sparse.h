@@ -0,0 +1,47 @@
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include "numerik_bespin_deutsch_linalg.h"
+
+/* Duenn besetzte (n x n)-Matrix im CSR-Format
+ * nnz: Anzahl der gespeicherten Elemente
+ * row: Die Elemente der Zeile i stehen an den Positionen row[i], ...,
+ *      row[i+1] - 1 von "col" und "val" (n + 1 Eintraege)
+ * col: Spaltenindizes (je Zeile aufsteigend)
+ * val: Werte der Elemente */
+typedef struct {
+  int n;
+  int nnz;
+  int *row;
+  int *col;
+  double *val;
+} SPARSE_MATRIX;
+
+/* Ab dieser Dimension werden Matrix-Vektor-Produkt und Skalarprodukte des
+ * CG-Verfahrens mit OpenMP (falls aktiviert) auf mehrere Threads verteilt */
+#define SPARSE_PARALLEL_MIN 10000
+
+/* Allokiert eine (n x n)-Matrix mit Platz fuer nnz Elemente; bei
+ * fehlgeschlagener Allokierung wird NULL zurueckgegeben */
+SPARSE_MATRIX *sparse_alloc(int n, int nnz);
+
+/* Gibt den Speicher der Matrix wieder frei */
+void sparse_free(SPARSE_MATRIX *A);
+
+/* Berechnet y = A x */
+void sparse_mul(SPARSE_MATRIX *A, const double *x, double *y);
+
+/* Loest Ax = b fuer symmetrisch positiv definites A mit dem Verfahren der
+ * konjugierten Gradienten (vorkonditioniert mit der Diagonalen von A).
+ * "x" enthaelt zu Beginn den Startwert. Es wird iteriert, bis das Residuum
+ * |b - Ax| hoechstens tol * |b| ist.
+ *
+ * Rueckgabewert:
+ * >= 0: Anzahl der Iterationen
+ * -1: Dimensionskonflikt zwischen A, b und x
+ * -2: keine Konvergenz nach max_iter Iterationen (oder A ist singulaer)
+ * -3: Fehler bei der Allokierung */
+int sparse_cg(SPARSE_MATRIX *A, VECTOR *b, VECTOR *x, double tol,
+              int max_iter);
+
+#endif